@@ -0,0 +1,230 @@
+// agg.c
+#include <stddef.h>
+#include "agg.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AGG_X86 1
+#include <immintrin.h>
+#define AGG_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+static const char* const isa_names[AGG_ISA_COUNT] = { "标量", "SSE4.2", "AVX2" };
+
+const char* agg_isa_name(int isa) {
+    return (isa >= 0 && isa < AGG_ISA_COUNT) ? isa_names[isa] : "?";
+}
+
+// === 标量版本（所有平台）===
+static void day_range_scalar(const int32_t* day, long n, int32_t* min_day, int32_t* max_day) {
+    int32_t lo = day[0], hi = day[0];
+    for (long i = 1; i < n; i++) {
+        if (day[i] < lo) lo = day[i];
+        if (day[i] > hi) hi = day[i];
+    }
+    *min_day = lo;
+    *max_day = hi;
+}
+
+static void sum_by_day_bucket_scalar(const int32_t* day, const int64_t* cents, const uint8_t* type, long n,
+                                     int32_t min_day, const int32_t* bucket_of, int64_t* sums) {
+    for (long i = 0; i < n; i++) {
+        sums[bucket_of[day[i] - min_day] * 2 + type[i]] += cents[i];
+    }
+}
+
+static void sum_by_key16_scalar(const uint16_t* key, const int64_t* cents, const uint8_t* type, long n,
+                                int64_t* sums) {
+    for (long i = 0; i < n; i++) {
+        sums[key[i] * 2 + type[i]] += cents[i];
+    }
+}
+
+#ifdef AGG_X86
+// 向量部分算出桶号（分支与查表都在寄存器里完成），累加仍逐行写回：
+// x86 到 AVX2 为止没有 scatter，求和表很小且常驻 L1，逐行加反而最快
+#define ACCUMULATE(lanes) do { \
+        for (int l = 0; l < (lanes); l++) sums[idx[l]] += cents[i + l]; \
+    } while (0)
+
+// === SSE4.2 ===
+AGG_TARGET("sse4.2")
+static void day_range_sse42(const int32_t* day, long n, int32_t* min_day, int32_t* max_day) {
+    __m128i vmin = _mm_set1_epi32(day[0]);
+    __m128i vmax = vmin;
+    long i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(day + i));
+        vmin = _mm_min_epi32(vmin, v);
+        vmax = _mm_max_epi32(vmax, v);
+    }
+    int32_t lo[4], hi[4];
+    _mm_storeu_si128((__m128i*)lo, vmin);
+    _mm_storeu_si128((__m128i*)hi, vmax);
+    for (int l = 1; l < 4; l++) {
+        if (lo[l] < lo[0]) lo[0] = lo[l];
+        if (hi[l] > hi[0]) hi[0] = hi[l];
+    }
+    for (; i < n; i++) {
+        if (day[i] < lo[0]) lo[0] = day[i];
+        if (day[i] > hi[0]) hi[0] = day[i];
+    }
+    *min_day = lo[0];
+    *max_day = hi[0];
+}
+
+AGG_TARGET("sse4.2")
+static void sum_by_day_bucket_sse42(const int32_t* day, const int64_t* cents, const uint8_t* type, long n,
+                                    int32_t min_day, const int32_t* bucket_of, int64_t* sums) {
+    const __m128i vmin = _mm_set1_epi32(min_day);
+    int32_t off[4], idx[4];
+    long i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(day + i)), vmin);
+        _mm_storeu_si128((__m128i*)off, d);
+        __m128i b = _mm_set_epi32(bucket_of[off[3]], bucket_of[off[2]], bucket_of[off[1]], bucket_of[off[0]]);
+        int32_t t4;
+        __builtin_memcpy(&t4, type + i, 4);
+        __m128i t = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(t4));
+        _mm_storeu_si128((__m128i*)idx, _mm_add_epi32(_mm_slli_epi32(b, 1), t));
+        ACCUMULATE(4);
+    }
+    sum_by_day_bucket_scalar(day + i, cents + i, type + i, n - i, min_day, bucket_of, sums);
+}
+
+AGG_TARGET("sse4.2")
+static void sum_by_key16_sse42(const uint16_t* key, const int64_t* cents, const uint8_t* type, long n,
+                               int64_t* sums) {
+    int32_t idx[4];
+    long i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i k = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(key + i)));
+        int32_t t4;
+        __builtin_memcpy(&t4, type + i, 4);
+        __m128i t = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(t4));
+        _mm_storeu_si128((__m128i*)idx, _mm_add_epi32(_mm_slli_epi32(k, 1), t));
+        ACCUMULATE(4);
+    }
+    sum_by_key16_scalar(key + i, cents + i, type + i, n - i, sums);
+}
+
+// === AVX2 ===
+AGG_TARGET("avx2")
+static void day_range_avx2(const int32_t* day, long n, int32_t* min_day, int32_t* max_day) {
+    __m256i vmin = _mm256_set1_epi32(day[0]);
+    __m256i vmax = vmin;
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(day + i));
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+    }
+    int32_t lo[8], hi[8];
+    _mm256_storeu_si256((__m256i*)lo, vmin);
+    _mm256_storeu_si256((__m256i*)hi, vmax);
+    for (int l = 1; l < 8; l++) {
+        if (lo[l] < lo[0]) lo[0] = lo[l];
+        if (hi[l] > hi[0]) hi[0] = hi[l];
+    }
+    for (; i < n; i++) {
+        if (day[i] < lo[0]) lo[0] = day[i];
+        if (day[i] > hi[0]) hi[0] = day[i];
+    }
+    *min_day = lo[0];
+    *max_day = hi[0];
+}
+
+AGG_TARGET("avx2")
+static void sum_by_day_bucket_avx2(const int32_t* day, const int64_t* cents, const uint8_t* type, long n,
+                                   int32_t min_day, const int32_t* bucket_of, int64_t* sums) {
+    const __m256i vmin = _mm256_set1_epi32(min_day);
+    int32_t idx[8];
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i d = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(day + i)), vmin);
+        __m256i b = _mm256_i32gather_epi32((const int*)bucket_of, d, 4);
+        __m256i t = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(type + i)));
+        _mm256_storeu_si256((__m256i*)idx, _mm256_add_epi32(_mm256_slli_epi32(b, 1), t));
+        ACCUMULATE(8);
+    }
+    sum_by_day_bucket_scalar(day + i, cents + i, type + i, n - i, min_day, bucket_of, sums);
+}
+
+AGG_TARGET("avx2")
+static void sum_by_key16_avx2(const uint16_t* key, const int64_t* cents, const uint8_t* type, long n,
+                              int64_t* sums) {
+    int32_t idx[8];
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i k = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(key + i)));
+        __m256i t = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(type + i)));
+        _mm256_storeu_si256((__m256i*)idx, _mm256_add_epi32(_mm256_slli_epi32(k, 1), t));
+        ACCUMULATE(8);
+    }
+    sum_by_key16_scalar(key + i, cents + i, type + i, n - i, sums);
+}
+#endif
+
+// === 运行时分派 ===
+typedef struct {
+    void (*day_range)(const int32_t*, long, int32_t*, int32_t*);
+    void (*sum_by_day_bucket)(const int32_t*, const int64_t*, const uint8_t*, long,
+                              int32_t, const int32_t*, int64_t*);
+    void (*sum_by_key16)(const uint16_t*, const int64_t*, const uint8_t*, long, int64_t*);
+} AggKernels;
+
+static const AggKernels kernels[AGG_ISA_COUNT] = {
+    { day_range_scalar, sum_by_day_bucket_scalar, sum_by_key16_scalar },
+#ifdef AGG_X86
+    { day_range_sse42, sum_by_day_bucket_sse42, sum_by_key16_sse42 },
+    { day_range_avx2, sum_by_day_bucket_avx2, sum_by_key16_avx2 },
+#else
+    { day_range_scalar, sum_by_day_bucket_scalar, sum_by_key16_scalar },
+    { day_range_scalar, sum_by_day_bucket_scalar, sum_by_key16_scalar },
+#endif
+};
+
+static int current_isa = -1;
+
+int agg_isa_supported(int isa) {
+    switch (isa) {
+    case AGG_ISA_SCALAR: return 1;
+#ifdef AGG_X86
+    case AGG_ISA_SSE42: return __builtin_cpu_supports("sse4.2");
+    case AGG_ISA_AVX2:  return __builtin_cpu_supports("avx2");
+#endif
+    default: return 0;
+    }
+}
+
+int agg_isa_current(void) {
+    if (current_isa < 0) {
+        current_isa = AGG_ISA_SCALAR;
+        for (int isa = AGG_ISA_COUNT - 1; isa > AGG_ISA_SCALAR; isa--) {
+            if (agg_isa_supported(isa)) {
+                current_isa = isa;
+                break;
+            }
+        }
+    }
+    return current_isa;
+}
+
+int agg_isa_set(int isa) {
+    if (!agg_isa_supported(isa)) return 0;
+    current_isa = isa;
+    return 1;
+}
+
+void agg_day_range(const int32_t* day, long n, int32_t* min_day, int32_t* max_day) {
+    kernels[agg_isa_current()].day_range(day, n, min_day, max_day);
+}
+
+void agg_sum_by_day_bucket(const int32_t* day, const int64_t* cents, const uint8_t* type, long n,
+                           int32_t min_day, const int32_t* bucket_of, int64_t* sums) {
+    kernels[agg_isa_current()].sum_by_day_bucket(day, cents, type, n, min_day, bucket_of, sums);
+}
+
+void agg_sum_by_key16(const uint16_t* key, const int64_t* cents, const uint8_t* type, long n,
+                      int64_t* sums) {
+    kernels[agg_isa_current()].sum_by_key16(key, cents, type, n, sums);
+}
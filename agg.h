@@ -0,0 +1,29 @@
+// agg.h
+#ifndef AGG_H
+#define AGG_H
+
+#include <stdint.h>
+
+// 报表聚合内核：在连续的 day/cents/type 数组上一趟完成按桶的收支求和。
+// 运行时检测 CPU，选用 AVX2 / SSE4.2 实现，其余平台走标量版本；三者结果完全一致。
+#define AGG_ISA_SCALAR 0
+#define AGG_ISA_SSE42  1
+#define AGG_ISA_AVX2   2
+#define AGG_ISA_COUNT  3
+
+const char* agg_isa_name(int isa);
+int agg_isa_supported(int isa);
+int agg_isa_current(void);
+// 指定实现（基准测试用）；不支持时返回 0 且不改变
+int agg_isa_set(int isa);
+
+// 天数最小/最大值（n > 0）
+void agg_day_range(const int32_t* day, long n, int32_t* min_day, int32_t* max_day);
+// sums[bucket_of[day[i] - min_day] * 2 + type[i]] += cents[i]
+void agg_sum_by_day_bucket(const int32_t* day, const int64_t* cents, const uint8_t* type, long n,
+                           int32_t min_day, const int32_t* bucket_of, int64_t* sums);
+// sums[key[i] * 2 + type[i]] += cents[i]（按分类等 uint16 id 分桶）
+void agg_sum_by_key16(const uint16_t* key, const int64_t* cents, const uint8_t* type, long n,
+                      int64_t* sums);
+
+#endif
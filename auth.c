@@ -7,7 +7,9 @@
 #include "auth.h"
 #include "sha256.h"
 #include "sqlite3.h"
-#define DATABASE_NAME "finance.db"
+#include "db.h"
+#include "schema.h"
+#include "kdf.h"
 
 // 辅助：隐藏密码输入（Windows）
 #ifdef _WIN32
@@ -36,27 +38,44 @@ char* getpass(const char* prompt) {
 // Linux/macOS 使用系统 getpass
 #endif
 
-// 生成随机盐（简单版）
+// 生成随机盐：16 个字母数字（约 95 位），取自系统安全随机数
 void generate_salt(char salt[17]) {
-    srand((unsigned int)time(NULL) ^ (unsigned int)getpid());
-    const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-    for (int i = 0; i < 16; i++) {
-        salt[i] = chars[rand() % (sizeof(chars) - 1)];
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    const int n = (int)sizeof(chars) - 1;
+    int filled = 0;
+    uint8_t random[64];
+    while (filled < 16 && kdf_random_bytes(random, sizeof(random))) {
+        for (size_t i = 0; i < sizeof(random) && filled < 16; i++) {
+            // 拒绝采样：丢弃 >= 248 的字节，保证 62 个字符等概率
+            if (random[i] < 256 - 256 % n) salt[filled++] = chars[random[i] % n];
+        }
+    }
+    if (filled < 16) {
+        fprintf(stderr, "⚠️ 无法读取系统随机数，盐改用时间种子生成\n");
+        srand((unsigned int)time(NULL) ^ (unsigned int)getpid());
+        while (filled < 16) salt[filled++] = chars[rand() % n];
     }
     salt[16] = '\0';
 }
 
-// 哈希密码 = SHA256(密码 + 盐)
-void hash_password(const char* password, const char* salt, char hash_hex[65]) {
+// 哈希密码：iterations > 0 时为 PBKDF2-HMAC-SHA256(密码, 盐, iterations)，
+// 0 为旧版 SHA256(密码 + 盐)（仅用于验证升级前保存的哈希）
+void hash_password(const char* password, const char* salt, uint32_t iterations, char hash_hex[65]) {
     if (!password || !salt) {
         memset(hash_hex, 0, 65);
         return;
     }
-    char combined[256];
-    snprintf(combined, sizeof(combined), "%s%s", password, salt);
 
     uint8_t hash[32];
-    sha256((uint8_t*)combined, strlen(combined), hash);
+    if (iterations > 0) {
+        pbkdf2_hmac_sha256((const uint8_t*)password, strlen(password),
+                           (const uint8_t*)salt, strlen(salt), iterations, hash, sizeof(hash));
+    } else {
+        char combined[256];
+        snprintf(combined, sizeof(combined), "%s%s", password, salt);
+        sha256((uint8_t*)combined, strlen(combined), hash);
+        memset(combined, 0, sizeof(combined));
+    }
 
     for (int i = 0; i < 32; i++) {
         sprintf(hash_hex + (i * 2), "%02x", hash[i]);
@@ -64,30 +83,54 @@ void hash_password(const char* password, const char* salt, char hash_hex[65]) {
     hash_hex[64] = '\0';
 }
 
+// 新哈希使用的迭代次数（可在“系统设置 → 密码强度校准”中按本机速度调整）
+uint32_t auth_kdf_iterations(void) {
+    int iterations = db_get_setting_int("kdf_iterations", KDF_DEFAULT_ITERATIONS);
+    if (iterations < KDF_MIN_ITERATIONS) return KDF_MIN_ITERATIONS;
+    if (iterations > KDF_MAX_ITERATIONS) return KDF_MAX_ITERATIONS;
+    return (uint32_t)iterations;
+}
+
+// 以新盐和当前迭代次数保存密码（首次设置、修改密码、登录时升级共用）
+int auth_set_password(sqlite3* db, const char* password) {
+    char salt[17];
+    generate_salt(salt);
+    uint32_t iterations = auth_kdf_iterations();
+    char hash_hex[65];
+    hash_password(password, salt, iterations, hash_hex);
+
+    sqlite3_stmt* stmt = db_prepare(db,
+        "INSERT INTO admin (id, password_hash, salt, iterations) VALUES (1, ?, ?, ?) "
+        "ON CONFLICT(id) DO UPDATE SET password_hash = excluded.password_hash, "
+        "  salt = excluded.salt, iterations = excluded.iterations;");
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, hash_hex, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, salt, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, iterations);
+    int ok = (sqlite3_step(stmt) == SQLITE_DONE);
+    if (!ok) fprintf(stderr, "❌ 保存密码失败: %s\n", sqlite3_errmsg(db));
+    db_release(stmt);
+    return ok;
+}
+
 // 初始化认证所需表（仅 admin）
 void init_auth_database(sqlite3* db) {
     if (!db) return;
 
-    const char* create_admin_sql = 
-        "CREATE TABLE IF NOT EXISTS admin ("
-        "  id INTEGER PRIMARY KEY CHECK (id = 1), "
-        "  password_hash TEXT NOT NULL, "
-        "  salt TEXT NOT NULL"
-        ");";
-    sqlite3_exec(db, create_admin_sql, NULL, NULL, NULL);
+    // admin 表属于基础表，随表结构升级创建（已是最新时只读一次 user_version）
+    schema_migrate(db);
 }
 
 // 检查是否首次运行（admin 表为空）
 static int is_first_run(sqlite3* db) {
     int count = 0;
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM admin;", -1, &stmt, NULL);
-    if (rc != SQLITE_OK) return 1; // 视为首次（保守）
+    sqlite3_stmt* stmt = db_prepare(db, "SELECT COUNT(*) FROM admin;");
+    if (!stmt) return 1; // 视为首次（保守）
 
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         count = sqlite3_column_int(stmt, 0);
     }
-    sqlite3_finalize(stmt);
+    db_release(stmt);
     return (count == 0);
 }
 
@@ -100,27 +143,9 @@ static void setup_initial_password(sqlite3* db) {
         return;
     }
 
-    char salt[17];
-    generate_salt(salt);
-    char hash_hex[65];
-    hash_password(pwd, salt, hash_hex);
-
-    const char* sql = "INSERT INTO admin (id, password_hash, salt) VALUES (1, ?, ?);";
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "❌ 准备插入语句失败\n");
-        return;
-    }
-    sqlite3_bind_text(stmt, 1, hash_hex, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, salt, -1, SQLITE_STATIC);
-    rc = sqlite3_step(stmt);
-    if (rc == SQLITE_DONE) {
+    if (auth_set_password(db, pwd)) {
         printf("✅ 管理员密码设置成功！\n");
-    } else {
-        fprintf(stderr, "❌ 插入密码失败: %s\n", sqlite3_errmsg(db));
     }
-    sqlite3_finalize(stmt);
 
     // 安全清零（仅 Windows，因使用静态缓冲区）
 #ifdef _WIN32
@@ -132,20 +157,31 @@ static void setup_initial_password(sqlite3* db) {
 int authenticate_user(sqlite3* db, const char* input_pwd) {
     if (!db || !input_pwd) return 0;
 
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, "SELECT password_hash, salt FROM admin WHERE id = 1;", -1, &stmt, NULL);
-    if (rc != SQLITE_OK || sqlite3_step(stmt) != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
+    sqlite3_stmt* stmt = db_prepare(db, "SELECT password_hash, salt, iterations FROM admin WHERE id = 1;");
+    if (!stmt || sqlite3_step(stmt) != SQLITE_ROW) {
+        db_release(stmt);
         return 0;
     }
     const char* stored_hash = (const char*)sqlite3_column_text(stmt, 0);
     const char* salt = (const char*)sqlite3_column_text(stmt, 1);
+    int64_t iterations = sqlite3_column_int64(stmt, 2);
 
     char input_hash[65];
-    hash_password(input_pwd, salt, input_hash);
+    hash_password(input_pwd, salt, (uint32_t)iterations, input_hash);
+
+    // 逐字节累积差异，比较耗时与第几位不同无关
+    int result = 0;
+    if (stored_hash && strlen(stored_hash) == 64) {
+        unsigned char diff = 0;
+        for (int i = 0; i < 64; i++) diff |= (unsigned char)(stored_hash[i] ^ input_hash[i]);
+        result = (diff == 0);
+    }
+    db_release(stmt);
 
-    int result = (stored_hash && strcmp(stored_hash, input_hash) == 0);
-    sqlite3_finalize(stmt);
+    // 旧版 SHA256 哈希或迭代次数与当前设置不同（校准后）：验证通过后用明文口令透明重新哈希
+    if (result && iterations != auth_kdf_iterations()) {
+        auth_set_password(db, input_pwd);
+    }
 
     // 安全清零（仅 Windows）
 #ifdef _WIN32
@@ -157,11 +193,11 @@ int authenticate_user(sqlite3* db, const char* input_pwd) {
     return result;
 }
 
-// 主入口：登录或初始化
+// 主入口：登录或初始化（使用 main 中已打开的共享连接）
 int login_at_startup(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        fprintf(stderr, "❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
+    sqlite3* db = db_get();
+    if (!db) {
+        fprintf(stderr, "❌ 数据库未打开\n");
         return 0;
     }
 
@@ -169,19 +205,35 @@ int login_at_startup(void) {
 
     if (is_first_run(db)) {
         setup_initial_password(db);
-        sqlite3_close(db);
         return 1;
     } else {
         int attempts = 3;
         while (attempts-- > 0) {
             char* pwd = getpass("请输入管理员密码: ");
             if (authenticate_user(db, pwd)) {
-                sqlite3_close(db);
                 return 1;
             }
             printf("❌ 密码错误！剩余 %d 次机会。\n", attempts);
         }
-        sqlite3_close(db);
         return 0;
     }
-}
\ No newline at end of file
+}
+// 非交互登录（命令行模式）：密码由调用方提供，未设置过密码时直接失败
+int login_noninteractive(const char* password) {
+    sqlite3* db = db_get();
+    if (!db) {
+        fprintf(stderr, "❌ 数据库未打开\n");
+        return 0;
+    }
+
+    init_auth_database(db);
+    if (is_first_run(db)) {
+        fprintf(stderr, "❌ 尚未设置管理员密码，请先以交互模式运行一次。\n");
+        return 0;
+    }
+    if (!authenticate_user(db, password)) {
+        fprintf(stderr, "❌ 密码错误！\n");
+        return 0;
+    }
+    return 1;
+}
@@ -2,6 +2,7 @@
 #ifndef AUTH_H
 #define AUTH_H
 
+#include <stdint.h>
 #include "sqlite3.h"
 
 // 跨平台 getpass 声明
@@ -13,8 +14,12 @@ char* getpass(const char* prompt);  // ← 声明 Windows 自实现版本
 
 void init_auth_database(sqlite3* db);
 int login_at_startup(void);
+int login_noninteractive(const char* password);
 void generate_salt(char salt[17]);
-void hash_password(const char* password, const char* salt, char hash_hex[65]);
+void hash_password(const char* password, const char* salt, uint32_t iterations, char hash_hex[65]);
+uint32_t auth_kdf_iterations(void);
+int auth_set_password(sqlite3* db, const char* password);
+// 验证通过时，若保存的是旧版哈希或迭代次数与当前设置不同，顺带按当前设置重新哈希
 int authenticate_user(sqlite3* db, const char* input_password);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,391 @@
+// balance.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "money.h"
+#include "date.h"
+#include "balance.h"
+
+// 检查点表结构或触发器变化时递增，启动时自动重建检查点
+#define BALANCE_VERSION 1
+
+// 记录对账户余额的影响：收入为正、支出为负
+#define SIGNED_AMOUNT(row) "CASE WHEN " row ".type = 'income' THEN " row ".amount ELSE -" row ".amount END"
+
+static const char* const balance_schema_sql =
+    "CREATE TABLE IF NOT EXISTS balance_checkpoints ("
+    "  account_id INTEGER NOT NULL,"
+    "  month TEXT NOT NULL,"                 // 'YYYY-MM'
+    "  delta INTEGER NOT NULL DEFAULT 0,"    // 当月收支净额（分）
+    "  cnt INTEGER NOT NULL DEFAULT 0,"
+    "  PRIMARY KEY (account_id, month)"
+    ") WITHOUT ROWID;"
+
+    "CREATE TRIGGER IF NOT EXISTS trg_balance_records_insert AFTER INSERT ON records BEGIN "
+    "  INSERT INTO balance_checkpoints (account_id, month, delta, cnt) "
+    "    VALUES (NEW.account_id, substr(NEW.date, 1, 7), " SIGNED_AMOUNT("NEW") ", 1) "
+    "    ON CONFLICT(account_id, month) DO UPDATE SET delta = delta + excluded.delta, cnt = cnt + 1;"
+    "END;"
+
+    "CREATE TRIGGER IF NOT EXISTS trg_balance_records_delete AFTER DELETE ON records BEGIN "
+    "  UPDATE balance_checkpoints SET delta = delta - (" SIGNED_AMOUNT("OLD") "), cnt = cnt - 1 "
+    "    WHERE account_id = OLD.account_id AND month = substr(OLD.date, 1, 7);"
+    "  DELETE FROM balance_checkpoints "
+    "    WHERE account_id = OLD.account_id AND month = substr(OLD.date, 1, 7) AND cnt <= 0;"
+    "END;"
+
+    "CREATE TRIGGER IF NOT EXISTS trg_balance_records_update "
+    "AFTER UPDATE OF date, type, amount, account_id ON records BEGIN "
+    "  UPDATE balance_checkpoints SET delta = delta - (" SIGNED_AMOUNT("OLD") "), cnt = cnt - 1 "
+    "    WHERE account_id = OLD.account_id AND month = substr(OLD.date, 1, 7);"
+    "  DELETE FROM balance_checkpoints "
+    "    WHERE account_id = OLD.account_id AND month = substr(OLD.date, 1, 7) AND cnt <= 0;"
+    "  INSERT INTO balance_checkpoints (account_id, month, delta, cnt) "
+    "    VALUES (NEW.account_id, substr(NEW.date, 1, 7), " SIGNED_AMOUNT("NEW") ", 1) "
+    "    ON CONFLICT(account_id, month) DO UPDATE SET delta = delta + excluded.delta, cnt = cnt + 1;"
+    "END;";
+
+static const char* const balance_drop_triggers_sql =
+    "DROP TRIGGER IF EXISTS trg_balance_records_insert;"
+    "DROP TRIGGER IF EXISTS trg_balance_records_delete;"
+    "DROP TRIGGER IF EXISTS trg_balance_records_update;";
+
+// 账户 × 月份分组扫描（核对与重建共用，按主键顺序输出）
+#define GROUPED_RECORDS_SQL \
+    "SELECT account_id, substr(date, 1, 7), SUM(" SIGNED_AMOUNT("records") "), COUNT(*) " \
+    "FROM records GROUP BY 1, 2 ORDER BY 1, 2"
+
+void init_balance_ledger(sqlite3* db) {
+    if (!db || db_get_setting_int("balance_version", 0) == BALANCE_VERSION) return;
+
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = (sqlite3_exec(db, balance_drop_triggers_sql, NULL, NULL, NULL) == SQLITE_OK
+           && sqlite3_exec(db, "DROP TABLE IF EXISTS balance_checkpoints;", NULL, NULL, NULL) == SQLITE_OK);
+    if (ok && sqlite3_exec(db, balance_schema_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "❌ 创建余额检查点失败: %s\n", sqlite3_errmsg(db));
+        ok = 0;
+    }
+    if (ok && sqlite3_exec(db,
+            "INSERT INTO balance_checkpoints (account_id, month, delta, cnt) " GROUPED_RECORDS_SQL ";",
+            NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "❌ 重建余额检查点失败: %s\n", sqlite3_errmsg(db));
+        ok = 0;
+    }
+    if (ok) ok = db_set_setting_int("balance_version", BALANCE_VERSION);
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+}
+
+int suspend_balance_ledger(sqlite3* db) {
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = (sqlite3_exec(db, balance_drop_triggers_sql, NULL, NULL, NULL) == SQLITE_OK
+           && sqlite3_exec(db, "DELETE FROM app_settings WHERE key = 'balance_version';",
+                           NULL, NULL, NULL) == SQLITE_OK);
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+    return ok;
+}
+
+static void format_today(char* out, size_t size) {
+    time_t now = time(NULL);
+    strftime(out, size, "%Y-%m-%d", localtime(&now));
+}
+
+// === 按日期查询余额 ===
+// 之前各月走检查点主键，当月剩余部分走 idx_records_account_date
+int balance_as_of(const char* date, BalanceRowFn fn, void* ctx, FILE* err) {
+    if (!err) err = stderr;
+    char today[DATE_TEXT_LEN + 1];
+    if (!date) {
+        format_today(today, sizeof(today));
+        date = today;
+    }
+    sqlite3* db = db_get();
+    if (!db) return 0;
+    if (!date_is_valid(date)) {
+        fprintf(err, "❌ 日期无效: %s（应为 YYYY-MM-DD）\n", date);
+        return 0;
+    }
+
+    sqlite3_stmt* stmt = db_prepare(db,
+        "SELECT a.name, a.opening_balance"
+        "  + COALESCE((SELECT SUM(c.delta) FROM balance_checkpoints c "
+        "              WHERE c.account_id = a.id AND c.month < ?1), 0)"
+        "  + COALESCE((SELECT SUM(" SIGNED_AMOUNT("r") ") FROM records r "
+        "              WHERE r.account_id = a.id AND r.date BETWEEN ?2 AND ?3), 0) "
+        "FROM accounts a ORDER BY a.id;");
+    if (!stmt) {
+        fprintf(err, "❌ 查询失败: %s\n", sqlite3_errmsg(db));
+        return 0;
+    }
+    char month[8], month_start[DATE_TEXT_LEN + 1];
+    snprintf(month, sizeof(month), "%.7s", date);
+    snprintf(month_start, sizeof(month_start), "%.7s-01", date);
+    sqlite3_bind_text(stmt, 1, month, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, month_start, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, date, -1, SQLITE_STATIC);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        fn(ctx, (const char*)sqlite3_column_text(stmt, 0), sqlite3_column_int64(stmt, 1));
+    }
+    if (rc != SQLITE_DONE) fprintf(err, "❌ 查询失败: %s\n", sqlite3_errmsg(db));
+    db_release(stmt);
+    return rc == SQLITE_DONE;
+}
+
+// === 核对 ===
+typedef struct {
+    int account_id;
+    char month[8];
+    int64_t delta;
+    int64_t cnt;            // 0 表示应删除该检查点
+} MonthFix;
+
+typedef struct {
+    int account_id;
+    int64_t value;          // 重算净额 / 修正后的余额
+} AccountValue;
+
+// 简单的可增长数组
+#define PUSH(arr, count, cap, item) do { \
+        if ((count) == (cap)) { \
+            int new_cap = (cap) ? (cap) * 2 : 64; \
+            void* grown = realloc((arr), sizeof(*(arr)) * new_cap); \
+            if (!grown) { ok = 0; break; } \
+            (arr) = grown; \
+            (cap) = new_cap; \
+        } \
+        (arr)[(count)++] = (item); \
+    } while (0)
+
+static int compare_key(int a_account, const char* a_month, int b_account, const char* b_month) {
+    if (a_account != b_account) return a_account < b_account ? -1 : 1;
+    return strcmp(a_month, b_month);
+}
+
+// 取下一行；出错时清 ok，与结束一样返回 0
+static int next_row(sqlite3_stmt* stmt, int* ok) {
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) *ok = 0;
+    return rc == SQLITE_ROW;
+}
+
+static int apply_fixes(sqlite3* db, const MonthFix* months, int month_count,
+                       const AccountValue* balances, int balance_count, FILE* err) {
+    sqlite3_stmt* upsert = db_prepare(db,
+        "INSERT INTO balance_checkpoints (account_id, month, delta, cnt) VALUES (?, ?, ?, ?) "
+        "ON CONFLICT(account_id, month) DO UPDATE SET delta = excluded.delta, cnt = excluded.cnt;");
+    sqlite3_stmt* remove = db_prepare(db,
+        "DELETE FROM balance_checkpoints WHERE account_id = ? AND month = ?;");
+    sqlite3_stmt* update = db_prepare(db, "UPDATE accounts SET balance = ? WHERE id = ?;");
+    int ok = upsert && remove && update;
+
+    for (int i = 0; ok && i < month_count; i++) {
+        const MonthFix* f = &months[i];
+        sqlite3_stmt* stmt = f->cnt ? upsert : remove;
+        sqlite3_bind_int(stmt, 1, f->account_id);
+        sqlite3_bind_text(stmt, 2, f->month, -1, SQLITE_STATIC);
+        if (f->cnt) {
+            sqlite3_bind_int64(stmt, 3, f->delta);
+            sqlite3_bind_int64(stmt, 4, f->cnt);
+        }
+        ok = (sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_reset(stmt);
+    }
+    for (int i = 0; ok && i < balance_count; i++) {
+        sqlite3_bind_int64(update, 1, balances[i].value);
+        sqlite3_bind_int(update, 2, balances[i].account_id);
+        ok = (sqlite3_step(update) == SQLITE_DONE);
+        sqlite3_reset(update);
+    }
+    if (!ok) fprintf(err, "❌ 修复失败: %s\n", sqlite3_errmsg(db));
+    db_release(upsert);
+    db_release(remove);
+    db_release(update);
+    return ok;
+}
+
+int reconcile_balances(int repair, ReconcileRowFn fn, void* ctx, ReconcileStats* stats, FILE* err) {
+    if (!err) err = stderr;
+    memset(stats, 0, sizeof(*stats));
+    sqlite3* db = db_get();
+    if (!db) return 0;
+
+    MonthFix* month_fixes = NULL;
+    int month_fix_count = 0, month_fix_cap = 0;
+    AccountValue* sums = NULL;              // 各账户重算净额（按 id 升序）
+    int sum_count = 0, sum_cap = 0;
+    AccountValue* balance_fixes = NULL;
+    int balance_fix_count = 0, balance_fix_cap = 0;
+
+    // 读与修复在同一事务里，核对期间数据不会变化
+    sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL);
+
+    // 1. 分组扫描 records，与检查点按 (account_id, month) 归并比较
+    sqlite3_stmt* grouped = db_prepare(db, GROUPED_RECORDS_SQL ";");
+    sqlite3_stmt* stored = db_prepare(db,
+        "SELECT account_id, month, delta, cnt FROM balance_checkpoints ORDER BY account_id, month;");
+    int ok = grouped && stored;
+    int has_g = ok && next_row(grouped, &ok);
+    int has_s = ok && next_row(stored, &ok);
+    while (ok && (has_g || has_s)) {
+        MonthFix g = {0}, s = {0};
+        if (has_g) {
+            g.account_id = sqlite3_column_int(grouped, 0);
+            snprintf(g.month, sizeof(g.month), "%s", (const char*)sqlite3_column_text(grouped, 1));
+            g.delta = sqlite3_column_int64(grouped, 2);
+            g.cnt = sqlite3_column_int64(grouped, 3);
+        }
+        if (has_s) {
+            s.account_id = sqlite3_column_int(stored, 0);
+            snprintf(s.month, sizeof(s.month), "%s", (const char*)sqlite3_column_text(stored, 1));
+            s.delta = sqlite3_column_int64(stored, 2);
+            s.cnt = sqlite3_column_int64(stored, 3);
+        }
+        int cmp = !has_g ? 1 : !has_s ? -1 : compare_key(g.account_id, g.month, s.account_id, s.month);
+
+        if (cmp <= 0) {
+            stats->months++;
+            if (sum_count == 0 || sums[sum_count - 1].account_id != g.account_id) {
+                AccountValue v = { g.account_id, 0 };
+                PUSH(sums, sum_count, sum_cap, v);
+            }
+            if (ok) sums[sum_count - 1].value += g.delta;
+            if (cmp < 0 || g.delta != s.delta || g.cnt != s.cnt) {
+                PUSH(month_fixes, month_fix_count, month_fix_cap, g);      // 缺失或不一致
+            }
+            has_g = next_row(grouped, &ok);
+        } else {
+            s.cnt = 0;
+            PUSH(month_fixes, month_fix_count, month_fix_cap, s);          // 多余的检查点
+        }
+        if (cmp >= 0) has_s = next_row(stored, &ok);
+    }
+    db_release(grouped);
+    db_release(stored);
+    stats->months_fixed = month_fix_count;
+
+    // 2. 账面余额与 期初 + 重算净额 比较
+    sqlite3_stmt* accounts = ok ? db_prepare(db,
+        "SELECT id, name, balance, opening_balance FROM accounts ORDER BY id;") : NULL;
+    if (ok && !accounts) ok = 0;
+    int next = 0;
+    while (ok && next_row(accounts, &ok)) {
+        int id = sqlite3_column_int(accounts, 0);
+        int64_t balance = sqlite3_column_int64(accounts, 2);
+        int64_t computed = sqlite3_column_int64(accounts, 3);
+        while (next < sum_count && sums[next].account_id < id) next++;
+        if (next < sum_count && sums[next].account_id == id) computed += sums[next].value;
+
+        stats->accounts++;
+        if (fn) fn(ctx, (const char*)sqlite3_column_text(accounts, 1), balance, computed);
+        if (balance != computed) {
+            AccountValue v = { id, computed };
+            PUSH(balance_fixes, balance_fix_count, balance_fix_cap, v);
+        }
+    }
+    db_release(accounts);
+    stats->accounts_fixed = balance_fix_count;
+
+    if (!ok) {
+        fprintf(err, "❌ 核对失败: %s\n", sqlite3_errmsg(db));
+    } else if (repair && (month_fix_count || balance_fix_count)) {
+        ok = apply_fixes(db, month_fixes, month_fix_count, balance_fixes, balance_fix_count, err);
+    }
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+
+    free(month_fixes);
+    free(sums);
+    free(balance_fixes);
+    return ok;
+}
+
+// === 菜单 ===
+typedef struct {
+    int64_t total;
+    int count;
+} BalancePrinter;
+
+static void print_balance_row(void* ctx, const char* account, int64_t balance) {
+    BalancePrinter* p = ctx;
+    char text[MONEY_BUF_SIZE];
+    format_money(balance, text, sizeof(text));
+    printf("%-20s %s\n", account ? account : "-", text);
+    p->total += balance;
+    p->count++;
+}
+
+void show_balances_menu(void) {
+    char date[20];
+    char today[DATE_TEXT_LEN + 1];
+    format_today(today, sizeof(today));
+
+    printf("请输入截止日期（YYYY-MM-DD，直接回车为今天 %s）: ", today);
+    if (fgets(date, sizeof(date), stdin) == NULL) {
+        printf("❌ 输入失败。\n");
+        return;
+    }
+    date[strcspn(date, "\n")] = 0;
+    if (date[0] == '\0') {
+        snprintf(date, sizeof(date), "%s", today);
+    } else if (!date_is_valid(date)) {
+        printf("❌ 日期无效！应为 YYYY-MM-DD 格式的有效日期\n");
+        return;
+    }
+
+    printf("\n💰 截至 %s 的账户余额\n", date);
+    printf("%-20s %s\n", "账户", "余额");
+    printf("------------------------------\n");
+    BalancePrinter p = { 0, 0 };
+    if (!balance_as_of(date, print_balance_row, &p, stderr)) {
+        printf("❌ 查询失败。\n");
+        return;
+    }
+    if (p.count == 0) {
+        printf("📭 暂无账户。\n");
+        return;
+    }
+    printf("------------------------------\n");
+    char total[MONEY_BUF_SIZE];
+    format_money(p.total, total, sizeof(total));
+    printf("%-20s %s\n", "合计", total);
+}
+
+static void print_mismatch_row(void* ctx, const char* account, int64_t stored, int64_t computed) {
+    (void)ctx;
+    if (stored == computed) return;
+    char stored_text[MONEY_BUF_SIZE], computed_text[MONEY_BUF_SIZE], diff_text[MONEY_BUF_SIZE];
+    format_money(stored, stored_text, sizeof(stored_text));
+    format_money(computed, computed_text, sizeof(computed_text));
+    format_money(stored - computed, diff_text, sizeof(diff_text));
+    printf("%-20s %-14s %-14s %s\n", account ? account : "-", stored_text, computed_text, diff_text);
+}
+
+void reconcile_balances_menu(void) {
+    printf("⏳ 正在按记录重算各账户余额...\n");
+    printf("%-20s %-14s %-14s %s\n", "账户", "账面余额", "重算余额", "差额");
+    ReconcileStats stats;
+    if (!reconcile_balances(0, print_mismatch_row, NULL, &stats, stderr)) {
+        printf("❌ 核对失败。\n");
+        return;
+    }
+    printf("📊 核对 %d 个账户、%d 个月度检查点：余额不符 %d 个，检查点不符 %d 个。\n",
+           stats.accounts, stats.months, stats.accounts_fixed, stats.months_fixed);
+    if (stats.accounts_fixed == 0 && stats.months_fixed == 0) {
+        printf("✅ 账户余额与记录一致。\n");
+        return;
+    }
+
+    char input[10];
+    printf("是否按记录修复？(y/N): ");
+    if (fgets(input, sizeof(input), stdin) == NULL || (input[0] != 'y' && input[0] != 'Y')) {
+        printf("已取消，未做修改。\n");
+        return;
+    }
+    if (reconcile_balances(1, NULL, NULL, &stats, stderr)) {
+        printf("✅ 已修复 %d 个账户余额、%d 个月度检查点。\n", stats.accounts_fixed, stats.months_fixed);
+    } else {
+        printf("❌ 修复失败，未做修改。\n");
+    }
+}
@@ -0,0 +1,37 @@
+// balance.h
+#ifndef BALANCE_H
+#define BALANCE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "sqlite3.h"
+
+// 账户余额账本：
+//   accounts.opening_balance : 期初余额（记录之外的部分；手工修改余额时随之调整）
+//   balance_checkpoints      : 账户 × 月份的收支净额（由 records 上的触发器增量维护）
+// 账面余额 accounts.balance 应恒等于 期初 + 全部月份净额，reconcile 负责核对与修复；
+// 任一日期的余额 = 期初 + 之前各月净额 + 当月截至该日的记录，代价与月份数成正比
+void init_balance_ledger(sqlite3* db);
+int suspend_balance_ledger(sqlite3* db);    // 批量写入前删除触发器，之后由 init_balance_ledger 重建
+
+// 截至 date（含当天，YYYY-MM-DD；NULL 为今天）各账户余额，按账户 id 顺序逐行回调
+// 以下失败返回 0，原因写到 err（NULL 为 stderr）
+typedef void (*BalanceRowFn)(void* ctx, const char* account, int64_t balance);
+int balance_as_of(const char* date, BalanceRowFn fn, void* ctx, FILE* err);
+
+// 核对：一次分组扫描 records 重算各账户各月净额，与 balance_checkpoints 及账面余额比较；
+// repair 非 0 时在一个事务内修正全部差异。每个账户回调一次（stored 为核对前的账面余额）
+typedef struct {
+    int months;             // 重算得到的 账户 × 月份 组数
+    int months_fixed;       // 与检查点不一致（含多余/缺失）的组数
+    int accounts;
+    int accounts_fixed;     // 账面余额与重算结果不一致的账户数
+} ReconcileStats;
+
+typedef void (*ReconcileRowFn)(void* ctx, const char* account, int64_t stored, int64_t computed);
+int reconcile_balances(int repair, ReconcileRowFn fn, void* ctx, ReconcileStats* stats, FILE* err);
+
+void show_balances_menu(void);
+void reconcile_balances_menu(void);
+
+#endif
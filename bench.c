@@ -0,0 +1,913 @@
+// bench.c
+// 性能基准：生成可复现的合成账本，测量写入、查询、翻页、导出、报表与引用检查的耗时，
+// 结果另存为 JSON 以便跨版本对比
+// 用法: finance_bench [--members=N] [--accounts=N] [--categories=N] [--json=文件]
+//                     [记录数，默认 1000000] [数据库文件，默认 bench.db]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <time.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "utils.h"
+#include "finance.h"
+#include "snapshot.h"
+#include "parallel.h"
+#include "agg.h"
+#include "search.h"
+#include "balance.h"
+#include "sha256.h"
+#include "kdf.h"
+#include "date.h"
+#include "query.h"
+#include "pivot.h"
+
+#define BENCH_SEED 20260101u
+#define BENCH_REPEAT 20
+
+// xorshift64*：固定种子，保证每次生成相同数据
+static uint64_t rng_state = BENCH_SEED;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 2685821657736338717ULL) >> 32);
+}
+
+static int rng_range(int lo, int hi) {
+    return lo + (int)(rng_next() % (uint32_t)(hi - lo + 1));
+}
+
+// 偏斜取值：两次均匀取小者，越靠前的值越常见（常用账户、高频消费分类）
+static int rng_skewed(int lo, int hi) {
+    int a = rng_range(lo, hi), b = rng_range(lo, hi);
+    return a < b ? a : b;
+}
+
+// 维度规模（成员、账户、一级分类数可由命令行覆盖）
+// 最后一个成员/账户/一级分类不被任何记录引用，用于测最坏情况的引用检查
+#define BENCH_MEMBERS 4
+#define BENCH_ACCOUNTS 6
+#define BENCH_PARENTS 10
+#define BENCH_CHILDREN 5
+#define BENCH_INCOME_PARENTS 2     // 前两个一级分类为收入：1 工资、2 其他收入
+#define BENCH_FIRST_YEAR 2016
+#define BENCH_YEARS 10
+
+static int bench_members = BENCH_MEMBERS;
+static int bench_accounts = BENCH_ACCOUNTS;
+static int bench_parents = BENCH_PARENTS;
+
+// 引用检查用例的参数：以下标记在执行时换成未被引用的维度 id
+#define PARAM_SPARE_MEMBER   -1
+#define PARAM_SPARE_ACCOUNT  -2
+#define PARAM_SPARE_CATEGORY -3   // 未引用的一级分类（其子分类同样未引用）
+
+static int query_param(int param) {
+    switch (param) {
+    case PARAM_SPARE_MEMBER:   return bench_members + 1;
+    case PARAM_SPARE_ACCOUNT:  return bench_accounts + 1;
+    case PARAM_SPARE_CATEGORY: return bench_parents * (BENCH_CHILDREN + 1) + 1;
+    default:                   return param;
+    }
+}
+
+static int exec_or_die(sqlite3* db, const char* sql) {
+    char* err = NULL;
+    if (sqlite3_exec(db, sql, NULL, NULL, &err) != SQLITE_OK) {
+        fprintf(stderr, "❌ SQL 失败: %s\n", err ? err : sqlite3_errmsg(db));
+        sqlite3_free(err);
+        exit(1);
+    }
+    return 1;
+}
+
+// 生成维度数据与 n 条记录。分布近似真实账本：
+// - 约一成是收入，其中多数为每月上旬的工资；支出集中在前几个一级分类
+// - 记账量逐年增长（越近的年份记录越多），日期覆盖每月全部天数（含闰日）
+// - 金额长尾：多数为几十元的小额，偶有上千元的大额（基数 × 1000 / 均匀数）
+// - 一成记录不指定成员；账户偏向前几个常用账户
+static void generate_ledger(sqlite3* db, int n) {
+    char sql[256];
+    exec_or_die(db, "BEGIN;");
+
+    for (int i = 1; i <= bench_members + 1; i++) {
+        snprintf(sql, sizeof(sql), "INSERT INTO members (name) VALUES ('成员%d');", i);
+        exec_or_die(db, sql);
+    }
+    for (int i = 1; i <= bench_accounts + 1; i++) {
+        snprintf(sql, sizeof(sql), "INSERT INTO accounts (name, balance) VALUES ('账户%d', 0);", i);
+        exec_or_die(db, sql);
+    }
+    // 分类 id 布局：每个一级分类后紧跟其子分类
+    for (int p = 1; p <= bench_parents + 1; p++) {
+        const char* type = (p <= BENCH_INCOME_PARENTS) ? "income" : "expense";
+        snprintf(sql, sizeof(sql),
+                 "INSERT INTO categories (name, parent_id, type) VALUES ('分类%d', NULL, '%s');", p, type);
+        exec_or_die(db, sql);
+        sqlite3_int64 parent_id = sqlite3_last_insert_rowid(db);
+        for (int c = 1; c <= BENCH_CHILDREN; c++) {
+            snprintf(sql, sizeof(sql),
+                     "INSERT INTO categories (name, parent_id, type) VALUES ('分类%d-%d', %lld, '%s');",
+                     p, c, parent_id, type);
+            exec_or_die(db, sql);
+        }
+    }
+
+    sqlite3_stmt* stmt;
+    sqlite3_prepare_v2(db,
+        "INSERT INTO records (date, type, category_id, amount, account_id, member_id, remark) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?);", -1, &stmt, NULL);
+
+    char date[11];
+    char remark[32];
+    for (int i = 0; i < n; i++) {
+        int income = (rng_next() % 10 == 0);
+        int parent = income ? ((rng_next() % 4) ? 1 : 2)
+                            : BENCH_INCOME_PARENTS + rng_skewed(1, bench_parents - BENCH_INCOME_PARENTS);
+        int child = rng_range(0, BENCH_CHILDREN);          // 0 表示直接记在一级分类
+        int category_id = (parent - 1) * (BENCH_CHILDREN + 1) + 1 + child;
+
+        int year = BENCH_FIRST_YEAR + rng_range(0, BENCH_YEARS - 1);
+        int later = BENCH_FIRST_YEAR + rng_range(0, BENCH_YEARS - 1);
+        if (later > year) year = later;                    // 两次取大者：记录数随年份线性增长
+        int month = rng_range(1, 12);
+        int day = (parent == 1) ? rng_range(1, 10) : rng_range(1, date_days_in_month(year, month));
+        date_format(date_to_days(year, month, day), date);
+
+        int64_t amount;   // 分
+        if (parent == 1) {
+            amount = rng_range(800000, 1500000);
+        } else {
+            int64_t base = income ? rng_range(5000, 15000) : rng_range(1000, 3000);
+            amount = base * 1000 / rng_range(10, 1000);
+        }
+        snprintf(remark, sizeof(remark), "备注%u", rng_next() % 1000);
+
+        sqlite3_bind_text(stmt, 1, date, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, income ? "income" : "expense", -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 3, category_id);
+        sqlite3_bind_int64(stmt, 4, amount);
+        sqlite3_bind_int(stmt, 5, rng_skewed(1, bench_accounts));
+        if (rng_next() % 10 == 0) sqlite3_bind_null(stmt, 6);
+        else sqlite3_bind_int(stmt, 6, rng_range(1, bench_members));
+        sqlite3_bind_text(stmt, 7, remark, -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            fprintf(stderr, "❌ 插入失败: %s\n", sqlite3_errmsg(db));
+            exit(1);
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    exec_or_die(db, "COMMIT;");
+}
+
+// === JSON 结果 ===
+// 每项一个数值，键名形如 "report.rollup.monthly_ms"，末段后缀即单位；同一种子与记录数的
+// 多次运行可直接按键对比，用于跟踪回归
+#define BENCH_MAX_RESULTS 256
+
+typedef struct {
+    char key[96];
+    double value;
+} BenchResult;
+
+static BenchResult results[BENCH_MAX_RESULTS];
+static int result_count;
+
+static void bench_result(double value, const char* fmt, ...) {
+    if (result_count >= BENCH_MAX_RESULTS) return;
+    BenchResult* r = &results[result_count++];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(r->key, sizeof(r->key), fmt, ap);
+    va_end(ap);
+    r->value = value;
+}
+
+static int write_results_json(const char* path, int n) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "❌ 无法创建 %s\n", path);
+        return 0;
+    }
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"timestamp\": \"%s\",\n", stamp);
+    fprintf(fp, "  \"sqlite_version\": \"%s\",\n", sqlite3_libversion());
+    fprintf(fp, "  \"profile\": %d,\n", db_current_profile());
+    fprintf(fp, "  \"seed\": %u,\n", BENCH_SEED);
+    fprintf(fp, "  \"records\": %d,\n", n);
+    fprintf(fp, "  \"members\": %d,\n", bench_members);
+    fprintf(fp, "  \"accounts\": %d,\n", bench_accounts);
+    fprintf(fp, "  \"categories\": %d,\n", bench_parents * (BENCH_CHILDREN + 1));
+    fprintf(fp, "  \"results\": {\n");
+    for (int i = 0; i < result_count; i++) {
+        fprintf(fp, "    \"%s\": %.4f%s\n", results[i].key, results[i].value,
+                i + 1 < result_count ? "," : "");
+    }
+    fprintf(fp, "  }\n}\n");
+    return fclose(fp) == 0;
+}
+
+// === 查询用例 ===
+typedef struct {
+    const char* name;
+    const char* sql;
+    int int_param;           // > 0 或 PARAM_SPARE_* 时绑定到全部参数
+    const char* key;         // JSON 结果键名
+} BenchQuery;
+
+static const BenchQuery queries[] = {
+    { "列表首页 (ORDER BY date DESC, id DESC)",
+      "SELECT r.id, r.date, r.type, c_parent.name, c_child.name, a.name, m.name, r.amount, r.remark, r.updated_at "
+      "FROM records r "
+      "JOIN categories c_child ON r.category_id = c_child.id "
+      "LEFT JOIN categories c_parent ON c_child.parent_id = c_parent.id "
+      "JOIN accounts a ON r.account_id = a.id "
+      "LEFT JOIN members m ON r.member_id = m.id "
+      "ORDER BY r.date DESC, r.id DESC LIMIT 8;", 0, "list_first_page" },
+    { "按日期查询 (date = ?)",
+      "SELECT r.id, r.amount FROM records r WHERE r.date = '2020-06-15' ORDER BY r.date DESC, r.id DESC;",
+      0, "by_date" },
+    // 以下四条与 settings.c 删除成员/账户/分类前的检查同形
+    { "成员引用检查 (未引用)",
+      "SELECT 1 FROM records WHERE member_id = ? LIMIT 1;", PARAM_SPARE_MEMBER, "ref_check_member" },
+    { "账户引用检查 (未引用)",
+      "SELECT 1 FROM records WHERE account_id = ? "
+      "UNION SELECT 1 FROM accounts WHERE id = ? AND balance != 0 LIMIT 1;",
+      PARAM_SPARE_ACCOUNT, "ref_check_account" },
+    { "分类引用检查 (未引用)",
+      "SELECT 1 FROM records WHERE category_id = ? LIMIT 1;", PARAM_SPARE_CATEGORY, "ref_check_category" },
+    { "子分类检查",
+      "SELECT COUNT(*) FROM categories WHERE parent_id = ?", PARAM_SPARE_CATEGORY, "ref_check_children" },
+    { "类型+日期范围汇总",
+      "SELECT COUNT(*), SUM(amount) FROM records "
+      "WHERE type = 'income' AND date BETWEEN '2024-01-01' AND '2024-03-31';", 0, "type_date_range_sum" },
+    { "组合查询 (日期区间+类型+金额+备注)",   // 与 query.c 生成的语句同形
+      "SELECT r.id, r.amount FROM records r "
+      "WHERE r.date BETWEEN '2024-01-01' AND '2024-03-31' AND r.type = 'expense' "
+      "AND r.amount >= 10000 AND instr(r.remark, '备注1') > 0 "
+      "ORDER BY r.date DESC, r.id DESC;", 0, "combined_filter" },
+    { "月度报表 (全表 GROUP BY)",
+      "SELECT strftime('%Y-%m', date) AS month, "
+      "SUM(CASE WHEN type = 'income' THEN amount ELSE 0 END), "
+      "SUM(CASE WHEN type = 'expense' THEN amount ELSE 0 END) "
+      "FROM records GROUP BY month ORDER BY month DESC;", 0, "monthly_group_by" },
+    { "月度报表 (汇总表)",
+      "SELECT month, "
+      "SUM(CASE WHEN type = 'income' THEN total ELSE 0 END), "
+      "SUM(CASE WHEN type = 'expense' THEN total ELSE 0 END) "
+      "FROM rollup_month_type GROUP BY month ORDER BY month DESC;", 0, "monthly_rollup" },
+};
+#define QUERY_COUNT ((int)(sizeof(queries) / sizeof(queries[0])))
+
+// 执行一条查询 repeat 次，返回平均毫秒数
+static double time_query_n(sqlite3* db, const BenchQuery* q, int repeat) {
+    double start = now_ms();
+    for (int r = 0; r < repeat; r++) {
+        sqlite3_stmt* stmt = db_prepare(db, q->sql);
+        if (!stmt) {
+            fprintf(stderr, "❌ 准备失败: %s\n", sqlite3_errmsg(db));
+            exit(1);
+        }
+        int param = query_param(q->int_param);
+        if (param > 0) {
+            for (int p = 1; p <= sqlite3_bind_parameter_count(stmt); p++) {
+                sqlite3_bind_int(stmt, p, param);
+            }
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) { }
+        db_release(stmt);
+    }
+    return (now_ms() - start) / repeat;
+}
+
+static double time_query(sqlite3* db, const BenchQuery* q) {
+    return time_query_n(db, q, BENCH_REPEAT);
+}
+
+static void run_queries(sqlite3* db, double* out) {
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        out[i] = time_query(db, &queries[i]);
+    }
+}
+
+// CSV 导出吞吐：全表流式写出到临时文件
+static void bench_export(const char* path) {
+    char csv_path[512];
+    snprintf(csv_path, sizeof(csv_path), "%s.csv", path);
+    FILE* fp = fopen(csv_path, "wb");
+    if (!fp) {
+        fprintf(stderr, "❌ 无法创建 %s\n", csv_path);
+        return;
+    }
+
+    double t0 = now_ms();
+    long rows = write_records_csv(fp);
+    long bytes = ftell(fp);
+    fclose(fp);
+    double ms = now_ms() - t0;
+    remove(csv_path);
+
+    if (rows < 0) {
+        fprintf(stderr, "❌ 导出失败\n");
+        return;
+    }
+    bench_result(ms, "export.csv_ms");
+    bench_result(ms > 0 ? rows * 1000.0 / ms : 0.0, "export.csv_rows_per_s");
+    printf("CSV 导出: %ld 行, %.1f MB, %.0f ms（%.0f 行/秒, %.1f MB/秒）\n",
+           rows, bytes / 1048576.0, ms, ms > 0 ? rows * 1000.0 / ms : 0.0,
+           ms > 0 ? bytes / 1048576.0 * 1000.0 / ms : 0.0);
+}
+
+// 报表引擎：汇总表 vs 列式快照
+static void count_period_row(void* ctx, const char* period, int64_t income, int64_t expense) {
+    (void)period; (void)income; (void)expense;
+    (*(int*)ctx)++;
+}
+
+static void count_category_row(void* ctx, const char* category, int64_t total) {
+    (void)category; (void)total;
+    (*(int*)ctx)++;
+}
+
+static double time_reports_n(int repeat) {
+    int rows = 0;
+    double start = now_ms();
+    for (int r = 0; r < repeat; r++) {
+        report_period_totals(0, count_period_row, &rows);
+        report_period_totals(1, count_period_row, &rows);
+        report_category_totals("expense", count_category_row, &rows);
+    }
+    return (now_ms() - start) / repeat;
+}
+
+static double time_reports(void) {
+    return time_reports_n(BENCH_REPEAT);
+}
+
+// 报表输出摘要（FNV-1a，逐行逐字段），比较各引擎、各线程数的结果是否完全一致
+static void digest_bytes(uint64_t* h, const void* data, size_t n) {
+    const unsigned char* p = data;
+    for (size_t i = 0; i < n; i++) {
+        *h ^= p[i];
+        *h *= 1099511628211ull;
+    }
+}
+
+static void digest_period_row(void* ctx, const char* period, int64_t income, int64_t expense) {
+    digest_bytes(ctx, period, strlen(period) + 1);
+    digest_bytes(ctx, &income, sizeof(income));
+    digest_bytes(ctx, &expense, sizeof(expense));
+}
+
+static void digest_category_sum(void* ctx, int category_id, int64_t total) {
+    digest_bytes(ctx, &category_id, sizeof(category_id));
+    digest_bytes(ctx, &total, sizeof(total));
+}
+
+#define DIGEST_SEED 14695981039346656037ull
+
+// 串行结果：月度/年度取汇总表报表，分类取 SQL GROUP BY（与 parallel_category_totals 同为 id 升序）
+static uint64_t serial_digest(sqlite3* db) {
+    uint64_t h = DIGEST_SEED;
+    int saved = report_engine_current();
+    report_engine_set(REPORT_ENGINE_ROLLUP);
+    report_period_totals(0, digest_period_row, &h);
+    report_period_totals(1, digest_period_row, &h);
+    report_engine_set(saved);
+
+    static const char* const types[] = { "expense", "income" };
+    for (int t = 0; t < 2; t++) {
+        sqlite3_stmt* stmt = db_prepare(db,
+            "SELECT category_id, SUM(amount) FROM records WHERE type = ? GROUP BY category_id ORDER BY category_id;");
+        if (!stmt) return 0;
+        sqlite3_bind_text(stmt, 1, types[t], -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            digest_category_sum(&h, sqlite3_column_int(stmt, 0), sqlite3_column_int64(stmt, 1));
+        }
+        db_release(stmt);
+    }
+    return h;
+}
+
+// 直接调用并行引擎（不经 report_* 的汇总表回退）；返回 0 表示没有并行执行
+static int parallel_digest(uint64_t* out) {
+    uint64_t h = DIGEST_SEED;
+    int ran = parallel_period_totals(0, digest_period_row, &h)
+           && parallel_period_totals(1, digest_period_row, &h)
+           && parallel_category_totals("expense", digest_category_sum, &h)
+           && parallel_category_totals("income", digest_category_sum, &h);
+    *out = h;
+    return ran;
+}
+
+// 返回 0 表示并行引擎没有执行或结果与串行不一致
+static int bench_report_engines(sqlite3* db) {
+    report_engine_set(REPORT_ENGINE_ROLLUP);
+    double rollup_ms = time_reports();
+
+    report_engine_set(REPORT_ENGINE_SNAPSHOT);
+    double t0 = now_ms();
+    snapshot_get();
+    double load_ms = now_ms() - t0;
+    double snapshot_ms = time_reports();
+
+    // 改一条、删一条、加一条后的首次报表（含增量刷新 / 删除触发的重载）
+    exec_or_die(db, "UPDATE records SET amount = amount + 1, updated_at = datetime('now', 'localtime') "
+                    "WHERE id = (SELECT MAX(id) / 2 FROM records);");
+    t0 = now_ms();
+    time_reports();
+    double update_ms = now_ms() - t0;
+    exec_or_die(db, "INSERT INTO records (date, type, category_id, amount, account_id, member_id) "
+                    "VALUES ('2025-06-01', 'expense', 3, 100, 1, 1);");
+    t0 = now_ms();
+    snapshot_get();
+    double insert_ms = now_ms() - t0;
+
+    printf("\n报表（月度+年度+分类，平均，毫秒）\n");
+    printf("  汇总表:               %10.3f\n", rollup_ms);
+    printf("  列式快照:             %10.3f（首次载入 %.0f ms）\n", snapshot_ms, load_ms);
+    printf("  快照修改 1 条后刷新:  %10.3f（含 %d 次报表）\n", update_ms, BENCH_REPEAT * 3);
+    printf("  快照新增 1 条后刷新:  %10.3f\n", insert_ms);
+    bench_result(rollup_ms, "report.rollup.all_ms");
+    bench_result(snapshot_ms, "report.snapshot.all_ms");
+    bench_result(load_ms, "report.snapshot.load_ms");
+    bench_result(update_ms, "report.snapshot.after_update_ms");
+    bench_result(insert_ms, "report.snapshot.after_insert_ms");
+
+    // 并行扫描：各线程数的耗时，以及与串行结果的逐行比对
+    report_engine_set(REPORT_ENGINE_ROLLUP);
+    uint64_t serial = serial_digest(db);
+    int saved_threads = parallel_threads_setting();
+    int passed = 1;
+    static const int thread_counts[] = { 1, 2, 4, 8 };
+    report_engine_set(REPORT_ENGINE_PARALLEL);
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+        parallel_threads_set(thread_counts[i]);
+        double ms = time_reports_n(3);   // 每次全表扫描，少做几轮
+        uint64_t digest;
+        int ran = parallel_digest(&digest);
+        const char* verdict = !ran ? "❌ 未并行执行（回退到汇总表）"
+                            : digest != serial ? "❌ 与串行结果不一致" : "与串行结果一致";
+        printf("  并行扫描 %d 线程:      %10.3f  %s\n", thread_counts[i], ms, verdict);
+        bench_result(ms, "report.parallel.threads%d.all_ms", thread_counts[i]);
+        if (!ran || digest != serial) passed = 0;
+    }
+    parallel_threads_set(saved_threads);
+    report_engine_set(REPORT_ENGINE_ROLLUP);
+    return passed;
+}
+
+// 单项报表 × 报表引擎（快照此前已载入，测的是稳态耗时）
+#define REPORT_KIND_COUNT 4
+
+static const char* const report_kind_names[REPORT_KIND_COUNT] = { "月度", "年度", "支出分类", "收入分类" };
+static const char* const report_kind_keys[REPORT_KIND_COUNT] = {
+    "monthly", "yearly", "category_expense", "category_income" };
+static const char* const engine_keys[REPORT_ENGINE_COUNT] = { "rollup", "snapshot", "parallel" };
+
+static double time_report(int kind, int repeat) {
+    int rows = 0;
+    double start = now_ms();
+    for (int r = 0; r < repeat; r++) {
+        if (kind < 2) report_period_totals(kind, count_period_row, &rows);
+        else report_category_totals(kind == 2 ? "expense" : "income", count_category_row, &rows);
+    }
+    return (now_ms() - start) / repeat;
+}
+
+static void bench_each_report(void) {
+    double ms[REPORT_KIND_COUNT][REPORT_ENGINE_COUNT];
+    for (int e = 0; e < REPORT_ENGINE_COUNT; e++) {
+        report_engine_set(e);
+        for (int k = 0; k < REPORT_KIND_COUNT; k++) {
+            ms[k][e] = time_report(k, e == REPORT_ENGINE_PARALLEL ? 3 : BENCH_REPEAT);
+            bench_result(ms[k][e], "report.%s.%s_ms", engine_keys[e], report_kind_keys[k]);
+        }
+    }
+    report_engine_set(REPORT_ENGINE_ROLLUP);
+
+    printf("\n%-40s", "各报表（平均，毫秒）");
+    for (int e = 0; e < REPORT_ENGINE_COUNT; e++) printf(" %12s", report_engine_name(e));
+    printf("\n");
+    for (int k = 0; k < REPORT_KIND_COUNT; k++) {
+        printf("%-40s", report_kind_names[k]);
+        for (int e = 0; e < REPORT_ENGINE_COUNT; e++) printf(" %12.3f", ms[k][e]);
+        printf("\n");
+    }
+}
+
+// 透视报表：常用的几种行 × 列组合，输出 CSV 到临时文件
+static void bench_pivot(void) {
+    static const struct {
+        const char* key;
+        int rows, cols, measure;
+        int year;                   // > 0 时只统计该年
+    } specs[] = {
+        { "month_by_category1_sum",   PIVOT_DIM_MONTH,     PIVOT_DIM_CATEGORY1, PIVOT_MEASURE_SUM,     0 },
+        { "year_by_member_avg",       PIVOT_DIM_YEAR,      PIVOT_DIM_MEMBER,    PIVOT_MEASURE_AVG,     0 },
+        { "category2_by_type_records", PIVOT_DIM_CATEGORY2, PIVOT_DIM_TYPE,     PIVOT_MEASURE_RECORDS, 0 },
+        { "quarter_by_account_max_2024", PIVOT_DIM_QUARTER, PIVOT_DIM_ACCOUNT,  PIVOT_MEASURE_MAX,  2024 },
+    };
+
+    printf("\n%-40s %12s\n", "透视报表（毫秒）", "");
+    for (size_t i = 0; i < sizeof(specs) / sizeof(specs[0]); i++) {
+        PivotSpec spec;
+        spec.rows = specs[i].rows;
+        spec.cols = specs[i].cols;
+        spec.measure = specs[i].measure;
+        record_filter_init(&spec.filter);
+        if (specs[i].year > 0) {
+            spec.filter.has_from = spec.filter.has_to = 1;
+            spec.filter.day_from = date_to_days(specs[i].year, 1, 1);
+            spec.filter.day_to = date_to_days(specs[i].year, 12, 31);
+        }
+
+        FILE* fp = tmpfile();
+        if (!fp) return;
+        double t0 = now_ms();
+        int ok = pivot_write_csv(&spec, fp, 0, stderr);
+        double ms = now_ms() - t0;
+        fclose(fp);
+        if (!ok) {
+            fprintf(stderr, "❌ 透视报表失败: %s\n", specs[i].key);
+            continue;
+        }
+
+        char label[96];
+        snprintf(label, sizeof(label), "%s × %s %s%s", pivot_dim_label(spec.rows), pivot_dim_label(spec.cols),
+                 pivot_measure_label(spec.measure), specs[i].year > 0 ? "（单年）" : "");
+        printf("%-40s %12.3f\n", label, ms);
+        bench_result(ms, "pivot.%s_ms", specs[i].key);
+    }
+}
+
+// 列表翻页：与 list_records 同形的键集分页（从头连翻、直接定位到中部），对照 OFFSET 跳页
+#define BENCH_PAGE_SIZE 8
+#define BENCH_PAGES 200
+
+// 取 (date, id) 处开始的一页（多取一行作为下一页首行），返回本页行数
+static int fetch_page(sqlite3* db, char* date, size_t date_size, sqlite3_int64* id) {
+    sqlite3_stmt* stmt = db_prepare(db, RECORD_LIST_SELECT
+        "WHERE (r.date, r.id) <= (?, ?) "
+        "ORDER BY r.date DESC, r.id DESC LIMIT ?;");
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, date, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, *id);
+    sqlite3_bind_int(stmt, 3, BENCH_PAGE_SIZE + 1);
+    int rows = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        if (rows == BENCH_PAGE_SIZE) {
+            const char* next = (const char*)sqlite3_column_text(stmt, 1);
+            snprintf(date, date_size, "%s", next ? next : "");
+            *id = sqlite3_column_int64(stmt, 0);
+            break;
+        }
+        rows++;
+    }
+    db_release(stmt);
+    return rows;
+}
+
+static void bench_paging(sqlite3* db, int n) {
+    char date[11];
+    sqlite3_int64 id;
+
+    // 从最新一页连续向后翻
+    snprintf(date, sizeof(date), "9999-12-31");
+    id = INT64_MAX;
+    int pages = 0;
+    double t0 = now_ms();
+    while (pages < BENCH_PAGES && fetch_page(db, date, sizeof(date), &id) == BENCH_PAGE_SIZE) pages++;
+    double sequential_ms = pages > 0 ? (now_ms() - t0) / pages : 0.0;
+
+    // 中部的一页：键集定位 vs OFFSET
+    char middle_date[11] = "";
+    sqlite3_int64 middle_id = 0;
+    sqlite3_stmt* stmt = db_prepare(db,
+        "SELECT date, id FROM records ORDER BY date DESC, id DESC LIMIT 1 OFFSET ?;");
+    if (!stmt) return;
+    sqlite3_bind_int(stmt, 1, n / 2);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        snprintf(middle_date, sizeof(middle_date), "%s", (const char*)sqlite3_column_text(stmt, 0));
+        middle_id = sqlite3_column_int64(stmt, 1);
+    }
+    db_release(stmt);
+
+    t0 = now_ms();
+    for (int r = 0; r < BENCH_REPEAT; r++) {
+        snprintf(date, sizeof(date), "%s", middle_date);
+        id = middle_id;
+        fetch_page(db, date, sizeof(date), &id);
+    }
+    double keyset_ms = (now_ms() - t0) / BENCH_REPEAT;
+
+    char offset_sql[512];
+    snprintf(offset_sql, sizeof(offset_sql), RECORD_LIST_SELECT
+             "ORDER BY r.date DESC, r.id DESC LIMIT %d OFFSET %d;", BENCH_PAGE_SIZE + 1, n / 2);
+    BenchQuery offset = { "", offset_sql, 0, NULL };
+    double offset_ms = time_query_n(db, &offset, 3);
+
+    printf("\n%-40s %12s\n", "列表翻页（每页 8 条，平均，毫秒）", "");
+    printf("%-40s %12.3f\n", "键集分页：从首页连翻", sequential_ms);
+    printf("%-40s %12.3f\n", "键集分页：定位到中部", keyset_ms);
+    printf("%-40s %12.3f\n", "OFFSET 分页：跳到中部", offset_ms);
+    bench_result(sequential_ms, "paging.keyset_sequential_ms");
+    bench_result(keyset_ms, "paging.keyset_middle_ms");
+    bench_result(offset_ms, "paging.offset_middle_ms");
+}
+
+// 单条新增：与 add_record 相同的 insert_record 路径（独立事务、余额更新、汇总表/检查点/索引触发器）
+#define BENCH_INSERTS 500
+
+static void bench_inserts(void) {
+    char date[11];
+    char remark[32];
+    double t0 = now_ms();
+    for (int i = 0; i < BENCH_INSERTS; i++) {
+        snprintf(date, sizeof(date), "2025-12-%02d", rng_range(1, 31));
+        snprintf(remark, sizeof(remark), "备注%u", rng_next() % 1000);
+        int category_id = (BENCH_INCOME_PARENTS + rng_skewed(1, bench_parents - BENCH_INCOME_PARENTS) - 1)
+                          * (BENCH_CHILDREN + 1) + 1 + rng_range(0, BENCH_CHILDREN);
+        if (insert_record(date, "expense", category_id, rng_range(100, 50000),
+                          rng_skewed(1, bench_accounts), rng_range(1, bench_members), remark) <= 0) {
+            fprintf(stderr, "❌ insert_record 失败\n");
+            return;
+        }
+    }
+    double ms = (now_ms() - t0) / BENCH_INSERTS;
+    printf("\n单条新增 insert_record（%d 条，各自提交）: 平均 %.3f ms，%.0f 条/秒\n",
+           BENCH_INSERTS, ms, ms > 0 ? 1000.0 / ms : 0.0);
+    bench_result(ms, "insert.record_ms");
+}
+
+// 聚合内核：全表 SQL GROUP BY 与快照上各指令集内核的报表耗时
+static const BenchQuery group_by_queries[] = {
+    { "按月",
+      "SELECT strftime('%Y-%m', date) AS k, SUM(CASE WHEN type = 'income' THEN amount ELSE 0 END), "
+      "SUM(CASE WHEN type = 'expense' THEN amount ELSE 0 END) FROM records GROUP BY k;", 0, "monthly" },
+    { "按年",
+      "SELECT strftime('%Y', date) AS k, SUM(CASE WHEN type = 'income' THEN amount ELSE 0 END), "
+      "SUM(CASE WHEN type = 'expense' THEN amount ELSE 0 END) FROM records GROUP BY k;", 0, "yearly" },
+    { "按分类",
+      "SELECT category_id, SUM(amount) FROM records WHERE type = 'expense' GROUP BY category_id;", 0, "category_expense" },
+};
+
+static void ignore_category_sum(void* ctx, int category_id, int64_t total) {
+    (void)category_id; (void)total;
+    (*(int*)ctx)++;
+}
+
+static const char* const isa_keys[AGG_ISA_COUNT] = { "scalar", "sse42", "avx2" };
+
+static void bench_agg_kernels(sqlite3* db) {
+    if (!snapshot_get()) return;
+    int saved = agg_isa_current();
+
+    printf("\n聚合内核（%ld 条，平均，毫秒）\n", snapshot_get()->count);
+    printf("%-10s %14s", "", "SQL GROUP BY");
+    for (int isa = 0; isa < AGG_ISA_COUNT; isa++) {
+        if (agg_isa_supported(isa)) printf(" %10s", agg_isa_name(isa));
+    }
+    printf("\n");
+
+    for (int q = 0; q < 3; q++) {
+        double sql_ms = time_query_n(db, &group_by_queries[q], 1);
+        bench_result(sql_ms, "agg.%s.sql_ms", group_by_queries[q].key);
+        printf("%-10s %14.3f", group_by_queries[q].name, sql_ms);
+        for (int isa = 0; isa < AGG_ISA_COUNT; isa++) {
+            if (!agg_isa_set(isa)) continue;
+            int rows = 0;
+            double t0 = now_ms();
+            for (int r = 0; r < BENCH_REPEAT; r++) {
+                if (q < 2) snapshot_period_totals(q, count_period_row, &rows);
+                else snapshot_category_totals("expense", ignore_category_sum, &rows);
+            }
+            double ms = (now_ms() - t0) / BENCH_REPEAT;
+            bench_result(ms, "agg.%s.%s_ms", group_by_queries[q].key, isa_keys[isa]);
+            printf(" %10.3f", ms);
+        }
+        printf("\n");
+    }
+    agg_isa_set(saved);
+}
+
+// 备注搜索：全表 instr 扫描 vs FTS5 索引（与 search.c 同形，取前 50 条）
+// 稀有词与不存在的词是搜索商户名的典型情形；高频词扫描很快凑满 50 条即停，FTS5 却要给全部命中打分
+static void bench_remark_search(sqlite3* db) {
+    if (!search_available()) return;
+    static const char* const terms[] = { "备注123", "星巴克", "备注12" };
+    static const char* const term_keys[] = { "rare", "missing", "frequent" };
+
+    printf("\n%-40s %12s %12s %8s\n", "备注搜索（平均，毫秒）", "instr 扫描", "FTS5", "加速");
+    for (size_t i = 0; i < sizeof(terms) / sizeof(terms[0]); i++) {
+        char scan_sql[256], fts_sql[320], label[64];
+        snprintf(scan_sql, sizeof(scan_sql),
+                 "SELECT r.id FROM records r WHERE instr(r.remark, '%s') > 0 "
+                 "ORDER BY r.date DESC, r.id DESC LIMIT 50;", terms[i]);
+        snprintf(fts_sql, sizeof(fts_sql),
+                 "SELECT r.id FROM records r JOIN records_fts ON records_fts.rowid = r.id "
+                 "WHERE records_fts MATCH '\"%s\"' "
+                 "ORDER BY records_fts.rank, r.date DESC, r.id DESC LIMIT 50;", terms[i]);
+        BenchQuery scan = { "", scan_sql, 0, NULL };
+        BenchQuery fts = { "", fts_sql, 0, NULL };
+        double scan_ms = time_query(db, &scan);
+        double fts_ms = time_query(db, &fts);
+        snprintf(label, sizeof(label), "\"%s\"", terms[i]);
+        printf("%-40s %12.3f %12.3f %7.0fx\n", label, scan_ms, fts_ms, fts_ms > 0 ? scan_ms / fts_ms : 0.0);
+        bench_result(scan_ms, "search.%s.scan_ms", term_keys[i]);
+        bench_result(fts_ms, "search.%s.fts_ms", term_keys[i]);
+    }
+}
+
+// 账户余额：全量扫描累加 vs 期初 + 月度检查点 + 当月记录；以及整库核对
+static void ignore_balance_row(void* ctx, const char* account, int64_t balance) {
+    (void)account;
+    *(int64_t*)ctx += balance;
+}
+
+static void bench_balances(sqlite3* db) {
+    static const char* const dates[] = { "2016-03-15", "2020-06-15", "2025-12-31" };
+
+    printf("\n%-40s %12s %12s %8s\n", "截至某日余额（平均，毫秒）", "全量扫描", "检查点", "加速");
+    for (size_t i = 0; i < sizeof(dates) / sizeof(dates[0]); i++) {
+        char scan_sql[512], label[64];
+        snprintf(scan_sql, sizeof(scan_sql),
+                 "SELECT a.id, a.opening_balance + COALESCE((SELECT SUM(CASE WHEN r.type = 'income' "
+                 "THEN r.amount ELSE -r.amount END) FROM records r "
+                 "WHERE r.account_id = a.id AND r.date <= '%s'), 0) FROM accounts a;", dates[i]);
+        BenchQuery scan = { "", scan_sql, 0, NULL };
+        double scan_ms = time_query(db, &scan);
+
+        int64_t total = 0;
+        double t0 = now_ms();
+        for (int r = 0; r < 5; r++) balance_as_of(dates[i], ignore_balance_row, &total, stderr);
+        double ledger_ms = (now_ms() - t0) / 5;
+
+        snprintf(label, sizeof(label), "截至 %s", dates[i]);
+        printf("%-40s %12.3f %12.3f %7.0fx\n", label, scan_ms, ledger_ms,
+               ledger_ms > 0 ? scan_ms / ledger_ms : 0.0);
+        bench_result(scan_ms, "balance.as_of_%.4s.scan_ms", dates[i]);
+        bench_result(ledger_ms, "balance.as_of_%.4s.checkpoint_ms", dates[i]);
+    }
+
+    ReconcileStats stats;
+    double t0 = now_ms();
+    reconcile_balances(0, NULL, NULL, &stats, stderr);
+    double reconcile_ms = now_ms() - t0;
+    printf("核对 %d 个账户、%d 个月度检查点: %.0f ms\n", stats.accounts, stats.months, reconcile_ms);
+    bench_result(reconcile_ms, "balance.reconcile_ms");
+}
+
+// SHA-256 吞吐：导出/备份文件的完整性摘要（大块）与口令哈希（短消息）
+static void bench_sha256(void) {
+    if (!sha256_self_test()) {
+        printf("\n❌ SHA-256 已知答案测试失败\n");
+        return;
+    }
+    const size_t size = 64u << 20;
+    uint8_t* buf = malloc(size);
+    if (!buf) return;
+    for (size_t i = 0; i < size; i++) buf[i] = (uint8_t)rng_next();
+
+    static const char* const impl_keys[SHA256_IMPL_COUNT] = { "portable", "shani" };
+    int saved = sha256_impl_current();
+    printf("\n%-40s %12s %12s\n", "SHA-256（已通过已知答案测试）", "MB/s", "短消息/秒");
+    for (int impl = 0; impl < SHA256_IMPL_COUNT; impl++) {
+        if (!sha256_impl_set(impl)) continue;
+        uint8_t hash[SHA256_BLOCK_SIZE];
+        double t0 = now_ms();
+        sha256(buf, size, hash);
+        double bulk_ms = now_ms() - t0;
+
+        // 口令哈希的输入形如 "密码 + 16 位盐"，一两个块
+        const int rounds = 200000;
+        t0 = now_ms();
+        for (int i = 0; i < rounds; i++) sha256(buf + (i & 1023), 40, hash);
+        double short_ms = now_ms() - t0;
+
+        double mb_per_s = bulk_ms > 0 ? (size / 1e6) / (bulk_ms / 1000) : 0.0;
+        double short_per_s = short_ms > 0 ? rounds / (short_ms / 1000) : 0.0;
+        printf("%-40s %12.0f %12.0f\n", sha256_impl_name(impl), mb_per_s, short_per_s);
+        bench_result(mb_per_s, "sha256.%s.mb_per_s", impl_keys[impl]);
+        bench_result(short_per_s, "sha256.%s.short_per_s", impl_keys[impl]);
+    }
+    sha256_impl_set(saved);
+    free(buf);
+}
+
+// 口令派生：已知答案测试 + 本机速度与校准结果
+static void bench_kdf(void) {
+    if (!kdf_self_test()) {
+        printf("\n❌ PBKDF2 已知答案测试失败\n");
+        return;
+    }
+    double rate = 0;
+    uint32_t iterations = kdf_calibrate(KDF_TARGET_MS, &rate);
+    printf("\nPBKDF2-HMAC-SHA256（已通过已知答案测试）: %.0f 次迭代/秒，%.0f 毫秒目标 -> %u 次\n",
+           rate, KDF_TARGET_MS, iterations);
+    bench_result(rate, "kdf.iterations_per_s");
+}
+
+static void usage(void) {
+    fprintf(stderr,
+        "用法: finance_bench [选项] [记录数，默认 1000000] [数据库文件，默认 bench.db]\n"
+        "  --members=N      成员数（默认 %d）\n"
+        "  --accounts=N     账户数（默认 %d）\n"
+        "  --categories=N   一级分类数，每个含 %d 个子分类，前 %d 个为收入（默认 %d）\n"
+        "  --json=文件      结果 JSON（默认 <数据库文件>.json）\n",
+        BENCH_MEMBERS, BENCH_ACCOUNTS, BENCH_CHILDREN, BENCH_INCOME_PARENTS, BENCH_PARENTS);
+}
+
+int main(int argc, char* argv[]) {
+    int n = 1000000;
+    const char* path = "bench.db";
+    const char* json_path = NULL;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (strncmp(a, "--members=", 10) == 0) bench_members = atoi(a + 10);
+        else if (strncmp(a, "--accounts=", 11) == 0) bench_accounts = atoi(a + 11);
+        else if (strncmp(a, "--categories=", 13) == 0) bench_parents = atoi(a + 13);
+        else if (strncmp(a, "--json=", 7) == 0) json_path = a + 7;
+        else if (strncmp(a, "--", 2) != 0 && positional == 0) { n = atoi(a); positional++; }
+        else if (strncmp(a, "--", 2) != 0 && positional == 1) { path = a; positional++; }
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (n <= 0) n = 1000000;
+    if (bench_members < 1 || bench_accounts < 1 || bench_parents <= BENCH_INCOME_PARENTS) {
+        usage();
+        return 2;
+    }
+    char default_json[512];
+    if (!json_path) {
+        snprintf(default_json, sizeof(default_json), "%s.json", path);
+        json_path = default_json;
+    }
+
+    remove(path);
+    if (!db_open(path)) return 1;
+    init_finance_database();
+    sqlite3* db = db_get();
+
+    printf("生成 %d 条记录（%d 个成员、%d 个账户、%d 个分类）-> %s\n",
+           n, bench_members, bench_accounts, bench_parents * (BENCH_CHILDREN + 1), path);
+    double t0 = now_ms();
+    drop_record_indexes(db); // 先无索引批量写入，模拟旧库
+    suspend_balance_ledger(db);
+    suspend_search_index(db);
+    generate_ledger(db, n);
+    double generate_ms = now_ms() - t0;
+    printf("生成耗时: %.0f ms\n\n", generate_ms);
+    bench_result(generate_ms, "generate_ms");
+
+    double before[QUERY_COUNT], after[QUERY_COUNT];
+    run_queries(db, before);
+
+    t0 = now_ms();
+    init_finance_database(); // 按版本迁移：创建索引集、余额检查点与备注索引
+    double index_ms = now_ms() - t0;
+    run_queries(db, after);
+
+    printf("%-40s %12s %12s %8s\n", "查询（平均，毫秒）", "无索引", "有索引", "加速");
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        printf("%-40s %12.3f %12.3f %7.0fx\n", queries[i].name, before[i], after[i],
+               after[i] > 0 ? before[i] / after[i] : 0.0);
+        bench_result(before[i], "query.%s.no_index_ms", queries[i].key);
+        bench_result(after[i], "query.%s.indexed_ms", queries[i].key);
+    }
+    printf("\n索引迁移耗时: %.0f ms\n", index_ms);
+    bench_result(index_ms, "index_migration_ms");
+
+    bench_export(path);
+    bench_paging(db, n);
+    bench_remark_search(db);
+    bench_balances(db);
+    int passed = bench_report_engines(db);
+    bench_each_report();
+    bench_pivot();
+    bench_agg_kernels(db);
+    bench_inserts();   // 改动数据，放在所有读测之后
+    bench_sha256();
+    bench_kdf();
+
+    db_close();
+    if (!write_results_json(json_path, n)) return 1;
+    printf("\n📝 结果已写入 %s（%d 项）\n", json_path, result_count);
+    if (!passed) {
+        fprintf(stderr, "❌ 并行报表引擎校验失败\n");
+        return 1;
+    }
+    return 0;
+}
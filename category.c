@@ -0,0 +1,136 @@
+// category.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "dim.h"
+#include "category.h"
+
+static CategoryTree tree;
+static int* index_by_id;        // id -> nodes 下标，-1 表示不存在
+static int max_id;
+static char* text_pool;         // 所有名称/路径的存储
+static unsigned loaded_generation;   // 0 表示未载入
+
+static void free_tree(void) {
+    free(tree.nodes);
+    free(index_by_id);
+    free(text_pool);
+    tree.nodes = NULL;
+    tree.count = 0;
+    index_by_id = NULL;
+    text_pool = NULL;
+    max_id = 0;
+    loaded_generation = 0;
+}
+
+// 一次查询按 (根 id, 层级, id) 排序，天然得到先序；parent_id 为 0 或悬空的按一级处理
+static int load_tree(void) {
+    free_tree();
+    sqlite3* db = db_get();
+    if (!db) return 0;
+
+    sqlite3_stmt* stmt = db_prepare(db,
+        "SELECT c.id, c.name, c.type, p.id, p.name "
+        "FROM categories c LEFT JOIN categories p ON c.parent_id = p.id "
+        "ORDER BY COALESCE(p.id, c.id), p.id IS NOT NULL, c.id;");
+    if (!stmt) return 0;
+
+    int cap = 64;
+    size_t pool_cap = 4096, pool_len = 0;
+    CategoryNode* nodes = malloc(sizeof(CategoryNode) * cap);
+    char* pool = malloc(pool_cap);
+    // 先存偏移，全部读完后再换成指针（pool 可能 realloc）
+    size_t* name_off = malloc(sizeof(size_t) * cap);
+    size_t* path_off = malloc(sizeof(size_t) * cap);
+    int count = 0, ok = (nodes && pool && name_off && path_off);
+
+    while (ok && sqlite3_step(stmt) == SQLITE_ROW) {
+        if (count == cap) {
+            cap *= 2;
+            CategoryNode* n = realloc(nodes, sizeof(CategoryNode) * cap);
+            size_t* a = realloc(name_off, sizeof(size_t) * cap);
+            size_t* b = realloc(path_off, sizeof(size_t) * cap);
+            if (n) nodes = n;
+            if (a) name_off = a;
+            if (b) path_off = b;
+            if (!n || !a || !b) { ok = 0; break; }
+        }
+        const char* name = (const char*)sqlite3_column_text(stmt, 1);
+        const char* type = (const char*)sqlite3_column_text(stmt, 2);
+        int parent_id = sqlite3_column_int(stmt, 3);
+        const char* parent_name = (const char*)sqlite3_column_text(stmt, 4);
+        if (!name) name = "";
+
+        size_t name_len = strlen(name);
+        size_t path_len = parent_name ? strlen(parent_name) + 3 + name_len : name_len;
+        if (pool_len + name_len + path_len + 2 > pool_cap) {
+            while (pool_len + name_len + path_len + 2 > pool_cap) pool_cap *= 2;
+            char* p = realloc(pool, pool_cap);
+            if (!p) { ok = 0; break; }
+            pool = p;
+        }
+
+        CategoryNode* node = &nodes[count];
+        node->id = sqlite3_column_int(stmt, 0);
+        node->parent_id = parent_id;
+        node->depth = parent_id ? 1 : 0;
+        snprintf(node->type, sizeof(node->type), "%s", type ? type : "");
+
+        name_off[count] = pool_len;
+        memcpy(pool + pool_len, name, name_len + 1);
+        pool_len += name_len + 1;
+        path_off[count] = pool_len;
+        if (parent_name) {
+            pool_len += (size_t)sprintf(pool + pool_len, "%s > %s", parent_name, name) + 1;
+        } else {
+            memcpy(pool + pool_len, name, name_len + 1);
+            pool_len += name_len + 1;
+        }
+
+        if (node->id > max_id) max_id = node->id;
+        count++;
+    }
+    db_release(stmt);
+
+    if (ok) {
+        index_by_id = malloc(sizeof(int) * (max_id + 1));
+        ok = (index_by_id != NULL);
+    }
+    if (ok) {
+        for (int i = 0; i <= max_id; i++) index_by_id[i] = -1;
+        for (int i = 0; i < count; i++) {
+            nodes[i].name = pool + name_off[i];
+            nodes[i].path = pool + path_off[i];
+            index_by_id[nodes[i].id] = i;
+        }
+        // 先序保证父节点已就位
+        for (int i = 0; i < count; i++) {
+            nodes[i].parent_name = nodes[i].parent_id ? nodes[index_by_id[nodes[i].parent_id]].name : NULL;
+        }
+        tree.nodes = nodes;
+        tree.count = count;
+        text_pool = pool;
+        loaded_generation = dim_generation();
+    } else {
+        free(nodes);
+        free(pool);
+        free(index_by_id);
+        index_by_id = NULL;
+        max_id = 0;
+    }
+    free(name_off);
+    free(path_off);
+    return ok;
+}
+
+const CategoryTree* category_tree_get(void) {
+    if (loaded_generation != dim_generation() && !load_tree()) return NULL;
+    return &tree;
+}
+
+const CategoryNode* category_tree_find(int id) {
+    if (!category_tree_get() || id <= 0 || id > max_id || index_by_id[id] < 0) return NULL;
+    return &tree.nodes[index_by_id[id]];
+}
@@ -0,0 +1,26 @@
+// category.h
+#ifndef CATEGORY_H
+#define CATEGORY_H
+
+// 进程内分类树：一次有序查询载入，按先序排列（一级分类后紧跟其子分类），无数量上限
+typedef struct {
+    int id;
+    int parent_id;          // 0 表示一级分类
+    int depth;              // 0 一级，1 二级
+    char type[8];           // income / expense
+    const char* name;
+    const char* parent_name; // 一级分类为 NULL
+    const char* path;       // "父 > 子"，一级分类即名称
+} CategoryNode;
+
+typedef struct {
+    CategoryNode* nodes;
+    int count;
+} CategoryTree;
+
+// 取当前分类树（首次调用或 dim_invalidate() 之后从数据库重新载入），失败返回 NULL
+const CategoryTree* category_tree_get(void);
+// 按 id 查节点（O(1)），不存在返回 NULL
+const CategoryNode* category_tree_find(int id);
+
+#endif
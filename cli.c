@@ -0,0 +1,583 @@
+// cli.c
+// 非交互命令行模式：参数即输入，结果以 CSV 写到 stdout，错误写到 stderr
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "auth.h"
+#include "csv.h"
+#include "money.h"
+#include "finance.h"
+#include "date.h"
+#include "import.h"
+#include "query.h"
+#include "search.h"
+#include "balance.h"
+#include "pivot.h"
+#include "server.h"
+#include "cli.h"
+
+#define CLI_PASSWORD_ENV "FINANCE_PASSWORD"
+
+// 当前命令的输出与错误流（命令行为 stdout/stderr，守护进程为内存缓冲）
+static FILE* cli_out;
+static FILE* cli_err;
+
+// 退出码
+#define CLI_OK 0
+#define CLI_ERROR 1
+#define CLI_USAGE 2
+
+static void print_usage(FILE* fp) {
+    fprintf(fp,
+        "用法: finance_manager [--db 数据库文件] <命令> [选项]\n"
+        "\n"
+        "  add --date YYYY-MM-DD --type income|expense --category 分类 --account 账户\n"
+        "      --amount 金额 [--member 成员] [--remark 备注]     添加记录，输出新记录 ID\n"
+        "  list [--limit N]                                       最近的 N 条记录（默认全部）\n"
+        "  export [--output 文件]                                 导出全部记录（默认写到 stdout）\n"
+        "  import --file 文件                                     批量导入 CSV\n"
+        "  report monthly|yearly                                  月度/年度收支\n"
+        "  report category [--type income|expense]                分类汇总（默认支出）\n"
+        "  query [筛选条件]                                       组合查询，按日期倒序输出记录\n"
+        "  count [筛选条件]                                       组合查询的条数与收支合计\n"
+        "  pivot [--rows 维度] [--cols 维度] [--measure 度量] [筛选条件]\n"
+        "      透视报表（默认按月合计；不按类型分组也不限定 --type 时只统计支出）\n"
+        "      维度: none month quarter year category1 category2 member account type\n"
+        "      度量: sum count avg min max\n"
+        "  search --text 关键词 [--limit N]                       全文搜索备注，按相关度排序\n"
+        "  balance [--date YYYY-MM-DD]                            截至某日（默认今天）各账户余额\n"
+        "  reconcile [--mode check|repair]                        按记录核对账户余额（默认修复）\n"
+        "  serve [--socket 路径] [--workers N]                    守护进程：在 Unix 套接字上接受 JSON 请求\n"
+        "\n"
+        "筛选条件（可任意组合，均为 AND）:\n"
+        "  --date YYYY-MM-DD | --from YYYY-MM-DD --to YYYY-MM-DD  日期或日期区间（含两端）\n"
+        "  --type income|expense  --category 关键词  --account 账户  --member 成员\n"
+        "  --min 金额  --max 金额  --remark 备注包含的文字\n"
+        "\n"
+        "不带参数运行进入交互菜单。非调试构建需通过环境变量 " CLI_PASSWORD_ENV " 提供管理员密码。\n");
+}
+
+// === 选项解析：--name value 成对出现 ===
+typedef struct {
+    int argc;
+    char** argv;
+} CliArgs;
+
+static const char* get_opt(const CliArgs* a, const char* name) {
+    for (int i = 0; i + 1 < a->argc; i += 2) {
+        if (strcmp(a->argv[i] + 2, name) == 0) return a->argv[i + 1];
+    }
+    return NULL;
+}
+
+// 检查选项格式与名称（allowed 以 NULL 结尾）
+static int check_opts(const CliArgs* a, const char* const* allowed) {
+    for (int i = 0; i < a->argc; i += 2) {
+        const char* arg = a->argv[i];
+        if (strncmp(arg, "--", 2) != 0) {
+            fprintf(cli_err, "❌ 无法识别的参数: %s\n", arg);
+            return 0;
+        }
+        int known = 0;
+        for (const char* const* p = allowed; *p; p++) {
+            if (strcmp(arg + 2, *p) == 0) known = 1;
+        }
+        if (!known) {
+            fprintf(cli_err, "❌ 未知选项: %s\n", arg);
+            return 0;
+        }
+        if (i + 1 >= a->argc) {
+            fprintf(cli_err, "❌ 选项 %s 缺少取值\n", arg);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 按名称查 id（可选校验分类类型），找不到返回 0
+static int lookup_id(const char* sql, const char* name, const char* type) {
+    sqlite3* db = db_get();
+    sqlite3_stmt* stmt = db_prepare(db, sql);
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    if (type) sqlite3_bind_text(stmt, 2, type, -1, SQLITE_STATIC);
+    int id = (sqlite3_step(stmt) == SQLITE_ROW) ? sqlite3_column_int(stmt, 0) : 0;
+    db_release(stmt);
+    return id;
+}
+
+static int cmd_add(const CliArgs* a) {
+    static const char* const allowed[] = {
+        "date", "type", "category", "account", "amount", "member", "remark", NULL };
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+
+    const char* date = get_opt(a, "date");
+    const char* type = get_opt(a, "type");
+    const char* category = get_opt(a, "category");
+    const char* account = get_opt(a, "account");
+    const char* amount_text = get_opt(a, "amount");
+    const char* member = get_opt(a, "member");
+    const char* remark = get_opt(a, "remark");
+    if (!date || !type || !category || !account || !amount_text) {
+        fprintf(cli_err, "❌ add 需要 --date --type --category --account --amount\n");
+        return CLI_USAGE;
+    }
+
+    if (!date_is_valid(date)) {
+        fprintf(cli_err, "❌ 日期无效: %s\n", date);
+        return CLI_ERROR;
+    }
+    if (strcmp(type, "income") != 0 && strcmp(type, "expense") != 0) {
+        fprintf(cli_err, "❌ 类型必须是 income 或 expense\n");
+        return CLI_ERROR;
+    }
+    int64_t amount;
+    if (!parse_money(amount_text, &amount) || amount <= 0) {
+        fprintf(cli_err, "❌ 金额必须是大于 0 的数字（最多两位小数）: %s\n", amount_text);
+        return CLI_ERROR;
+    }
+
+    int category_id = lookup_id("SELECT id FROM categories WHERE name = ? AND type = ?;", category, type);
+    if (!category_id) {
+        fprintf(cli_err, "❌ 找不到%s分类: %s\n", strcmp(type, "income") == 0 ? "收入" : "支出", category);
+        return CLI_ERROR;
+    }
+    int account_id = lookup_id("SELECT id FROM accounts WHERE name = ?;", account, NULL);
+    if (!account_id) {
+        fprintf(cli_err, "❌ 找不到账户: %s\n", account);
+        return CLI_ERROR;
+    }
+    int member_id = 0;
+    if (member && member[0]) {
+        member_id = lookup_id("SELECT id FROM members WHERE name = ?;", member, NULL);
+        if (!member_id) {
+            fprintf(cli_err, "❌ 找不到成员: %s\n", member);
+            return CLI_ERROR;
+        }
+    }
+
+    sqlite3_int64 id = insert_record(date, type, category_id, amount, account_id, member_id, remark);
+    if (id <= 0) return CLI_ERROR;
+    fprintf(cli_out, "%lld\n", (long long)id);
+    return CLI_OK;
+}
+
+static int cmd_list(const CliArgs* a) {
+    static const char* const allowed[] = { "limit", NULL };
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+
+    char tail[64] = "ORDER BY r.date DESC, r.id DESC";
+    const char* limit = get_opt(a, "limit");
+    if (limit) {
+        char* end;
+        long n = strtol(limit, &end, 10);
+        if (*end != '\0' || n <= 0) {
+            fprintf(cli_err, "❌ --limit 必须是正整数\n");
+            return CLI_USAGE;
+        }
+        snprintf(tail, sizeof(tail), "ORDER BY r.date DESC, r.id DESC LIMIT %ld", n);
+    }
+    return write_records_csv_where(cli_out, 0, tail, NULL, 0) < 0 ? CLI_ERROR : CLI_OK;
+}
+
+static int cmd_export(const CliArgs* a) {
+    static const char* const allowed[] = { "output", NULL };
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+
+    const char* output = get_opt(a, "output");
+    if (!output) {
+        return write_records_csv_where(cli_out, 0, "ORDER BY r.date, r.id", NULL, 0) < 0 ? CLI_ERROR : CLI_OK;
+    }
+
+    FILE* fp = fopen(output, "wb");
+    if (!fp) {
+        fprintf(cli_err, "❌ 无法创建文件 \"%s\"\n", output);
+        return CLI_ERROR;
+    }
+    long count = write_records_csv(fp);
+    if (fclose(fp) != 0) count = -1;
+    if (count < 0) return CLI_ERROR;
+    fprintf(cli_err, "✅ 导出 %ld 条记录到 \"%s\"\n", count, output);
+    return CLI_OK;
+}
+
+static int cmd_import(const CliArgs* a) {
+    static const char* const allowed[] = { "file", NULL };
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+
+    const char* file = get_opt(a, "file");
+    if (!file) {
+        fprintf(cli_err, "❌ import 需要 --file\n");
+        return CLI_USAGE;
+    }
+
+    ImportStats stats;
+    int ok = import_csv_file(file, &stats, cli_err);
+
+    fprintf(cli_out, "imported,skipped,created_categories,created_accounts,created_members\n");
+    fprintf(cli_out, "%ld,%ld,%d,%d,%d\n", stats.imported, stats.skipped,
+           stats.created_categories, stats.created_accounts, stats.created_members);
+    if (!ok) fprintf(cli_err, "❌ 导入未完成: %s\n", file);
+    return ok ? CLI_OK : CLI_ERROR;
+}
+
+// === report ===
+static void write_period_row(void* ctx, const char* period, int64_t income, int64_t expense) {
+    CsvWriter* w = ctx;
+    csv_write_field(w, period, strlen(period));
+    csv_write_money(w, income);
+    csv_write_money(w, expense);
+    csv_write_money(w, income - expense);
+    csv_end_row(w);
+}
+
+static void write_category_row(void* ctx, const char* category, int64_t total) {
+    CsvWriter* w = ctx;
+    csv_write_field(w, category, strlen(category));
+    csv_write_money(w, total);
+    csv_end_row(w);
+}
+
+static int cmd_report(const char* kind, const CliArgs* a) {
+    static const char* const allowed_period[] = { NULL };
+    static const char* const allowed_category[] = { "type", NULL };
+    int is_category = (strcmp(kind, "category") == 0);
+    if (!is_category && strcmp(kind, "monthly") != 0 && strcmp(kind, "yearly") != 0) {
+        fprintf(cli_err, "❌ 未知报表: %s（可选 monthly / yearly / category）\n", kind);
+        return CLI_USAGE;
+    }
+    if (!check_opts(a, is_category ? allowed_category : allowed_period)) return CLI_USAGE;
+
+    const char* type = get_opt(a, "type");
+    if (!type) type = "expense";
+    if (strcmp(type, "income") != 0 && strcmp(type, "expense") != 0) {
+        fprintf(cli_err, "❌ 类型必须是 income 或 expense\n");
+        return CLI_USAGE;
+    }
+
+    CsvWriter w;
+    if (!csv_writer_init(&w, cli_out)) return CLI_ERROR;
+    int ok;
+    if (is_category) {
+        static const char header[] = "分类,金额\n";
+        csv_write_raw(&w, header, sizeof(header) - 1);
+        ok = report_category_totals(type, write_category_row, &w);
+    } else {
+        int yearly = (strcmp(kind, "yearly") == 0);
+        const char* header = yearly ? "年份,收入,支出,结余\n" : "年月,收入,支出,结余\n";
+        csv_write_raw(&w, header, strlen(header));
+        ok = report_period_totals(yearly, write_period_row, &w);
+    }
+    return (csv_writer_finish(&w) && ok) ? CLI_OK : CLI_ERROR;
+}
+
+// === query / count：选项组合成 RecordFilter ===
+static const char* const filter_opts[] = {
+    "date", "from", "to", "type", "category", "account", "member", "min", "max", "remark", NULL };
+
+static int parse_day_opt(const char* name, const char* text, int32_t* day) {
+    if (!date_parse_days(text, day)) {
+        fprintf(cli_err, "❌ --%s 日期无效: %s\n", name, text);
+        return 0;
+    }
+    return 1;
+}
+
+static int parse_amount_opt(const char* name, const char* text, int64_t* cents) {
+    if (!parse_money(text, cents) || *cents < 0) {
+        fprintf(cli_err, "❌ --%s 金额无效（最多两位小数）: %s\n", name, text);
+        return 0;
+    }
+    return 1;
+}
+
+// 解析成功返回 CLI_OK，否则返回退出码；allowed 为全部可用选项（含筛选条件）
+static int parse_filter(const CliArgs* a, const char* const* allowed, RecordFilter* f) {
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+    record_filter_init(f);
+
+    const char* date = get_opt(a, "date");
+    const char* from = get_opt(a, "from");
+    const char* to = get_opt(a, "to");
+    if (date && (from || to)) {
+        fprintf(cli_err, "❌ --date 不能与 --from/--to 同时使用\n");
+        return CLI_USAGE;
+    }
+    if (date) {
+        if (!parse_day_opt("date", date, &f->day_from)) return CLI_ERROR;
+        f->day_to = f->day_from;
+        f->has_from = f->has_to = 1;
+    }
+    if (from) {
+        if (!parse_day_opt("from", from, &f->day_from)) return CLI_ERROR;
+        f->has_from = 1;
+    }
+    if (to) {
+        if (!parse_day_opt("to", to, &f->day_to)) return CLI_ERROR;
+        f->has_to = 1;
+    }
+
+    f->type = get_opt(a, "type");
+    if (f->type && strcmp(f->type, "income") != 0 && strcmp(f->type, "expense") != 0) {
+        fprintf(cli_err, "❌ 类型必须是 income 或 expense\n");
+        return CLI_USAGE;
+    }
+    f->category_like = get_opt(a, "category");
+
+    const char* account = get_opt(a, "account");
+    if (account) {
+        f->account_id = lookup_id("SELECT id FROM accounts WHERE name = ?;", account, NULL);
+        if (!f->account_id) {
+            fprintf(cli_err, "❌ 找不到账户: %s\n", account);
+            return CLI_ERROR;
+        }
+    }
+    const char* member = get_opt(a, "member");
+    if (member) {
+        f->member_id = lookup_id("SELECT id FROM members WHERE name = ?;", member, NULL);
+        if (!f->member_id) {
+            fprintf(cli_err, "❌ 找不到成员: %s\n", member);
+            return CLI_ERROR;
+        }
+    }
+
+    const char* min = get_opt(a, "min");
+    const char* max = get_opt(a, "max");
+    if (min) {
+        if (!parse_amount_opt("min", min, &f->amount_min)) return CLI_ERROR;
+        f->has_min = 1;
+    }
+    if (max) {
+        if (!parse_amount_opt("max", max, &f->amount_max)) return CLI_ERROR;
+        f->has_max = 1;
+    }
+    f->remark = get_opt(a, "remark");
+    return CLI_OK;
+}
+
+static int cmd_query(const CliArgs* a) {
+    RecordFilter f;
+    int rc = parse_filter(a, filter_opts, &f);
+    if (rc != CLI_OK) return rc;
+    return record_query_csv(&f, cli_out, 0, cli_err) < 0 ? CLI_ERROR : CLI_OK;
+}
+
+static int cmd_count(const CliArgs* a) {
+    RecordFilter f;
+    int rc = parse_filter(a, filter_opts, &f);
+    if (rc != CLI_OK) return rc;
+
+    QueryTotals t;
+    if (!record_query_count(&f, &t, cli_err)) return CLI_ERROR;
+
+    CsvWriter w;
+    if (!csv_writer_init(&w, cli_out)) return CLI_ERROR;
+    static const char header[] = "条数,收入,支出,结余\n";
+    csv_write_raw(&w, header, sizeof(header) - 1);
+    csv_write_int(&w, t.count);
+    csv_write_money(&w, t.income);
+    csv_write_money(&w, t.expense);
+    csv_write_money(&w, t.income - t.expense);
+    csv_end_row(&w);
+    return csv_writer_finish(&w) ? CLI_OK : CLI_ERROR;
+}
+
+// === pivot：行维度 × 列维度 × 度量，另可加筛选条件 ===
+static const char* const pivot_opts[] = {
+    "rows", "cols", "measure",
+    "date", "from", "to", "type", "category", "account", "member", "min", "max", "remark", NULL };
+
+static int cmd_pivot(const CliArgs* a) {
+    PivotSpec spec;
+    int rc = parse_filter(a, pivot_opts, &spec.filter);
+    if (rc != CLI_OK) return rc;
+
+    const char* rows = get_opt(a, "rows");
+    const char* cols = get_opt(a, "cols");
+    const char* measure = get_opt(a, "measure");
+    spec.rows = rows ? pivot_dim_parse(rows) : PIVOT_DIM_MONTH;
+    spec.cols = cols ? pivot_dim_parse(cols) : PIVOT_DIM_NONE;
+    spec.measure = measure ? pivot_measure_parse(measure) : PIVOT_MEASURE_SUM;
+    if (spec.rows < 0 || spec.cols < 0) {
+        fprintf(cli_err, "❌ 维度可选: none month quarter year category1 category2 member account type\n");
+        return CLI_USAGE;
+    }
+    if (spec.measure < 0) {
+        fprintf(cli_err, "❌ 度量可选: sum count avg min max\n");
+        return CLI_USAGE;
+    }
+    return pivot_write_csv(&spec, cli_out, 0, cli_err) ? CLI_OK : CLI_ERROR;
+}
+
+static int cmd_search(const CliArgs* a) {
+    static const char* const allowed[] = { "text", "limit", NULL };
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+
+    const char* text = get_opt(a, "text");
+    if (!text) {
+        fprintf(cli_err, "❌ search 需要 --text\n");
+        return CLI_USAGE;
+    }
+    long limit = 0;
+    const char* limit_text = get_opt(a, "limit");
+    if (limit_text) {
+        char* end;
+        limit = strtol(limit_text, &end, 10);
+        if (*end != '\0' || limit <= 0 || limit > INT_MAX) {
+            fprintf(cli_err, "❌ --limit 必须是正整数\n");
+            return CLI_USAGE;
+        }
+    }
+    return search_remarks_csv(text, (int)limit, cli_out, 0, cli_err) < 0 ? CLI_ERROR : CLI_OK;
+}
+
+static void write_balance_row(void* ctx, const char* account, int64_t balance) {
+    CsvWriter* w = ctx;
+    csv_write_field(w, account, strlen(account));
+    csv_write_money(w, balance);
+    csv_end_row(w);
+}
+
+static int cmd_balance(const CliArgs* a) {
+    static const char* const allowed[] = { "date", NULL };
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+
+    const char* date = get_opt(a, "date");
+    if (date && !date_is_valid(date)) {
+        fprintf(cli_err, "❌ 日期无效: %s（应为 YYYY-MM-DD）\n", date);
+        return CLI_USAGE;
+    }
+
+    CsvWriter w;
+    if (!csv_writer_init(&w, cli_out)) return CLI_ERROR;
+    static const char header[] = "账户,余额\n";
+    csv_write_raw(&w, header, sizeof(header) - 1);
+    int ok = balance_as_of(date, write_balance_row, &w, cli_err);
+    return (csv_writer_finish(&w) && ok) ? CLI_OK : CLI_ERROR;
+}
+
+static void write_reconcile_row(void* ctx, const char* account, int64_t stored, int64_t computed) {
+    CsvWriter* w = ctx;
+    csv_write_field(w, account, strlen(account));
+    csv_write_money(w, stored);
+    csv_write_money(w, computed);
+    csv_write_money(w, stored - computed);
+    csv_end_row(w);
+}
+
+static int cmd_reconcile(const CliArgs* a) {
+    static const char* const allowed[] = { "mode", NULL };
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+
+    const char* mode = get_opt(a, "mode");
+    if (!mode) mode = "repair";
+    if (strcmp(mode, "check") != 0 && strcmp(mode, "repair") != 0) {
+        fprintf(cli_err, "❌ --mode 必须是 check 或 repair\n");
+        return CLI_USAGE;
+    }
+    int repair = (strcmp(mode, "repair") == 0);
+
+    CsvWriter w;
+    if (!csv_writer_init(&w, cli_out)) return CLI_ERROR;
+    static const char header[] = "账户,账面余额,重算余额,差额\n";
+    csv_write_raw(&w, header, sizeof(header) - 1);
+    ReconcileStats stats;
+    int ok = reconcile_balances(repair, write_reconcile_row, &w, &stats, cli_err);
+    if (!csv_writer_finish(&w) || !ok) return CLI_ERROR;
+
+    fprintf(cli_err, "%s %d 个账户余额、%d 个月度检查点不一致%s\n",
+            (stats.accounts_fixed || stats.months_fixed) ? "⚠️" : "✅",
+            stats.accounts_fixed, stats.months_fixed,
+            (repair && (stats.accounts_fixed || stats.months_fixed)) ? "，已修复" : "");
+    return CLI_OK;
+}
+
+int cli_execute(const char* cmd, int argc, char** argv, FILE* out, FILE* err) {
+    cli_out = out;
+    cli_err = err;
+
+    if (strcmp(cmd, "report") == 0) {
+        if (argc < 1) {
+            fprintf(cli_err, "❌ report 需要报表类型（monthly / yearly / category）\n");
+            return CLI_USAGE;
+        }
+        CliArgs a = { argc - 1, argv + 1 };
+        return cmd_report(argv[0], &a);
+    }
+
+    CliArgs a = { argc, argv };
+    if (strcmp(cmd, "add") == 0) return cmd_add(&a);
+    if (strcmp(cmd, "list") == 0) return cmd_list(&a);
+    if (strcmp(cmd, "export") == 0) return cmd_export(&a);
+    if (strcmp(cmd, "import") == 0) return cmd_import(&a);
+    if (strcmp(cmd, "query") == 0) return cmd_query(&a);
+    if (strcmp(cmd, "count") == 0) return cmd_count(&a);
+    if (strcmp(cmd, "pivot") == 0) return cmd_pivot(&a);
+    if (strcmp(cmd, "search") == 0) return cmd_search(&a);
+    if (strcmp(cmd, "balance") == 0) return cmd_balance(&a);
+    if (strcmp(cmd, "reconcile") == 0) return cmd_reconcile(&a);
+
+    fprintf(cli_err, "❌ 未知命令: %s\n", cmd);
+    print_usage(cli_err);
+    return CLI_USAGE;
+}
+
+static int cmd_serve(const CliArgs* a) {
+    static const char* const allowed[] = { "socket", "workers", NULL };
+    cli_err = stderr;
+    if (!check_opts(a, allowed)) return CLI_USAGE;
+
+    const char* socket_path = get_opt(a, "socket");
+    if (!socket_path) socket_path = SERVER_SOCKET_NAME;
+    long workers = SERVER_DEFAULT_WORKERS;
+    const char* workers_text = get_opt(a, "workers");
+    if (workers_text) {
+        char* end;
+        workers = strtol(workers_text, &end, 10);
+        if (*end != '\0' || workers <= 0 || workers > SERVER_MAX_WORKERS) {
+            fprintf(stderr, "❌ --workers 必须是 1～%d 的整数\n", SERVER_MAX_WORKERS);
+            return CLI_USAGE;
+        }
+    }
+    return server_run(socket_path, (int)workers) ? CLI_OK : CLI_ERROR;
+}
+
+int cli_main(int argc, char** argv) {
+    const char* db_path = DATABASE_NAME;
+    int i = 1;
+    if (i + 1 < argc && strcmp(argv[i], "--db") == 0) {
+        db_path = argv[i + 1];
+        i += 2;
+    }
+    if (i >= argc || strcmp(argv[i], "help") == 0 || strcmp(argv[i], "--help") == 0) {
+        print_usage(stderr);
+        return (i >= argc) ? CLI_USAGE : CLI_OK;
+    }
+
+    if (!db_open(db_path)) return CLI_ERROR;
+
+#ifndef DEBUG_MODE
+    const char* password = getenv(CLI_PASSWORD_ENV);
+    if (!password) {
+        fprintf(stderr, "❌ 请通过环境变量 %s 提供管理员密码\n", CLI_PASSWORD_ENV);
+    }
+    if (!password || !login_noninteractive(password)) {
+        db_close();
+        return CLI_ERROR;
+    }
+#endif
+
+    init_finance_database();
+    int rc;
+    if (strcmp(argv[i], "serve") == 0) {
+        CliArgs a = { argc - i - 1, argv + i + 1 };
+        rc = cmd_serve(&a);
+    } else {
+        rc = cli_execute(argv[i], argc - i - 1, argv + i + 1, stdout, stderr);
+    }
+    db_close();
+    return rc;
+}
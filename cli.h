@@ -0,0 +1,14 @@
+// cli.h
+#ifndef CLI_H
+#define CLI_H
+
+#include <stdio.h>
+
+// 命令行模式入口（main 收到参数时调用），返回进程退出码
+int cli_main(int argc, char** argv);
+
+// 执行一条已登录、数据库已初始化后的命令（cmd 后跟 --name value 成对参数），
+// 结果写 out、错误写 err，返回退出码；守护进程用它处理每个请求
+int cli_execute(const char* cmd, int argc, char** argv, FILE* out, FILE* err);
+
+#endif
@@ -0,0 +1,241 @@
+// csv.c
+#include <stdlib.h>
+#include <string.h>
+#include "csv.h"
+#include "money.h"
+
+#define CSV_READ_BUF_SIZE (1 << 20)
+#define CSV_WRITE_BUF_SIZE (1 << 20)
+
+int csv_reader_open(CsvReader* r, const char* path) {
+    memset(r, 0, sizeof(*r));
+    r->fp = fopen(path, "rb");
+    if (!r->fp) return 0;
+
+    r->buf = malloc(CSV_READ_BUF_SIZE);
+    r->rec_cap = 1024;
+    r->rec = malloc(r->rec_cap);
+    r->field_cap = 16;
+    r->offsets = malloc(sizeof(size_t) * r->field_cap);
+    r->fields = malloc(sizeof(const char*) * r->field_cap);
+    if (!r->buf || !r->rec || !r->offsets || !r->fields) {
+        csv_reader_close(r);
+        return 0;
+    }
+    r->next_line = 1;
+
+    r->buf_len = fread(r->buf, 1, CSV_READ_BUF_SIZE, r->fp);
+    if (r->buf_len >= 3 && memcmp(r->buf, "\xEF\xBB\xBF", 3) == 0) {
+        r->buf_pos = 3;
+    }
+    return 1;
+}
+
+void csv_reader_close(CsvReader* r) {
+    if (r->fp) fclose(r->fp);
+    free(r->buf);
+    free(r->rec);
+    free(r->offsets);
+    free(r->fields);
+    memset(r, 0, sizeof(*r));
+}
+
+// 取下一个字节，缓冲读完时整块补充；文件结束返回 EOF
+static inline int next_byte(CsvReader* r) {
+    if (r->buf_pos >= r->buf_len) {
+        r->buf_len = fread(r->buf, 1, CSV_READ_BUF_SIZE, r->fp);
+        r->buf_pos = 0;
+        if (r->buf_len == 0) return EOF;
+    }
+    return (unsigned char)r->buf[r->buf_pos++];
+}
+
+static inline int peek_byte(CsvReader* r) {
+    int c = next_byte(r);
+    if (c != EOF) r->buf_pos--;
+    return c;
+}
+
+static inline int put_byte(CsvReader* r, char c) {
+    if (r->rec_len == r->rec_cap) {
+        char* grown = realloc(r->rec, r->rec_cap * 2);
+        if (!grown) return 0;
+        r->rec = grown;
+        r->rec_cap *= 2;
+    }
+    r->rec[r->rec_len++] = c;
+    return 1;
+}
+
+static int begin_field(CsvReader* r) {
+    if (r->field_count == r->field_cap) {
+        int cap = r->field_cap * 2;
+        size_t* offsets = realloc(r->offsets, sizeof(size_t) * cap);
+        if (!offsets) return 0;
+        r->offsets = offsets;
+        const char** fields = realloc(r->fields, sizeof(const char*) * cap);
+        if (!fields) return 0;
+        r->fields = fields;
+        r->field_cap = cap;
+    }
+    r->offsets[r->field_count++] = r->rec_len;
+    return 1;
+}
+
+// 字段全部读完后再生成指针（rec 在读取过程中可能被 realloc）
+static void finish_record(CsvReader* r) {
+    for (int i = 0; i < r->field_count; i++) {
+        r->fields[i] = r->rec + r->offsets[i];
+    }
+}
+
+int csv_read_record(CsvReader* r) {
+    int c;
+
+    // 跳过空行
+    for (;;) {
+        c = next_byte(r);
+        if (c == EOF) return 0;
+        if (c == '\n') { r->next_line++; continue; }
+        if (c == '\r') continue;
+        break;
+    }
+
+    r->rec_len = 0;
+    r->field_count = 0;
+    r->line = r->next_line;
+    if (!begin_field(r)) return -1;
+
+    int in_quotes = 0;
+    for (;; c = next_byte(r)) {
+        if (in_quotes) {
+            if (c == EOF) return -1;                    // 引号未闭合
+            if (c == '"') {
+                if (peek_byte(r) == '"') {
+                    next_byte(r);
+                    if (!put_byte(r, '"')) return -1;
+                } else {
+                    in_quotes = 0;
+                }
+                continue;
+            }
+            if (c == '\n') r->next_line++;
+            if (!put_byte(r, (char)c)) return -1;
+            continue;
+        }
+
+        if (c == EOF || c == '\n' || c == '\r') {
+            if (c == '\r' && peek_byte(r) == '\n') next_byte(r);
+            if (c != EOF) r->next_line++;
+            if (!put_byte(r, '\0')) return -1;
+            finish_record(r);
+            return 1;
+        }
+        if (c == ',') {
+            if (!put_byte(r, '\0') || !begin_field(r)) return -1;
+        } else if (c == '"' && r->rec_len == r->offsets[r->field_count - 1]) {
+            in_quotes = 1;                              // 仅字段开头的引号表示引用字段
+        } else {
+            if (!put_byte(r, (char)c)) return -1;
+        }
+    }
+}
+
+// === 写入 ===
+
+int csv_writer_init(CsvWriter* w, FILE* fp) {
+    memset(w, 0, sizeof(*w));
+    w->fp = fp;
+    w->cap = CSV_WRITE_BUF_SIZE;
+    w->buf = malloc(w->cap);
+    return w->buf != NULL;
+}
+
+static void flush_buffer(CsvWriter* w) {
+    if (w->len > 0 && fwrite(w->buf, 1, w->len, w->fp) != w->len) {
+        w->error = 1;
+    }
+    w->len = 0;
+}
+
+// 保证缓冲至少还有 n 字节空间（n 不超过 cap）
+static inline void reserve(CsvWriter* w, size_t n) {
+    if (w->cap - w->len < n) flush_buffer(w);
+}
+
+static inline void begin_column(CsvWriter* w) {
+    if (w->col++ > 0) {
+        reserve(w, 1);
+        w->buf[w->len++] = ',';
+    }
+}
+
+void csv_write_raw(CsvWriter* w, const char* s, size_t n) {
+    if (n >= w->cap) {
+        flush_buffer(w);
+        if (fwrite(s, 1, n, w->fp) != n) w->error = 1;
+        return;
+    }
+    reserve(w, n);
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+void csv_write_field(CsvWriter* w, const char* s, size_t n) {
+    begin_column(w);
+    if (!s || n == 0) return;
+
+    size_t i = 0;
+    while (i < n && s[i] != '"' && s[i] != ',' && s[i] != '\n' && s[i] != '\r') i++;
+    if (i == n) {
+        csv_write_raw(w, s, n);     // 常见情况：无需引号，整段拷贝
+        return;
+    }
+
+    // 需要引号：逐段拷贝，遇到 '"' 时写成 '""'，长度不受限制
+    reserve(w, 1);
+    w->buf[w->len++] = '"';
+    size_t start = 0;
+    for (i = 0; i < n; i++) {
+        if (s[i] == '"') {
+            csv_write_raw(w, s + start, i + 1 - start);
+            start = i;              // 引号本身在下一段开头再写一次
+        }
+    }
+    csv_write_raw(w, s + start, n - start);
+    reserve(w, 1);
+    w->buf[w->len++] = '"';
+}
+
+void csv_write_int(CsvWriter* w, int64_t v) {
+    begin_column(w);
+    char tmp[24];
+    int pos = sizeof(tmp);
+    uint64_t u = (v < 0) ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+    do {
+        tmp[--pos] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u > 0);
+    if (v < 0) tmp[--pos] = '-';
+    csv_write_raw(w, tmp + pos, sizeof(tmp) - (size_t)pos);
+}
+
+void csv_write_money(CsvWriter* w, int64_t cents) {
+    begin_column(w);
+    reserve(w, MONEY_BUF_SIZE);
+    w->len += format_money(cents, w->buf + w->len, MONEY_BUF_SIZE);
+}
+
+void csv_end_row(CsvWriter* w) {
+    reserve(w, 1);
+    w->buf[w->len++] = '\n';
+    w->col = 0;
+}
+
+int csv_writer_finish(CsvWriter* w) {
+    flush_buffer(w);
+    if (fflush(w->fp) != 0) w->error = 1;
+    free(w->buf);
+    w->buf = NULL;
+    return !w->error;
+}
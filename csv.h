@@ -0,0 +1,49 @@
+// csv.h
+#ifndef CSV_H
+#define CSV_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 流式 CSV 读取器：大块读入，按 RFC 4180 解析引号、"" 转义与字段内换行
+// 字段指针只在下一次 csv_read_record 之前有效
+typedef struct {
+    FILE* fp;
+    char* buf;              // 读缓冲
+    size_t buf_len;
+    size_t buf_pos;
+    char* rec;              // 当前记录的字段内容，各字段以 '\0' 结尾
+    size_t rec_len;
+    size_t rec_cap;
+    size_t* offsets;        // 各字段在 rec 中的起始偏移
+    const char** fields;
+    int field_count;
+    int field_cap;
+    long line;              // 当前记录起始行号（从 1 开始）
+    long next_line;
+} CsvReader;
+
+int csv_reader_open(CsvReader* r, const char* path);   // 自动跳过 UTF-8 BOM
+int csv_read_record(CsvReader* r);                     // 1 读到记录，0 文件结束，-1 格式错误
+void csv_reader_close(CsvReader* r);
+
+// 流式 CSV 写入器：字段直接转义进大块输出缓冲，缓冲满时一次 fwrite
+typedef struct {
+    FILE* fp;
+    char* buf;
+    size_t len;
+    size_t cap;
+    int col;                // 当前行已写字段数（决定是否补逗号）
+    int error;              // 任一次写入失败即置位
+} CsvWriter;
+
+int csv_writer_init(CsvWriter* w, FILE* fp);            // 不接管 fp 的关闭
+void csv_write_raw(CsvWriter* w, const char* s, size_t n);
+void csv_write_field(CsvWriter* w, const char* s, size_t n);   // s 可为 NULL（空字段）
+void csv_write_int(CsvWriter* w, int64_t v);
+void csv_write_money(CsvWriter* w, int64_t cents);
+void csv_end_row(CsvWriter* w);
+int csv_writer_finish(CsvWriter* w);                   // 刷新并释放缓冲，返回 1 表示全部写入成功
+
+#endif
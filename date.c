@@ -0,0 +1,95 @@
+// date.c
+#include <stddef.h>
+#include "date.h"
+
+#define IS_LEAP(y) (((y) % 4 == 0 && (y) % 100 != 0) || (y) % 400 == 0)
+
+// [是否闰年][月份]，下标 0 不用
+static const uint8_t month_days[2][13] = {
+    { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 },
+    { 0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 },
+};
+
+int date_days_in_month(int year, int month) {
+    if (month < 1 || month > 12) return 0;
+    return month_days[IS_LEAP(year)][month];
+}
+
+// 定长解析：8 个数字位逐位减 '0' 后按位或检查越界，中间不分支
+int date_parse(const char* s, Date* out) {
+    if (!s) return 0;
+    unsigned d[10];
+    unsigned bad = 0;
+    for (int i = 0; i < DATE_TEXT_LEN; i++) {
+        d[i] = (unsigned char)s[i] - '0';
+        if (s[i] == '\0') return 0;     // 过短（不读越界）
+    }
+    bad |= (d[0] > 9) | (d[1] > 9) | (d[2] > 9) | (d[3] > 9)
+         | (d[5] > 9) | (d[6] > 9) | (d[8] > 9) | (d[9] > 9);
+    bad |= (s[4] != '-') | (s[7] != '-') | (s[DATE_TEXT_LEN] != '\0');
+    if (bad) return 0;
+
+    int year = (int)(d[0] * 1000 + d[1] * 100 + d[2] * 10 + d[3]);
+    int month = (int)(d[5] * 10 + d[6]);
+    int day = (int)(d[8] * 10 + d[9]);
+    if (year < DATE_MIN_YEAR || year > DATE_MAX_YEAR) return 0;
+    if ((unsigned)(month - 1) > 11u) return 0;
+    if ((unsigned)(day - 1) >= month_days[IS_LEAP(year)][month]) return 0;
+
+    if (out) {
+        out->year = year;
+        out->month = month;
+        out->day = day;
+    }
+    return 1;
+}
+
+int date_is_valid(const char* s) {
+    return date_parse(s, NULL);
+}
+
+int date_parse_days(const char* s, int32_t* days) {
+    Date d;
+    if (!date_parse(s, &d)) return 0;
+    *days = date_to_days(d.year, d.month, d.day);
+    return 1;
+}
+
+// 公历 -> 天数（以 3 月为年首，闰日落在年末，免去月份表查找）
+int32_t date_to_days(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void date_from_days(int32_t days, Date* out) {
+    int z = days + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int doe = z - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    out->day = doy - (153 * mp + 2) / 5 + 1;
+    out->month = mp < 10 ? mp + 3 : mp - 9;
+    out->year = yoe + era * 400 + (out->month <= 2);
+}
+
+void date_format(int32_t days, char* out) {
+    Date d;
+    date_from_days(days, &d);
+    int y = d.year;
+    out[0] = (char)('0' + y / 1000 % 10);
+    out[1] = (char)('0' + y / 100 % 10);
+    out[2] = (char)('0' + y / 10 % 10);
+    out[3] = (char)('0' + y % 10);
+    out[4] = '-';
+    out[5] = (char)('0' + d.month / 10);
+    out[6] = (char)('0' + d.month % 10);
+    out[7] = '-';
+    out[8] = (char)('0' + d.day / 10);
+    out[9] = (char)('0' + d.day % 10);
+    out[10] = '\0';
+}
@@ -0,0 +1,30 @@
+// date.h
+#ifndef DATE_H
+#define DATE_H
+
+#include <stdint.h>
+
+// 日期统一为 "YYYY-MM-DD" 文本；计算时用 1970-01-01 起的天数（records.day 生成列同此编码）
+#define DATE_TEXT_LEN  10
+#define DATE_MIN_YEAR  1900
+#define DATE_MAX_YEAR  2100
+
+typedef struct {
+    int year;
+    int month;
+    int day;
+} Date;
+
+// 严格解析定长 "YYYY-MM-DD"（含闰年与月份天数校验），成功返回 1；out 可为 NULL
+int date_parse(const char* s, Date* out);
+int date_is_valid(const char* s);
+// 解析并转换为天数
+int date_parse_days(const char* s, int32_t* days);
+
+int32_t date_to_days(int year, int month, int day);
+void date_from_days(int32_t days, Date* out);
+// 写出 "YYYY-MM-DD"，out 至少 DATE_TEXT_LEN + 1 字节
+void date_format(int32_t days, char* out);
+int date_days_in_month(int year, int month);
+
+#endif
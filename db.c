@@ -0,0 +1,281 @@
+// db.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "db.h"
+
+// 全局唯一连接（所有模块通过 db_get() 共享）
+static sqlite3* g_db = NULL;
+
+// === 预编译语句缓存 ===
+// 开放寻址哈希表，键为 SQL 文本；只缓存共享连接上的语句
+#define STMT_CACHE_SIZE 256   // 必须是 2 的幂，远大于程序中的 SQL 条数
+
+typedef struct {
+    char* sql;              // NULL 表示空槽
+    sqlite3_stmt* stmt;
+    int in_use;             // 已被取出尚未归还
+} StmtCacheEntry;
+
+static StmtCacheEntry g_cache[STMT_CACHE_SIZE];
+static int g_cache_count = 0;
+static long g_cache_hits = 0;
+static long g_cache_misses = 0;
+
+// === 外部提交检测 ===
+// PRAGMA data_version 只随其他连接（含其他进程）的提交变化；共享连接每次取语句前比对一次，
+// 变化时计数加一，进程内缓存把该计数并入自己的代数，从而发现其他终端的修改
+static sqlite3_stmt* g_version_stmt = NULL;
+static int g_seen_data_version = -1;
+static unsigned g_external_commits = 0;
+
+static void check_data_version(void) {
+    if (!g_version_stmt &&
+        sqlite3_prepare_v2(g_db, "PRAGMA data_version;", -1, &g_version_stmt, NULL) != SQLITE_OK) {
+        sqlite3_finalize(g_version_stmt);
+        g_version_stmt = NULL;
+        return;
+    }
+    if (sqlite3_step(g_version_stmt) == SQLITE_ROW) {
+        int version = sqlite3_column_int(g_version_stmt, 0);
+        if (g_seen_data_version >= 0 && version != g_seen_data_version) g_external_commits++;
+        g_seen_data_version = version;
+    }
+    sqlite3_reset(g_version_stmt);
+}
+
+unsigned db_external_commits(void) {
+    return g_external_commits;
+}
+
+// FNV-1a 字符串哈希
+static unsigned int hash_sql(const char* s) {
+    unsigned int h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 查找 SQL 对应的槽位（找到返回该槽，否则返回可插入的空槽；表满返回 NULL）
+static StmtCacheEntry* cache_slot(const char* sql) {
+    unsigned int mask = STMT_CACHE_SIZE - 1;
+    unsigned int i = hash_sql(sql) & mask;
+    for (int probe = 0; probe < STMT_CACHE_SIZE; probe++) {
+        StmtCacheEntry* e = &g_cache[(i + probe) & mask];
+        if (!e->sql || strcmp(e->sql, sql) == 0) return e;
+    }
+    return NULL;
+}
+
+static void cache_clear(void) {
+    for (int i = 0; i < STMT_CACHE_SIZE; i++) {
+        if (g_cache[i].sql) {
+            sqlite3_finalize(g_cache[i].stmt);
+            free(g_cache[i].sql);
+        }
+    }
+    memset(g_cache, 0, sizeof(g_cache));
+    g_cache_count = 0;
+}
+
+// === 性能配置 ===
+// 新建数据库的页大小（只能在写入第一张表之前设置）
+#define DB_NEW_PAGE_SIZE 8192
+
+static const DbProfileSpec g_profiles[DB_PROFILE_COUNT] = {
+    { "安全（回滚日志，每次提交完整同步）", "DELETE", "FULL",   2000,  0,                    "DEFAULT" },
+    { "均衡（WAL，推荐）",                  "WAL",    "NORMAL", 16384, 64LL * 1024 * 1024,   "MEMORY"  },
+    { "高性能（WAL，大缓存与内存映射）",    "WAL",    "NORMAL", 65536, 256LL * 1024 * 1024,  "MEMORY"  },
+};
+
+static int g_profile = DB_PROFILE_BALANCED;
+
+const DbProfileSpec* db_profile_spec(int profile) {
+    if (profile < 0 || profile >= DB_PROFILE_COUNT) return NULL;
+    return &g_profiles[profile];
+}
+
+// 把配置应用到任意连接（只读连接上 journal_mode 设置失败可忽略）
+int db_apply_profile(sqlite3* db, int profile) {
+    const DbProfileSpec* p = db_profile_spec(profile);
+    if (!db || !p) return 0;
+
+    char sql[512];
+    snprintf(sql, sizeof(sql),
+             "PRAGMA journal_mode = %s;"
+             "PRAGMA synchronous = %s;"
+             "PRAGMA cache_size = -%d;"
+             "PRAGMA mmap_size = %lld;"
+             "PRAGMA temp_store = %s;",
+             p->journal_mode, p->synchronous, p->cache_size_kb, p->mmap_size, p->temp_store);
+    return sqlite3_exec(db, sql, NULL, NULL, NULL) == SQLITE_OK;
+}
+
+int db_current_profile(void) {
+    return g_profile;
+}
+
+// 切换共享连接的配置并持久化
+int db_set_profile(int profile) {
+    if (!db_profile_spec(profile)) return 0;
+    if (!db_apply_profile(g_db, profile)) return 0;
+    g_profile = profile;
+    return db_set_setting_int("db_profile", profile);
+}
+
+// 打开数据库并完成连接级初始化（重复调用安全）
+int db_open(const char* path) {
+    if (g_db) return 1;
+
+    if (sqlite3_open(path, &g_db) != SQLITE_OK) {
+        fprintf(stderr, "❌ 无法打开数据库: %s\n", g_db ? sqlite3_errmsg(g_db) : "内存不足");
+        sqlite3_close(g_db);
+        g_db = NULL;
+        return 0;
+    }
+
+    // 全新数据库：先设置页大小（必须在切换 WAL 和建表之前）
+    int is_new = 0;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(g_db, "PRAGMA page_count;", -1, &stmt, NULL) == SQLITE_OK) {
+        is_new = (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) == 0);
+        sqlite3_finalize(stmt);
+    }
+    if (is_new) {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "PRAGMA page_size = %d;", DB_NEW_PAGE_SIZE);
+        sqlite3_exec(g_db, sql, NULL, NULL, NULL);
+    }
+
+    // 外键约束是连接级设置，必须在每个连接上启用
+    sqlite3_exec(g_db, "PRAGMA foreign_keys = ON;", NULL, NULL, NULL);
+
+    // 应用已保存的性能配置（首次运行 app_settings 尚不存在，使用默认）
+    int profile = db_get_setting_int("db_profile", DB_PROFILE_BALANCED);
+    if (!db_profile_spec(profile)) profile = DB_PROFILE_BALANCED;
+    if (db_apply_profile(g_db, profile)) g_profile = profile;
+    return 1;
+}
+
+// 获取共享连接（未打开时返回 NULL）
+sqlite3* db_get(void) {
+    return g_db;
+}
+
+// 关闭共享连接（退出前调用，先释放所有缓存语句）
+void db_close(void) {
+    if (!g_db) return;
+    cache_clear();
+    sqlite3_finalize(g_version_stmt);
+    g_version_stmt = NULL;
+    g_seen_data_version = -1;
+    sqlite3_close(g_db);
+    g_db = NULL;
+}
+
+// 取出预编译语句：命中缓存时直接复用，否则编译并放入缓存
+// 同一条 SQL 正在使用中（嵌套调用）或非共享连接时，返回不入缓存的临时语句
+sqlite3_stmt* db_prepare(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = NULL;
+    if (!db || !sql) return NULL;
+    if (db == g_db) check_data_version();
+
+    StmtCacheEntry* e = (db == g_db) ? cache_slot(sql) : NULL;
+    if (e && e->sql && !e->in_use) {
+        e->in_use = 1;
+        g_cache_hits++;
+        return e->stmt;
+    }
+
+    g_cache_misses++;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return NULL;
+    }
+
+    // 表未满且该 SQL 尚未缓存时才入缓存（保留一半空槽以保证探测长度）
+    // sqlite3_sql() 与原文不一致时（如分号后有多余字符）无法在归还时定位，不缓存
+    if (e && !e->sql && g_cache_count < STMT_CACHE_SIZE / 2 &&
+        strcmp(sqlite3_sql(stmt), sql) == 0) {
+        e->sql = malloc(strlen(sql) + 1);
+        if (e->sql) {
+            strcpy(e->sql, sql);
+            e->stmt = stmt;
+            e->in_use = 1;
+            g_cache_count++;
+        }
+    }
+    return stmt;
+}
+
+// 归还语句：缓存中的语句 reset + 清空绑定以便复用，临时语句直接 finalize
+void db_release(sqlite3_stmt* stmt) {
+    if (!stmt) return;
+
+    if (sqlite3_db_handle(stmt) == g_db) {
+        StmtCacheEntry* e = cache_slot(sqlite3_sql(stmt));
+        if (e && e->stmt == stmt) {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            e->in_use = 0;
+            return;
+        }
+    }
+    sqlite3_finalize(stmt);
+}
+
+// 读取缓存命中统计
+void db_stmt_cache_stats(StmtCacheStats* out) {
+    if (!out) return;
+    out->hits = g_cache_hits;
+    out->misses = g_cache_misses;
+    out->cached = g_cache_count;
+}
+
+// 读取配置项（存在返回 1，并复制到 out）
+int db_get_setting(const char* key, char* out, size_t out_size) {
+    if (!g_db || !key || !out || out_size == 0) return 0;
+
+    sqlite3_stmt* stmt = db_prepare(g_db, "SELECT value FROM app_settings WHERE key = ?;");
+    if (!stmt) return 0; // 表尚未创建时视为不存在
+
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+    int found = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* value = (const char*)sqlite3_column_text(stmt, 0);
+        snprintf(out, out_size, "%s", value ? value : "");
+        found = 1;
+    }
+    db_release(stmt);
+    return found;
+}
+
+int db_get_setting_int(const char* key, int default_value) {
+    char buf[32];
+    if (!db_get_setting(key, buf, sizeof(buf))) return default_value;
+    return atoi(buf);
+}
+
+// 写入配置项（存在则覆盖）
+int db_set_setting(const char* key, const char* value) {
+    if (!g_db || !key || !value) return 0;
+
+    sqlite3_stmt* stmt = db_prepare(g_db,
+        "INSERT INTO app_settings (key, value) VALUES (?, ?) "
+        "ON CONFLICT(key) DO UPDATE SET value = excluded.value;");
+    if (!stmt) return 0;
+
+    sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, value, -1, SQLITE_STATIC);
+    int ok = (sqlite3_step(stmt) == SQLITE_DONE);
+    db_release(stmt);
+    return ok;
+}
+
+int db_set_setting_int(const char* key, int value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d", value);
+    return db_set_setting(key, buf);
+}
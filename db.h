@@ -0,0 +1,57 @@
+// db.h
+#ifndef DB_H
+#define DB_H
+
+#include <stddef.h>
+#include "sqlite3.h"
+
+#define DATABASE_NAME "finance.db"
+
+// 进程级数据库连接：main 启动时打开一次，退出前关闭
+int db_open(const char* path);
+sqlite3* db_get(void);
+void db_close(void);
+
+// 性能配置（PRAGMA 组合），对每个连接生效，选择结果持久化在 app_settings
+#define DB_PROFILE_SAFE        0   // 回滚日志 + FULL 同步（默认 SQLite 行为）
+#define DB_PROFILE_BALANCED    1   // WAL + NORMAL（默认）
+#define DB_PROFILE_PERFORMANCE 2   // WAL + NORMAL + 大缓存/大 mmap
+#define DB_PROFILE_COUNT       3
+
+typedef struct {
+    const char* name;           // 显示名称
+    const char* journal_mode;   // PRAGMA journal_mode
+    const char* synchronous;    // PRAGMA synchronous
+    int cache_size_kb;          // PRAGMA cache_size = -N（单位 KiB）
+    long long mmap_size;        // PRAGMA mmap_size（字节，0 关闭）
+    const char* temp_store;     // PRAGMA temp_store
+} DbProfileSpec;
+
+const DbProfileSpec* db_profile_spec(int profile);
+int db_apply_profile(sqlite3* db, int profile);
+int db_current_profile(void);
+int db_set_profile(int profile);
+
+// 预编译语句缓存（以 SQL 文本为键）
+// db_prepare 取出可直接绑定参数的语句；用完必须调用 db_release 归还（代替 sqlite3_finalize）
+sqlite3_stmt* db_prepare(sqlite3* db, const char* sql);
+void db_release(sqlite3_stmt* stmt);
+
+// 共享连接上观察到的其他连接提交次数（db_prepare 时比对 PRAGMA data_version）
+unsigned db_external_commits(void);
+
+typedef struct {
+    long hits;      // 命中缓存（跳过 SQL 编译）
+    long misses;    // 未命中（新编译）
+    int cached;     // 当前缓存的语句数
+} StmtCacheStats;
+
+void db_stmt_cache_stats(StmtCacheStats* out);
+
+// 应用配置（app_settings 表，键值对持久化在数据库中）
+int db_get_setting(const char* key, char* out, size_t out_size);
+int db_get_setting_int(const char* key, int default_value);
+int db_set_setting(const char* key, const char* value);
+int db_set_setting_int(const char* key, int value);
+
+#endif
@@ -0,0 +1,133 @@
+// dim.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "dim.h"
+
+typedef struct {
+    const char* sql;
+    DimList list;
+    int* index_by_id;       // id -> entries 下标，-1 表示不存在
+    int max_id;
+    char* pool;             // 名称存储
+    unsigned generation;    // 载入时的代数，0 表示未载入
+} DimTable;
+
+static unsigned current_generation = 1;
+
+static DimTable accounts = { "SELECT id, name FROM accounts ORDER BY id;", {NULL, 0}, NULL, 0, NULL, 0 };
+static DimTable members = { "SELECT id, name FROM members ORDER BY id;", {NULL, 0}, NULL, 0, NULL, 0 };
+
+unsigned dim_generation(void) {
+    return current_generation + db_external_commits();
+}
+
+void dim_invalidate(void) {
+    current_generation++;
+}
+
+static void dim_table_free(DimTable* t) {
+    free(t->list.entries);
+    free(t->index_by_id);
+    free(t->pool);
+    t->list.entries = NULL;
+    t->list.count = 0;
+    t->index_by_id = NULL;
+    t->pool = NULL;
+    t->max_id = 0;
+    t->generation = 0;
+}
+
+static int dim_table_load(DimTable* t) {
+    dim_table_free(t);
+    sqlite3* db = db_get();
+    if (!db) return 0;
+    sqlite3_stmt* stmt = db_prepare(db, t->sql);
+    if (!stmt) return 0;
+
+    int cap = 16, count = 0, max_id = 0;
+    size_t pool_cap = 1024, pool_len = 0;
+    DimEntry* entries = malloc(sizeof(DimEntry) * cap);
+    size_t* offsets = malloc(sizeof(size_t) * cap);   // pool 可能 realloc，先记偏移
+    char* pool = malloc(pool_cap);
+    int ok = (entries && offsets && pool);
+
+    while (ok && sqlite3_step(stmt) == SQLITE_ROW) {
+        if (count == cap) {
+            cap *= 2;
+            DimEntry* e = realloc(entries, sizeof(DimEntry) * cap);
+            size_t* o = realloc(offsets, sizeof(size_t) * cap);
+            if (e) entries = e;
+            if (o) offsets = o;
+            if (!e || !o) { ok = 0; break; }
+        }
+        const char* name = (const char*)sqlite3_column_text(stmt, 1);
+        size_t len = name ? strlen(name) : 0;
+        if (pool_len + len + 1 > pool_cap) {
+            while (pool_len + len + 1 > pool_cap) pool_cap *= 2;
+            char* p = realloc(pool, pool_cap);
+            if (!p) { ok = 0; break; }
+            pool = p;
+        }
+        memcpy(pool + pool_len, name ? name : "", len + 1);
+        offsets[count] = pool_len;
+        pool_len += len + 1;
+
+        entries[count].id = sqlite3_column_int(stmt, 0);
+        if (entries[count].id > max_id) max_id = entries[count].id;
+        count++;
+    }
+    db_release(stmt);
+
+    int* index_by_id = ok ? malloc(sizeof(int) * (max_id + 1)) : NULL;
+    if (ok && index_by_id) {
+        for (int i = 0; i <= max_id; i++) index_by_id[i] = -1;
+        for (int i = 0; i < count; i++) {
+            entries[i].name = pool + offsets[i];
+            if (entries[i].id > 0) index_by_id[entries[i].id] = i;
+        }
+        t->list.entries = entries;
+        t->list.count = count;
+        t->index_by_id = index_by_id;
+        t->max_id = max_id;
+        t->pool = pool;
+        t->generation = dim_generation();
+    } else {
+        ok = 0;
+        free(entries);
+        free(pool);
+    }
+    free(offsets);
+    return ok;
+}
+
+static const DimTable* dim_table_get(DimTable* t) {
+    if (t->generation != dim_generation() && !dim_table_load(t)) return NULL;
+    return t;
+}
+
+static const char* dim_table_name(DimTable* t, int id) {
+    const DimTable* loaded = dim_table_get(t);
+    if (!loaded || id <= 0 || id > loaded->max_id || loaded->index_by_id[id] < 0) return NULL;
+    return loaded->list.entries[loaded->index_by_id[id]].name;
+}
+
+const DimList* dim_accounts(void) {
+    const DimTable* t = dim_table_get(&accounts);
+    return t ? &t->list : NULL;
+}
+
+const DimList* dim_members(void) {
+    const DimTable* t = dim_table_get(&members);
+    return t ? &t->list : NULL;
+}
+
+const char* dim_account_name(int id) {
+    return dim_table_name(&accounts, id);
+}
+
+const char* dim_member_name(int id) {
+    return dim_table_name(&members, id);
+}
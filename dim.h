@@ -0,0 +1,27 @@
+// dim.h
+#ifndef DIM_H
+#define DIM_H
+
+// 进程内维度缓存：账户、成员按 id 排列的名称表，首次使用时载入。
+// 任何维度（含分类）变更后调用 dim_invalidate()，各缓存比对代数后自动重载。
+// 代数同时包含其他连接的提交次数（db_external_commits），其他终端的修改同样使缓存失效。
+typedef struct {
+    int id;
+    const char* name;
+} DimEntry;
+
+typedef struct {
+    DimEntry* entries;      // 按 id 升序
+    int count;
+} DimList;
+
+const DimList* dim_accounts(void);
+const DimList* dim_members(void);
+// O(1) 按 id 取名称，不存在返回 NULL
+const char* dim_account_name(int id);
+const char* dim_member_name(int id);
+
+unsigned dim_generation(void);
+void dim_invalidate(void);
+
+#endif
@@ -6,72 +6,110 @@
 #include "utils.h"
 #include "finance.h"
 #include "sqlite3.h"
-#define DATABASE_NAME "finance.db"
+#include "db.h"
+#include "money.h"
+#include "rollup.h"
+#include "category.h"
+#include "dim.h"
+#include "snapshot.h"
+#include "parallel.h"
+#include "csv.h"
+#include "date.h"
+#include "query.h"
+#include "search.h"
+#include "balance.h"
+#include "schema.h"
+
+// records 表二级索引（版本号变化时整体重建）
+#define RECORDS_INDEX_VERSION 5
+
+static const char* const record_index_sql[] = {
+    // 列表/导出按 (date, id) 排序分页，按日期查询
+    "CREATE INDEX IF NOT EXISTS idx_records_date_id ON records(date, id);",
+    // 设置模块的引用检查 + JOIN
+    "CREATE INDEX IF NOT EXISTS idx_records_category ON records(category_id);",
+    // 账户余额：按 (账户, 日期) 累加当月截至某日的记录
+    "CREATE INDEX IF NOT EXISTS idx_records_account_date ON records(account_id, date);",
+    "CREATE INDEX IF NOT EXISTS idx_records_member ON records(member_id);",
+    // 按类型统计（分类报表等）
+    "CREATE INDEX IF NOT EXISTS idx_records_type_date ON records(type, date);",
+    // 列式快照按修改时间增量刷新
+    "CREATE INDEX IF NOT EXISTS idx_records_updated_at ON records(updated_at);",
+    // 日期过滤比较 date 文本（与 idx_records_date_id 的排序一致），records.day 只供快照读取，不建索引
+};
+
+// 删除全部 idx_records_* 索引（含旧版本遗留的）
+static int drop_record_indexes_in(sqlite3* db) {
+    char drop_sql[4096] = "";
+    sqlite3_stmt* stmt = db_prepare(db,
+        "SELECT name FROM sqlite_master "
+        "WHERE type = 'index' AND tbl_name = 'records' AND name LIKE 'idx_records_%';");
+    if (stmt) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* name = (const char*)sqlite3_column_text(stmt, 0);
+            size_t used = strlen(drop_sql);
+            snprintf(drop_sql + used, sizeof(drop_sql) - used, "DROP INDEX IF EXISTS \"%s\";", name);
+        }
+        db_release(stmt);
+    }
+    return sqlite3_exec(db, drop_sql, NULL, NULL, NULL) == SQLITE_OK;
+}
+
+// 检查索引版本，不一致时在一个事务内删除旧索引并创建当前索引集
+static void ensure_record_indexes(sqlite3* db) {
+    if (db_get_setting_int("records_index_version", 0) == RECORDS_INDEX_VERSION) {
+        return;
+    }
+
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+
+    int ok = drop_record_indexes_in(db);
+    for (size_t i = 0; ok && i < sizeof(record_index_sql) / sizeof(record_index_sql[0]); i++) {
+        if (sqlite3_exec(db, record_index_sql[i], NULL, NULL, NULL) != SQLITE_OK) {
+            fprintf(stderr, "创建索引失败: %s\n", sqlite3_errmsg(db));
+            ok = 0;
+        }
+    }
+    if (ok) ok = db_set_setting_int("records_index_version", RECORDS_INDEX_VERSION);
+
+    if (ok) {
+        sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+        // 新索引需要统计信息，查询规划器才能正确选择
+        sqlite3_exec(db, "PRAGMA optimize;", NULL, NULL, NULL);
+    } else {
+        sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+    }
+}
+
+// 批量写入前删除二级索引并清除版本号，之后由 init_finance_database 重建
+// （中途退出时下次启动也会自动补建）
+int drop_record_indexes(sqlite3* db) {
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = drop_record_indexes_in(db)
+          && sqlite3_exec(db, "DELETE FROM app_settings WHERE key = 'records_index_version';",
+                          NULL, NULL, NULL) == SQLITE_OK;
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+    return ok;
+}
 
 //初始化数据库函数
 void init_finance_database(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        fprintf(stderr, "❌ 无法打开数据库（财务模块）\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
+    // 检测 FTS5 与 trigram 分词器，不可用时不建备注索引
+    search_register(db);
 
-    // 启用外键约束
-    sqlite3_exec(db, "PRAGMA foreign_keys = ON;", NULL, NULL, NULL);
-
-    // 分类表（支持父子结构）
-    const char *create_categories_sql=
-        "CREATE TABLE IF NOT EXISTS categories ("
-        "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "  name TEXT NOT NULL UNIQUE,"
-        "  parent_id INTEGER,"
-        "  type TEXT NOT NULL CHECK(type IN ('income', 'expense')), "
-        "  FOREIGN KEY(parent_id) REFERENCES categories(id)"");";
-    if (sqlite3_exec(db, create_categories_sql, NULL, NULL, NULL) != SQLITE_OK) {
-        fprintf(stderr, "创建 categories 表失败: %s\n", sqlite3_errmsg(db));
-    }
-
-    // 创建 accounts 表（含 balance）
-    const char *create_accounts_sql =
-        "CREATE TABLE IF NOT EXISTS accounts ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-        "name TEXT NOT NULL UNIQUE, "
-        "balance REAL DEFAULT 0.0"");";
-    if (sqlite3_exec(db, create_accounts_sql, NULL, NULL, NULL) != SQLITE_OK) {
-        fprintf(stderr, "创建 accounts 表失败: %s\n", sqlite3_errmsg(db));
-    }
-
-    // 成员表（家庭成员）
-    const char *create_members_sql=
-        "CREATE TABLE IF NOT EXISTS members ("
-        "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "  name TEXT NOT NULL UNIQUE"");";
-    if (sqlite3_exec(db, create_members_sql, NULL, NULL, NULL) != SQLITE_OK) {
-        fprintf(stderr, "创建 members 表失败: %s\n", sqlite3_errmsg(db));
-    }
-
-    // 记录表（核心）
-    const char *create_records_sql=
-        "CREATE TABLE IF NOT EXISTS records ("
-        "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "  amount REAL NOT NULL CHECK(amount > 0),"
-        "  type TEXT NOT NULL CHECK(type IN ('income', 'expense')), "
-        "  category_id INTEGER NOT NULL,"
-        "  account_id INTEGER NOT NULL,"
-        "  member_id INTEGER,"
-        "  remark TEXT,"
-        "  date TEXT NOT NULL CHECK(date LIKE '____-__-__'),"
-        "  created_at TEXT DEFAULT (datetime('now', 'localtime')), "
-        "  updated_at TEXT DEFAULT (datetime('now', 'localtime')), "
-        "  FOREIGN KEY(category_id) REFERENCES categories(id),"
-        "  FOREIGN KEY(account_id) REFERENCES accounts(id),"
-        "  FOREIGN KEY(member_id) REFERENCES members(id)"
-        ");";
-    if (sqlite3_exec(db, create_records_sql, NULL, NULL, NULL) != SQLITE_OK) {
-        fprintf(stderr, "创建 records 表失败: %s\n", sqlite3_errmsg(db));
-    }
-
-    sqlite3_close(db);
+    // 表结构按 user_version 升级，已是最新时不执行任何 DDL
+    if (!schema_migrate(db)) return;
+
+    // 派生结构各自按版本号检查，最新时只读一次 app_settings
+    ensure_record_indexes(db);
+    init_rollups(db);
+    init_balance_ledger(db);
+    init_search_index(db);
 }
 
 //辅助：打印表头的通用函数
@@ -84,66 +122,44 @@ static void print_separator(int len) {
 static int record_id_exists(sqlite3* db, int id) {
     sqlite3_stmt* stmt;
     const char* sql = "SELECT 1 FROM records WHERE id = ? LIMIT 1;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+    if ((stmt = db_prepare(db, sql)) == NULL) {
         return 0;
     }
     sqlite3_bind_int(stmt, 1, id);
     int exists = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    db_release(stmt);
     return exists;
 }
 
-// 辅助函数：判断是否为有效日期（YYYY-MM-DD）
-int is_valid_date(const char* date_str) {
-    if (strlen(date_str) != 10 || date_str[4] != '-' || date_str[7] != '-') {
-        return 0;
-    }
-
-    int year, month, day;
-    if (sscanf(date_str, "%d-%d-%d", &year, &month, &day) != 3) {
-        return 0;
-    }
-
-    if (year < 1900 || year > 2100) return 0;
-    if (month < 1 || month > 12) return 0;
-    if (day < 1 || day > 31) return 0;
-
-    // 简单闰年处理（可选增强）
-    int days_in_month[] = {31, 28 + ((year % 4 == 0 && year % 100 != 0) || (year % 400 == 0)), 31, 30, 31, 30,
-                           31, 31, 30, 31, 30, 31};
-    return day <= days_in_month[month - 1];
-}
-
 //打印收支记录列表表头
-static void print_record_header(void) {
+void print_record_header(void) {
     printf("ID   日期        类型   分类                 账户               成员     金额    备注         修改时间\n");
     printf("--------------------------------------------------------------------------------------------------------\n");
 }
 
-//打印列表通用函数
-static void print_record_row(sqlite3_stmt* stmt) {
-    // 字段索引说明（对应 SELECT 顺序）：
+//打印列表通用函数（名称由维度缓存解析）
+void print_record_row(sqlite3_stmt* stmt) {
+    // 字段索引说明（对应 RECORD_LIST_SELECT 顺序）：
     // 0: r.id
     // 1: r.date                → 业务日期
     // 2: r.type                → 'income' 或 'expense'
-    // 3: c_parent.name         → 一级分类名（可能 NULL）
-    // 4: c_child.name          → 当前分类名
-    // 5: a.name                → 账户名
-    // 6: m.name                → 成员名（可能 NULL）
-    // 7: r.amount
-    // 8: r.remark
-    // 9: r.updated_at
+    // 3: r.category_id
+    // 4: r.account_id
+    // 5: r.member_id           → 可能 NULL
+    // 6: r.amount
+    // 7: r.remark
+    // 8: r.updated_at
 
     int id = sqlite3_column_int(stmt, 0);
     const char* date = (const char*)sqlite3_column_text(stmt, 1);
     const char* type_en = (const char*)sqlite3_column_text(stmt, 2); // 类型字段
-    const char* parent_name = (const char*)sqlite3_column_text(stmt, 3); // 一级分类名
-    const char* child_name = (const char*)sqlite3_column_text(stmt, 4);  // 当前分类名
-    const char* account = (const char*)sqlite3_column_text(stmt, 5);
-    const char* member = (const char*)sqlite3_column_text(stmt, 6);
-    double amount = sqlite3_column_double(stmt, 7);
-    const char* remark = (const char*)sqlite3_column_text(stmt, 8);
-    const char* updated_at = (const char*)sqlite3_column_text(stmt, 9);
+    const CategoryNode* category = category_tree_find(sqlite3_column_int(stmt, 3));
+    const char* account = dim_account_name(sqlite3_column_int(stmt, 4));
+    const char* member = dim_member_name(sqlite3_column_int(stmt, 5));
+    char amount[MONEY_BUF_SIZE];
+    format_money(sqlite3_column_int64(stmt, 6), amount, sizeof(amount));
+    const char* remark = (const char*)sqlite3_column_text(stmt, 7);
+    const char* updated_at = (const char*)sqlite3_column_text(stmt, 8);
 
     // --- 类型转中文 ---
     const char* type_cn = "未知";
@@ -155,17 +171,8 @@ static void print_record_row(sqlite3_stmt* stmt) {
         }
     }
 
-    // --- 构建分类路径 ---
-    char category_path[60] = "未分类";
-    if (parent_name && strlen(parent_name) > 0) {
-        // 有父分类（即二级分类）
-        snprintf(category_path, sizeof(category_path), "%s > %s", parent_name, child_name);
-    } else {
-        // 仅有一级分类
-        strncpy(category_path, child_name, sizeof(category_path) - 1);
-    }
-
     // --- 处理空值显示 ---
+    const char* category_path = category ? category->path : "未分类";
     const char* disp_account = (account != NULL && account[0] != '\0') ? account : "-";
     const char* disp_member = (member != NULL && member[0] != '\0') ? member : "-";
     const char* disp_remark = (remark != NULL && remark[0] != '\0') ? remark : "";
@@ -173,7 +180,7 @@ static void print_record_row(sqlite3_stmt* stmt) {
     const char* disp_updated = updated_at ? updated_at : "";
 
     // --- 打印行（严格对齐表头）---
-    printf("%-3d %-12s %-8s %-20s %-20s %-8s %-8.2f %-20s %-12s\n",
+    printf("%-3d %-12s %-8s %-20s %-20s %-8s %-8s %-20s %-12s\n",
            id,
            disp_date,
            type_cn,
@@ -186,34 +193,82 @@ static void print_record_row(sqlite3_stmt* stmt) {
 }
 
 // 在事务内安全更新账户余额（delta 可正可负）
-static int apply_balance_delta(sqlite3* db, int account_id, double delta) {
+static int apply_balance_delta(sqlite3* db, int account_id, int64_t delta) {
     if (account_id <= 0) return 0;
 
     sqlite3_stmt* stmt;
     const char* sql = "UPDATE accounts SET balance = balance + ? WHERE id = ?";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+    if ((stmt = db_prepare(db, sql)) == NULL) {
         return 0;
     }
-    sqlite3_bind_double(stmt, 1, delta);
+    sqlite3_bind_int64(stmt, 1, delta);
     sqlite3_bind_int(stmt, 2, account_id);
 
     int ok = (sqlite3_step(stmt) == SQLITE_DONE);
-    sqlite3_finalize(stmt);
+    db_release(stmt);
     return ok;
 }
 
+// 插入一条记录并同步账户余额（单事务），返回新记录 id，失败返回 0
+sqlite3_int64 insert_record(const char* date, const char* type, int category_id, int64_t amount,
+                            int account_id, int member_id, const char* remark) {
+    sqlite3* db = db_get();
+    if (!db) return 0;
+
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+
+    sqlite3_stmt* stmt;
+    const char* sql = 
+        "INSERT INTO records (date, type, category_id, amount, account_id, member_id, remark, updated_at) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, datetime('now', 'localtime'));";
+
+    sqlite3_int64 id = 0;
+    if ((stmt = db_prepare(db, sql)) != NULL) {
+        sqlite3_bind_text(stmt, 1, date, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, type, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 3, category_id);
+        sqlite3_bind_int64(stmt, 4, amount);
+        sqlite3_bind_int(stmt, 5, account_id);
+        if (member_id > 0) sqlite3_bind_int(stmt, 6, member_id);
+        else sqlite3_bind_null(stmt, 6);
+        sqlite3_bind_text(stmt, 7, (remark && remark[0]) ? remark : NULL, -1, SQLITE_STATIC);
+
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            id = sqlite3_last_insert_rowid(db);
+        } else {
+            fprintf(stderr, "❌ 插入失败: %s\n", sqlite3_errmsg(db));
+        }
+        db_release(stmt);
+    } else {
+        fprintf(stderr, "❌ SQL 准备失败: %s\n", sqlite3_errmsg(db));
+    }
+
+    if (id > 0) {
+        // ✅ 计算 delta 并更新余额（仍在事务中）
+        int64_t delta = (strcmp(type, "income") == 0) ? amount : -amount;
+        if (!apply_balance_delta(db, account_id, delta)) {
+            fprintf(stderr, "⚠️  警告：账户余额更新失败，但记录已保存。\n");
+            // 可选择回滚，但通常记录更重要，这里仅警告
+        }
+        sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    } else {
+        sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+    }
+    return id;
+}
+
 // 添加收支记录函数
 void add_record(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
     char input[256] = {0};
     char date[11] = {0};
     char type_str[20] = {0};
-    double amount = 0.0;
+    int64_t amount = 0; // 分
     char remark[100] = {0};
 
     // === 1. 输入日期（带完整校验）===
@@ -230,7 +285,7 @@ void add_record(void) {
             break;
         }
 
-        if (is_valid_date(input)) {
+        if (date_is_valid(input)) {
             strcpy(date, input);
             break;
         } else {
@@ -269,7 +324,6 @@ void add_record(void) {
     int category_id = select_category(type_str);
     if (category_id == -1) {
         printf("❌ 分类选择失败。\n");
-        sqlite3_close(db);
         return;
     }
 
@@ -277,7 +331,6 @@ void add_record(void) {
     int account_id = select_account();
     if (account_id == -1) {
         printf("❌ 账户选择失败。\n");
-        sqlite3_close(db);
         return;
     }
 
@@ -293,13 +346,10 @@ void add_record(void) {
         fgets(input, sizeof(input), stdin);
         input[strcspn(input, "\n")] = 0;
 
-        char* endptr;
-        amount = strtod(input, &endptr);
-
-        if (*endptr == '\0' && amount > 0) {
+        if (parse_money(input, &amount) && amount > 0) {
             break;
         } else {
-            printf("❌ 金额必须是大于 0 的数字！\n");
+            printf("❌ 金额必须是大于 0 的数字（最多两位小数）！\n");
         }
     }
 
@@ -309,47 +359,9 @@ void add_record(void) {
     remark[strcspn(remark, "\n")] = 0;
 
     // === 8. 插入数据库（使用事务保证完整性）===
-    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
-
-    sqlite3_stmt* stmt;
-    const char* sql = 
-        "INSERT INTO records (date, type, category_id, amount, account_id, member_id, remark, updated_at) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, datetime('now', 'localtime'));";
-
-    int success = 0;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, date, -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, type_str, -1, SQLITE_STATIC);
-        sqlite3_bind_int(stmt, 3, category_id);
-        sqlite3_bind_double(stmt, 4, amount);
-        sqlite3_bind_int(stmt, 5, account_id);
-        sqlite3_bind_int(stmt, 6, member_id);
-        sqlite3_bind_text(stmt, 7, remark[0] ? remark : NULL, -1, SQLITE_STATIC);
-
-        if (sqlite3_step(stmt) == SQLITE_DONE) {
-            success = 1;
-        } else {
-            printf("❌ 插入失败: %s\n", sqlite3_errmsg(db));
-        }
-        sqlite3_finalize(stmt);
-    } else {
-        printf("❌ SQL 准备失败: %s\n", sqlite3_errmsg(db));
-    }
-
-    if (success) {
-        // ✅ 计算 delta 并更新余额（仍在事务中）
-        double delta = (strcmp(type_str, "income") == 0) ? amount : -amount;
-        if (!apply_balance_delta(db, account_id, delta)) {
-            printf("⚠️  警告：账户余额更新失败，但记录已保存。\n");
-            // 可选择回滚，但通常记录更重要，这里仅警告
-        }
-        sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    if (insert_record(date, type_str, category_id, amount, account_id, member_id, remark) > 0) {
         printf("✅ 记录添加成功！\n"); // 现在才提示成功
-    } else {
-        sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
     }
-
-    sqlite3_close(db);
 }
 
 // 编辑收支记录函数
@@ -371,9 +383,9 @@ void edit_record(void) {
         return;
     }
 
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
@@ -382,17 +394,15 @@ void edit_record(void) {
     const char* load_sql = 
         "SELECT date, type, category_id, account_id, member_id, amount, remark "
         "FROM records WHERE id = ?;";
-    if (sqlite3_prepare_v2(db, load_sql, -1, &load_stmt, NULL) != SQLITE_OK) {
+    if ((load_stmt = db_prepare(db, load_sql)) == NULL) {
         printf("❌ 查询记录失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
         return;
     }
     sqlite3_bind_int(load_stmt, 1, id);
 
     if (sqlite3_step(load_stmt) != SQLITE_ROW) {
         printf("❌ 记录 ID %d 不存在！\n", id);
-        sqlite3_finalize(load_stmt);
-        sqlite3_close(db);
+        db_release(load_stmt);
         return;
     }
 
@@ -402,13 +412,20 @@ void edit_record(void) {
     int orig_category_id = sqlite3_column_int(load_stmt, 2);
     int orig_account_id = sqlite3_column_int(load_stmt, 3);
     int orig_member_id = sqlite3_column_int(load_stmt, 4);
-    double orig_amount = sqlite3_column_double(load_stmt, 5);
-    const char* orig_remark = (const char*)sqlite3_column_text(load_stmt, 6);
+    int64_t orig_amount = sqlite3_column_int64(load_stmt, 5);
+    // 语句归还后列数据失效，备注整段复制（不截断，按 Enter 保留时原样写回）
+    const char* orig_remark_col = (const char*)sqlite3_column_text(load_stmt, 6);
+    char* orig_remark = orig_remark_col ? strdup(orig_remark_col) : NULL;
+    if (orig_remark_col && !orig_remark) {
+        printf("❌ 内存不足。\n");
+        db_release(load_stmt);
+        return;
+    }
 
     strncpy(orig_date, (const char*)sqlite3_column_text(load_stmt, 0), sizeof(orig_date) - 1);
     strncpy(orig_type, (const char*)sqlite3_column_text(load_stmt, 1), sizeof(orig_type) - 1);
 
-    sqlite3_finalize(load_stmt);
+    db_release(load_stmt);
 
     // --- 开始编辑 ---
     char input[256] = {0};
@@ -417,12 +434,11 @@ void edit_record(void) {
     int new_category_id = orig_category_id;
     int new_account_id = orig_account_id;
     int new_member_id = orig_member_id;
-    double new_amount = orig_amount;
-    char new_remark[100] = {0};
+    int64_t new_amount = orig_amount;
+    const char* new_remark = orig_remark;      // 指向 orig_remark 或 input
 
     strcpy(new_date, orig_date);
     strcpy(new_type, orig_type);
-    if (orig_remark) strncpy(new_remark, orig_remark, sizeof(new_remark) - 1);
 
     printf("\n--- 编辑记录 (ID=%d) ---\n", id);
     printf("提示：直接按 Enter 保留原值，输入新值则覆盖。\n\n");
@@ -432,7 +448,7 @@ void edit_record(void) {
     fgets(input, sizeof(input), stdin);
     input[strcspn(input, "\n")] = 0;
     if (input[0] != '\0') {
-        if (is_valid_date(input)) {
+        if (date_is_valid(input)) {
             strcpy(new_date, input);
         } else {
             printf("⚠️ 日期格式无效，保留原值 \"%s\"\n", orig_date);
@@ -488,16 +504,17 @@ void edit_record(void) {
     }
 
     // 6. 金额
-    printf("金额 [%.2f]: ", orig_amount);
+    char orig_amount_text[MONEY_BUF_SIZE];
+    format_money(orig_amount, orig_amount_text, sizeof(orig_amount_text));
+    printf("金额 [%s]: ", orig_amount_text);
     fgets(input, sizeof(input), stdin);
     input[strcspn(input, "\n")] = 0;
     if (input[0] != '\0') {
-        char* endptr;
-        double val = strtod(input, &endptr);
-        if (*endptr == '\0' && val > 0) {
+        int64_t val;
+        if (parse_money(input, &val) && val > 0) {
             new_amount = val;
         } else {
-            printf("⚠️ 金额无效，保留原值 %.2f\n", orig_amount);
+            printf("⚠️ 金额无效，保留原值 %s\n", orig_amount_text);
         }
     }
 
@@ -506,11 +523,8 @@ void edit_record(void) {
     fgets(input, sizeof(input), stdin);
     input[strcspn(input, "\n")] = 0;
     if (input[0] != '\0') {
-        strncpy(new_remark, input, sizeof(new_remark) - 1);
-    } else if (input[0] == '\0' && orig_remark) {
-        // 用户按 Enter → 保留原备注
-        strncpy(new_remark, orig_remark, sizeof(new_remark) - 1);
-    } // 否则 new_remark 保持为空
+        new_remark = input;
+    } // 用户按 Enter → 保留原备注
 
     // === 执行更新 ===
     sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
@@ -523,14 +537,14 @@ void edit_record(void) {
         "WHERE id = ?;";
 
     int success = 0;
-    if (sqlite3_prepare_v2(db, update_sql, -1, &update_stmt, NULL) == SQLITE_OK) {
+    if ((update_stmt = db_prepare(db, update_sql)) != NULL) {
         sqlite3_bind_text(update_stmt, 1, new_date, -1, SQLITE_STATIC);
         sqlite3_bind_text(update_stmt, 2, new_type, -1, SQLITE_STATIC);
         sqlite3_bind_int(update_stmt, 3, new_category_id);
         sqlite3_bind_int(update_stmt, 4, new_account_id);
         sqlite3_bind_int(update_stmt, 5, new_member_id);
-        sqlite3_bind_double(update_stmt, 6, new_amount);
-        sqlite3_bind_text(update_stmt, 7, new_remark[0] ? new_remark : NULL, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(update_stmt, 6, new_amount);
+        sqlite3_bind_text(update_stmt, 7, (new_remark && new_remark[0]) ? new_remark : NULL, -1, SQLITE_STATIC);
         sqlite3_bind_int(update_stmt, 8, id);
 
         if (sqlite3_step(update_stmt) == SQLITE_DONE) {
@@ -542,7 +556,7 @@ void edit_record(void) {
         } else {
             printf("\n❌ 更新失败: %s\n", sqlite3_errmsg(db));
         }
-        sqlite3_finalize(update_stmt);
+        db_release(update_stmt);
     } else {
         printf("\n❌ 准备更新语句失败: %s\n", sqlite3_errmsg(db));
     }
@@ -552,14 +566,14 @@ void edit_record(void) {
         int balance_ok = 1;
 
         // 1. 撤销原记录对原账户的影响
-        double old_delta = (strcmp(orig_type, "income") == 0) ? -orig_amount : orig_amount;
+        int64_t old_delta = (strcmp(orig_type, "income") == 0) ? -orig_amount : orig_amount;
         if (!apply_balance_delta(db, orig_account_id, old_delta)) {
             printf("⚠️  警告：无法撤销原账户余额变更。\n");
             balance_ok = 0;
         }
 
         // 2. 应用新记录对新账户的影响
-        double new_delta = (strcmp(new_type, "income") == 0) ? new_amount : -new_amount;
+        int64_t new_delta = (strcmp(new_type, "income") == 0) ? new_amount : -new_amount;
         if (!apply_balance_delta(db, new_account_id, new_delta)) {
             printf("⚠️  警告：无法应用新账户余额变更。\n");
             balance_ok = 0;
@@ -576,8 +590,7 @@ void edit_record(void) {
     } else {
         sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
     }
-
-    sqlite3_close(db);
+    free(orig_remark);
 }
 
 // 删除收支记录函数（完善版）
@@ -600,15 +613,14 @@ void delete_record(void) {
         return;
     }
 
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
     if (!record_id_exists(db, id)) {
         printf("❌ 记录 ID %d 不存在！\n", id);
-        sqlite3_close(db);
         return;
     }
 
@@ -616,22 +628,23 @@ void delete_record(void) {
     sqlite3_stmt* info_stmt;
     const char* info_sql = 
         "SELECT date, type, amount, remark FROM records WHERE id = ?;";
-    if (sqlite3_prepare_v2(db, info_sql, -1, &info_stmt, NULL) == SQLITE_OK) {
+    if ((info_stmt = db_prepare(db, info_sql)) != NULL) {
         sqlite3_bind_int(info_stmt, 1, id);
         if (sqlite3_step(info_stmt) == SQLITE_ROW) {
             const char* date = (const char*)sqlite3_column_text(info_stmt, 0);
             const char* type = (const char*)sqlite3_column_text(info_stmt, 1);
-            double amount = sqlite3_column_double(info_stmt, 2);
+            char amount[MONEY_BUF_SIZE];
+            format_money(sqlite3_column_int64(info_stmt, 2), amount, sizeof(amount));
             const char* remark = (const char*)sqlite3_column_text(info_stmt, 3);
             const char* type_cn = (strcmp(type, "income") == 0) ? "收入" : "支出";
             printf("\n即将删除:\n");
             printf("  ID: %d\n", id);
             printf("  日期: %s\n", date ? date : "未知");
             printf("  类型: %s\n", type_cn);
-            printf("  金额: %.2f\n", amount);
+            printf("  金额: %s\n", amount);
             printf("  备注: %s\n", remark && strlen(remark) > 0 ? remark : "无");
         }
-        sqlite3_finalize(info_stmt);
+        db_release(info_stmt);
     }
 
     // 二次确认（修复 scanf("%c") 问题）
@@ -639,14 +652,12 @@ void delete_record(void) {
     printf("\n⚠️ 确定要永久删除此记录吗？(输入 y/Y 确认，其他取消): ");
     if (fgets(input, sizeof(input), stdin) == NULL) {
         printf("\n❌ 输入错误，已取消。\n");
-        sqlite3_close(db);
         return;
     }
     input[strcspn(input, "\n")] = 0; // 去掉换行
 
     if (input[0] != 'y' && input[0] != 'Y') {
         printf("❌ 已取消删除。\n");
-        sqlite3_close(db);
         return;
     }
 
@@ -656,31 +667,30 @@ void delete_record(void) {
     // === 新增：先获取记录详情用于余额调整 ===
     int account_id = -1;
     char type_str[20] = {0};
-    double amount = 0.0;
+    int64_t amount = 0;
 
     sqlite3_stmt* fetch_stmt;
     const char* fetch_sql = "SELECT account_id, type, amount FROM records WHERE id = ?;";
-    if (sqlite3_prepare_v2(db, fetch_sql, -1, &fetch_stmt, NULL) == SQLITE_OK) {
+    if ((fetch_stmt = db_prepare(db, fetch_sql)) != NULL) {
         sqlite3_bind_int(fetch_stmt, 1, id);
         if (sqlite3_step(fetch_stmt) == SQLITE_ROW) {
             account_id = sqlite3_column_int(fetch_stmt, 0);
             const char* type = (const char*)sqlite3_column_text(fetch_stmt, 1);
-            amount = sqlite3_column_double(fetch_stmt, 2);
+            amount = sqlite3_column_int64(fetch_stmt, 2);
             if (type) strncpy(type_str, type, sizeof(type_str) - 1);
         }
-        sqlite3_finalize(fetch_stmt);
+        db_release(fetch_stmt);
     }
 
     int success = 0;
     if (account_id <= 0) {
         printf("❌ 无法获取记录详情，删除中止。\n");
         sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
-        sqlite3_close(db);
         return;
     }
 
     // === 1. 先更新账户余额（撤销影响）===
-    double delta = (strcmp(type_str, "income") == 0) ? -amount : amount;
+    int64_t delta = (strcmp(type_str, "income") == 0) ? -amount : amount;
     if (!apply_balance_delta(db, account_id, delta)) {
         printf("⚠️  警告：账户余额回滚失败，但将继续删除记录。\n");
         // 可选择回滚，但通常记录删除更重要
@@ -689,7 +699,7 @@ void delete_record(void) {
     // === 2. 再删除记录 ===
     sqlite3_stmt* del_stmt;
     const char* del_sql = "DELETE FROM records WHERE id = ?;";
-    if (sqlite3_prepare_v2(db, del_sql, -1, &del_stmt, NULL) == SQLITE_OK) {
+    if ((del_stmt = db_prepare(db, del_sql)) != NULL) {
         sqlite3_bind_int(del_stmt, 1, id);
         if (sqlite3_step(del_stmt) == SQLITE_DONE) {
             int changes = sqlite3_changes(db);
@@ -702,7 +712,7 @@ void delete_record(void) {
         } else {
             printf("❌ SQL 执行失败: %s\n", sqlite3_errmsg(db));
         }
-        sqlite3_finalize(del_stmt);
+        db_release(del_stmt);
     } else {
         printf("❌ 准备删除语句失败: %s\n", sqlite3_errmsg(db));
     }
@@ -714,90 +724,131 @@ void delete_record(void) {
     } else {
         sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
     }
+}
+
+// 分页游标：按 (date, id) 倒序排列中某一行的位置
+typedef struct {
+    char date[11];
+    sqlite3_int64 id;
+} PageKey;
 
-    sqlite3_close(db);
+#define PAGE_KEY_MAX_ID 9223372036854775807LL
+
+static void page_key_from_row(PageKey* key, sqlite3_stmt* stmt, int date_col, int id_col) {
+    const char* date = (const char*)sqlite3_column_text(stmt, date_col);
+    snprintf(key->date, sizeof(key->date), "%s", date ? date : "");
+    key->id = sqlite3_column_int64(stmt, id_col);
 }
 
-//显示所有收支记录函数（分页显示）
-void list_records(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
-        return;
-    }
+// 是否存在比 top 更新的记录（即有上一页）
+static int page_has_newer(sqlite3* db, const PageKey* top) {
+    sqlite3_stmt* stmt = db_prepare(db,
+        "SELECT 1 FROM records WHERE (date, id) > (?, ?) LIMIT 1;");
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, top->date, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, top->id);
+    int found = (sqlite3_step(stmt) == SQLITE_ROW);
+    db_release(stmt);
+    return found;
+}
 
-    // 获取总记录数
-    sqlite3_stmt* count_stmt;
-    int total_records = 0;
-    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM records;", -1, &count_stmt, NULL) == SQLITE_OK) {
-        if (sqlite3_step(count_stmt) == SQLITE_ROW) {
-            total_records = sqlite3_column_int(count_stmt, 0);
-        }
-        sqlite3_finalize(count_stmt);
+// 反向游标：从 top 往更新的方向数 page_size 行，得到上一页的首行
+// 返回 0 表示上一页就是最新一页（从头开始）
+static int page_seek_backward(sqlite3* db, const PageKey* top, int page_size, PageKey* out) {
+    sqlite3_stmt* stmt = db_prepare(db,
+        "SELECT date, id FROM records WHERE (date, id) > (?, ?) "
+        "ORDER BY date ASC, id ASC LIMIT 1 OFFSET ?;");
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, top->date, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, top->id);
+    sqlite3_bind_int(stmt, 3, page_size - 1);
+    int found = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        page_key_from_row(out, stmt, 0, 1);
+        found = 1;
     }
+    db_release(stmt);
+    return found;
+}
 
-    if (total_records == 0) {
-        printf("📭 暂无财务记录。\n");
-        sqlite3_close(db);
+//显示所有收支记录函数（键集分页：按 (date, id) 定位，翻到任何一页的代价都与第一页相同）
+void list_records(void) {
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
     const int PAGE_SIZE = 8; // 略微减少，因列变宽
-    int current_page = 0;
+    PageKey top = {"", 0};   // 当前页首行（含）
+    int has_top = 0;         // 0 表示从最新记录开始
     char input[20];
 
     while (1) {
-        clear_screen(); // 清屏函数
-
-        printf("=== 所有财务记录 (共 %d 条) ===\n", total_records);
-        print_record_header(); // 使用你更新后的表头
-
-        // ⭐ 核心 SQL：JOIN 分类（父子）、账户、成员
-        const char* sql = 
-        "SELECT "
-        "    r.id, "
-        "    r.date, "
-        "    r.type, "
-        "    c_parent.name, "        //-- 父分类名（通过 parent_id = id 关联）
-        "    c_child.name, "         //-- 当前分类名
-        "    a.name, "
-        "    m.name, "
-        "    r.amount, "
-        "    r.remark, "
-        "    r.updated_at "
-        "FROM records r "
-        "JOIN categories c_child ON r.category_id = c_child.id "       //-- 按 ID 找子分类
-        "LEFT JOIN categories c_parent ON c_child.parent_id = c_parent.id "  //-- ⭐ 按 ID 找父分类！
-        "JOIN accounts a ON r.account_id = a.id "
-        "LEFT JOIN members m ON r.member_id = m.id "
-        "ORDER BY r.date DESC, r.id DESC "
-        "LIMIT ? OFFSET ?;";
-
-        sqlite3_stmt* stmt;
-        if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        // 多取一行用于判断是否还有下一页，多出的那行即下一页首行
+        sqlite3_stmt* stmt = has_top
+            ? db_prepare(db, RECORD_LIST_SELECT
+                  "WHERE (r.date, r.id) <= (?, ?) "
+                  "ORDER BY r.date DESC, r.id DESC LIMIT ?;")
+            : db_prepare(db, RECORD_LIST_SELECT
+                  "ORDER BY r.date DESC, r.id DESC LIMIT ?;");
+        if (!stmt) {
             printf("❌ 查询失败: %s\n", sqlite3_errmsg(db));
-            sqlite3_close(db);
             return;
         }
+        if (has_top) {
+            sqlite3_bind_text(stmt, 1, top.date, -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 2, top.id);
+            sqlite3_bind_int(stmt, 3, PAGE_SIZE + 1);
+        } else {
+            sqlite3_bind_int(stmt, 1, PAGE_SIZE + 1);
+        }
 
-        sqlite3_bind_int(stmt, 1, PAGE_SIZE);
-        sqlite3_bind_int(stmt, 2, current_page * PAGE_SIZE);
+        clear_screen(); // 清屏函数
+        printf("=== 所有财务记录 ===\n");
+        print_record_header(); // 使用你更新后的表头
 
+        int rows = 0;
+        int has_next = 0;
+        PageKey next_top = {"", 0};
+        char first_date[11] = "", last_date[11] = "";
         while (sqlite3_step(stmt) == SQLITE_ROW) {
+            if (rows == PAGE_SIZE) {
+                page_key_from_row(&next_top, stmt, 1, 0);
+                has_next = 1;
+                break;
+            }
+            const char* date = (const char*)sqlite3_column_text(stmt, 1);
+            if (rows == 0) snprintf(first_date, sizeof(first_date), "%s", date ? date : "");
+            snprintf(last_date, sizeof(last_date), "%s", date ? date : "");
             print_record_row(stmt); // 行打印
+            rows++;
+        }
+        db_release(stmt);
+
+        if (rows == 0 && !has_top) {
+            printf("📭 暂无财务记录。\n");
+            return;
+        }
+        if (rows == 0) {
+            printf("📭 %s 及之前没有记录。\n", top.date);
         }
-        sqlite3_finalize(stmt);
+
+        int has_prev = has_top && page_has_newer(db, &top);
 
         // 分页控制
-        int total_pages = (total_records + PAGE_SIZE - 1) / PAGE_SIZE;
-        printf("\n【第 %d/%d 页】", current_page + 1, total_pages);
-        if (current_page > 0) {
+        if (rows > 0) {
+            printf("\n【%s ~ %s】", first_date, last_date);
+        } else {
+            printf("\n【无记录】");
+        }
+        if (has_prev) {
             printf(" [P]上一页");
         }
-        if ((current_page + 1) * PAGE_SIZE < total_records) {
+        if (has_next) {
             printf(" [N]下一页");
         }
-        printf(" [Q]返回: ");
+        printf(" [D]跳转日期 [Q]返回: ");
 
         if (fgets(input, sizeof(input), stdin) == NULL) {
             break;
@@ -807,17 +858,98 @@ void list_records(void) {
         if (strcasecmp(input, "Q") == 0) {
             break;
         } else if (strcasecmp(input, "N") == 0) {
-            if ((current_page + 1) * PAGE_SIZE < total_records) {
-                current_page++;
+            if (has_next) {
+                top = next_top;
+                has_top = 1;
             }
         } else if (strcasecmp(input, "P") == 0) {
-            if (current_page > 0) {
-                current_page--;
+            if (has_prev) {
+                PageKey prev_top;
+                if (page_seek_backward(db, &top, PAGE_SIZE, &prev_top)) {
+                    top = prev_top;
+                } else {
+                    has_top = 0; // 上一页即最新一页
+                }
+            }
+        } else if (strcasecmp(input, "D") == 0) {
+            char date_input[20];
+            printf("跳转到日期 (YYYY-MM-DD，显示该日及之前的记录): ");
+            if (fgets(date_input, sizeof(date_input), stdin) == NULL) break;
+            date_input[strcspn(date_input, "\n")] = 0;
+            if (date_is_valid(date_input)) {
+                memcpy(top.date, date_input, sizeof(top.date) - 1);
+                top.date[sizeof(top.date) - 1] = '\0';
+                top.id = PAGE_KEY_MAX_ID; // 包含该日全部记录
+                has_top = 1;
             }
         }
     }
+}
+
+// 把 RECORD_LIST_SELECT + tail_sql 的结果流式写成 CSV（表头固定，可选 BOM），
+// tail_sql 中的 ? 依次绑定 params；返回记录数，失败返回 -1
+long write_records_csv_where(FILE* fp, int with_bom, const char* tail_sql,
+                             const char* const* params, int param_count) {
+    sqlite3* db = db_get();
+    if (!db) return -1;
+
+    char sql[1024];
+    snprintf(sql, sizeof(sql), "%s%s;", RECORD_LIST_SELECT, tail_sql);
+    sqlite3_stmt* stmt = db_prepare(db, sql);
+    if (!stmt) {
+        fprintf(stderr, "❌ 查询失败: %s\n", sqlite3_errmsg(db));
+        return -1;
+    }
+    for (int i = 0; i < param_count; i++) {
+        sqlite3_bind_text(stmt, i + 1, params[i], -1, SQLITE_STATIC);
+    }
+    long count = write_records_csv_stmt(fp, with_bom, stmt);
+    db_release(stmt);
+    return count;
+}
+
+// 把已绑定参数的 RECORD_LIST_SELECT 语句逐行写成 CSV（语句由调用方释放）
+long write_records_csv_stmt(FILE* fp, int with_bom, sqlite3_stmt* stmt) {
+    CsvWriter w;
+    if (!csv_writer_init(&w, fp)) {
+        return -1;
+    }
+
+    // UTF-8 BOM（确保 Excel 正确识别中文）+ 表头
+    static const char header[] = "ID,日期,类型,父分类,子分类,账户,成员,金额,备注,更新时间\n";
+    if (with_bom) csv_write_raw(&w, "\xEF\xBB\xBF", 3);
+    csv_write_raw(&w, header, sizeof(header) - 1);
+
+    long count = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* type_raw = (const char*)sqlite3_column_text(stmt, 2);
+        const char* type_cn = (type_raw && strcmp(type_raw, "income") == 0) ? "收入" : "支出";
+        const CategoryNode* category = category_tree_find(sqlite3_column_int(stmt, 3));
+        const char* parent = category ? category->parent_name : NULL;
+        const char* child = category ? category->name : NULL;
+        const char* account = dim_account_name(sqlite3_column_int(stmt, 4));
+        const char* member = dim_member_name(sqlite3_column_int(stmt, 5));
+
+        csv_write_int(&w, sqlite3_column_int64(stmt, 0));
+        csv_write_field(&w, (const char*)sqlite3_column_text(stmt, 1), (size_t)sqlite3_column_bytes(stmt, 1));
+        csv_write_field(&w, type_cn, strlen(type_cn));
+        csv_write_field(&w, parent, parent ? strlen(parent) : 0);
+        csv_write_field(&w, child, child ? strlen(child) : 0);
+        csv_write_field(&w, account, account ? strlen(account) : 0);
+        csv_write_field(&w, member, member ? strlen(member) : 0);
+        csv_write_money(&w, sqlite3_column_int64(stmt, 6));
+        csv_write_field(&w, (const char*)sqlite3_column_text(stmt, 7), (size_t)sqlite3_column_bytes(stmt, 7));
+        csv_write_field(&w, (const char*)sqlite3_column_text(stmt, 8), (size_t)sqlite3_column_bytes(stmt, 8));
+        csv_end_row(&w);
+        count++;
+    }
+
+    return csv_writer_finish(&w) ? count : -1;
+}
 
-    sqlite3_close(db);
+// 按 (date, id) 顺序导出全部记录（含 BOM，供 Excel 打开）
+long write_records_csv(FILE* fp) {
+    return write_records_csv_where(fp, 1, "ORDER BY r.date, r.id", NULL, 0);
 }
 
 //导出收支记录到CSV的函数
@@ -835,107 +967,20 @@ void export_to_csv(void) {
         strcat(filename, ".csv");
     }
 
-    FILE* fp = fopen(filename, "w");
+    FILE* fp = fopen(filename, "wb");
     if (!fp) {
         printf("❌ 无法创建文件 \"%s\"（权限不足或路径无效）\n", filename);
         return;
     }
 
-    // 写入 UTF-8 BOM（确保 Excel 正确识别中文）
-    fprintf(fp, "\xEF\xBB\xBF");
+    long count = write_records_csv(fp);
+    if (fclose(fp) != 0) count = -1;
 
-    // 写入表头
-    fprintf(fp, "ID,日期,类型,父分类,子分类,账户,成员,金额,备注,更新时间\n");
-
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
-        fclose(fp);
+    if (count < 0) {
+        printf("❌ 导出失败（数据库错误或磁盘写入失败）\n");
         return;
     }
-
-    // 使用与 list_records 相同的 SQL
-    const char* sql = 
-        "SELECT "
-        "    r.id, "
-        "    r.date, "
-        "    r.type, "
-        "    c_parent.name, "
-        "    c_child.name, "
-        "    a.name, "
-        "    m.name, "
-        "    r.amount, "
-        "    r.remark, "
-        "    r.updated_at "
-        "FROM records r "
-        "JOIN categories c_child ON r.category_id = c_child.id "
-        "LEFT JOIN categories c_parent ON c_child.parent_id = c_parent.id "
-        "JOIN accounts a ON r.account_id = a.id "
-        "LEFT JOIN members m ON r.member_id = m.id "
-        "ORDER BY r.date, r.id;";
-
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        printf("❌ 查询失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        fclose(fp);
-        return;
-    }
-
-    #define CSV_ESCAPE_BUF_SIZE 1024
-    char escaped[CSV_ESCAPE_BUF_SIZE];
-    int count = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const char* date = (const char*)sqlite3_column_text(stmt, 1);
-        const char* type_raw = (const char*)sqlite3_column_text(stmt, 2);
-        const char* parent_cat = (const char*)sqlite3_column_text(stmt, 3);
-        const char* child_cat = (const char*)sqlite3_column_text(stmt, 4);
-        const char* account = (const char*)sqlite3_column_text(stmt, 5);
-        const char* member = (const char*)sqlite3_column_text(stmt, 6);
-        double amount = sqlite3_column_double(stmt, 7);
-        const char* remark = (const char*)sqlite3_column_text(stmt, 8);
-        const char* updated_at = (const char*)sqlite3_column_text(stmt, 9);
-
-        const char* type_cn = (strcmp(type_raw, "income") == 0) ? "收入" : "支出";
-
-        // 转义各字段
-        csv_escape(parent_cat, escaped, sizeof(escaped));
-        char parent_escaped[256]; strcpy(parent_escaped, escaped);
-
-        csv_escape(child_cat, escaped, sizeof(escaped));
-        char child_escaped[256]; strcpy(child_escaped, escaped);
-
-        csv_escape(account, escaped, sizeof(escaped));
-        char account_escaped[256]; strcpy(account_escaped, escaped);
-
-        csv_escape(member, escaped, sizeof(escaped));
-        char member_escaped[256]; strcpy(member_escaped, escaped);
-
-        csv_escape(remark, escaped, sizeof(escaped));
-        char remark_escaped[256]; strcpy(remark_escaped, escaped);
-
-        // 写入一行
-        fprintf(fp, "%d,%s,%s,%s,%s,%s,%s,%.2f,%s,%s\n",
-                id,
-                date ? date : "",
-                type_cn,
-                parent_escaped,
-                child_escaped,
-                account_escaped,
-                member_escaped,
-                amount,
-                remark_escaped,
-                updated_at ? updated_at : ""
-        );
-        count++;
-    }
-
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-    fclose(fp);
-
-    printf("✅ 成功导出 %d 条记录到 \"%s\"\n", count, filename);
+    printf("✅ 成功导出 %ld 条记录到 \"%s\"\n", count, filename);
 }
 
 //按日期查询收支记录的函数
@@ -948,66 +993,18 @@ void query_by_date(void) {
     }
     input[strcspn(input, "\n")] = 0;
 
-    if (strlen(input) != 10 || input[4] != '-' || input[7] != '-') {
-        printf("❌ 日期格式错误！应为 YYYY-MM-DD\n");
-        return;
-    }
-
-    // 可选：增强校验
-    if (!is_valid_date(input)) {
-        printf("❌ 日期无效（如 2026-99-99）！\n");
+    RecordFilter f;
+    record_filter_init(&f);
+    if (!date_parse_days(input, &f.day_from)) {
+        printf("❌ 日期无效！应为 YYYY-MM-DD 格式的有效日期\n");
         return;
     }
+    f.has_from = f.has_to = 1;
+    f.day_to = f.day_from;
 
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
-        return;
-    }
-
-    // 使用与 list_records 相同的 SQL，仅添加 WHERE date = ?
-    const char* sql = 
-        "SELECT "
-        "    r.id, "
-        "    r.date, "
-        "    r.type, "
-        "    c_parent.name, "         //-- 父分类
-        "    c_child.name, "          //-- 子分类
-        "    a.name, "                //-- 账户
-        "    m.name, "                //-- 成员
-        "    r.amount, "
-        "    r.remark, "
-        "    r.updated_at "
-        "FROM records r "
-        "JOIN categories c_child ON r.category_id = c_child.id "
-        "LEFT JOIN categories c_parent ON c_child.parent_id = c_parent.id "
-        "JOIN accounts a ON r.account_id = a.id "
-        "LEFT JOIN members m ON r.member_id = m.id "
-        "WHERE r.date = ? "
-        "ORDER BY r.date DESC, r.id DESC;";
-
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        printf("❌ 查询准备失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return;
-    }
-
-    sqlite3_bind_text(stmt, 1, input, -1, SQLITE_STATIC);
-
-    print_record_header();
-    int found = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        print_record_row(stmt);
-        found = 1;
-    }
-
-    if (!found) {
+    if (record_query_print(&f, stderr) == 0) {
         printf("📝 未找到 %s 的记录。\n", input);
     }
-
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
 }
 
 //按分类查询收支记录的函数
@@ -1025,166 +1022,198 @@ void query_by_category(void) {
         return;
     }
 
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
-        return;
+    // 在子分类或父分类中模糊匹配
+    RecordFilter f;
+    record_filter_init(&f);
+    f.category_like = input;
+    if (record_query_print(&f, stderr) == 0) {
+        printf("📝 未找到包含“%s”的分类记录。\n", input);
     }
+}
 
-    // 在子分类或父分类中模糊匹配
-    const char* sql = 
-        "SELECT "
-        "    r.id, "
-        "    r.date, "
-        "    r.type, "
-        "    c_parent.name, "
-        "    c_child.name, "
-        "    a.name, "
-        "    m.name, "
-        "    r.amount, "
-        "    r.remark, "
-        "    r.updated_at "
-        "FROM records r "
-        "JOIN categories c_child ON r.category_id = c_child.id "
-        "LEFT JOIN categories c_parent ON c_child.parent_id = c_parent.id "
-        "JOIN accounts a ON r.account_id = a.id "
-        "LEFT JOIN members m ON r.member_id = m.id "
-        "WHERE c_child.name LIKE ? OR (c_parent.name IS NOT NULL AND c_parent.name LIKE ?) "
-        "ORDER BY r.date DESC, r.id DESC;";
+// 按月或按年汇总收支（读取 rollup_month_type 汇总行，新的在前），每行回调一次
+// 报表引擎设为列式快照或并行扫描时改用对应引擎，引擎不可用则退回汇总表
+int report_period_totals(int yearly, PeriodRowFn fn, void* ctx) {
+    sqlite3* db = db_get();
+    if (!db) return 0;
+    int engine = report_engine_current();
+    if ((engine == REPORT_ENGINE_SNAPSHOT && snapshot_period_totals(yearly, fn, ctx))
+        || (engine == REPORT_ENGINE_PARALLEL && parallel_period_totals(yearly, fn, ctx))) {
+        return 1;
+    }
+
+    const char* sql = yearly
+        ? "SELECT "
+          "  substr(month, 1, 4) AS year, "
+          "  SUM(CASE WHEN type = 'income' THEN total ELSE 0 END) AS total_income, "
+          "  SUM(CASE WHEN type = 'expense' THEN total ELSE 0 END) AS total_expense "
+          "FROM rollup_month_type "
+          "GROUP BY year "
+          "ORDER BY year DESC;"
+        : "SELECT "
+          "  month, "
+          "  SUM(CASE WHEN type = 'income' THEN total ELSE 0 END) AS total_income, "
+          "  SUM(CASE WHEN type = 'expense' THEN total ELSE 0 END) AS total_expense "
+          "FROM rollup_month_type "
+          "GROUP BY month "
+          "ORDER BY month DESC;";
 
     sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        printf("❌ 查询准备失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return;
+    if ((stmt = db_prepare(db, sql)) == NULL) {
+        fprintf(stderr, "❌ 查询失败: %s\n", sqlite3_errmsg(db));
+        return 0;
     }
-
-    char pattern[60];
-    snprintf(pattern, sizeof(pattern), "%%%s%%", input);
-    sqlite3_bind_text(stmt, 1, pattern, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, pattern, -1, SQLITE_STATIC); // 绑定两次
-
-    print_record_header();
-    int found = 0;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        print_record_row(stmt);
-        found = 1;
+        fn(ctx, (const char*)sqlite3_column_text(stmt, 0),
+           sqlite3_column_int64(stmt, 1), sqlite3_column_int64(stmt, 2));
     }
+    db_release(stmt);
+    return 1;
+}
 
-    if (!found) {
-        printf("📝 未找到包含“%s”的分类记录。\n", input);
+// 按分类路径汇总某一类型的金额（金额大的在前）
+// 汇总表（或列式快照、并行扫描）按 category_id 聚合，路径由内存分类树解析，排序在 C 中完成
+typedef struct {
+    const char* path;       // NULL 表示分类树中找不到（已被其他客户端删除）
+    int category_id;
+    int64_t total;
+} CategoryTotal;
+
+typedef struct {
+    CategoryTotal* rows;
+    int count;
+    int cap;
+    int error;
+} CategoryTotals;
+
+static void collect_category_total(void* ctx, int category_id, int64_t total) {
+    CategoryTotals* t = ctx;
+    if (t->error) return;
+    const CategoryNode* node = category_tree_find(category_id);   // 找不到时仍计入，以 id 标出
+    if (t->count == t->cap) {
+        int cap = t->cap ? t->cap * 2 : 64;
+        CategoryTotal* grown = realloc(t->rows, sizeof(CategoryTotal) * cap);
+        if (!grown) {
+            t->error = 1;
+            return;
+        }
+        t->rows = grown;
+        t->cap = cap;
     }
+    t->rows[t->count].path = node ? node->path : NULL;
+    t->rows[t->count].category_id = category_id;
+    t->rows[t->count].total = total;
+    t->count++;
+}
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+static int compare_category_total(const void* a, const void* b) {
+    const CategoryTotal* x = a;
+    const CategoryTotal* y = b;
+    if (x->total != y->total) return x->total < y->total ? 1 : -1;
+    if (!x->path || !y->path) return x->path ? -1 : (y->path ? 1 : x->category_id - y->category_id);
+    return strcmp(x->path, y->path);
 }
 
-//月度统计报表
-void show_monthly_report(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
-        return;
+int report_category_totals(const char* type, CategoryRowFn fn, void* ctx) {
+    sqlite3* db = db_get();
+    if (!db) return 0;
+    if (!category_tree_get()) return 0;
+
+    CategoryTotals totals = { NULL, 0, 0, 0 };
+    int engine = report_engine_current();
+    int done = (engine == REPORT_ENGINE_SNAPSHOT && snapshot_category_totals(type, collect_category_total, &totals))
+            || (engine == REPORT_ENGINE_PARALLEL && parallel_category_totals(type, collect_category_total, &totals));
+    if (!done) {
+        totals.count = 0;
+        totals.error = 0;
+        sqlite3_stmt* stmt = db_prepare(db,
+            "SELECT category_id, SUM(total) FROM rollup_month_category_member "
+            "WHERE type = ? GROUP BY category_id;");
+        if (!stmt) {
+            fprintf(stderr, "❌ 查询失败: %s\n", sqlite3_errmsg(db));
+            free(totals.rows);
+            return 0;
+        }
+        sqlite3_bind_text(stmt, 1, type, -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            collect_category_total(&totals, sqlite3_column_int(stmt, 0), sqlite3_column_int64(stmt, 1));
+        }
+        db_release(stmt);
     }
 
-    const char* sql = 
-        "SELECT "
-        "  strftime('%Y-%m', date) AS month, "
-        "  SUM(CASE WHEN type = 'income' THEN amount ELSE 0 END) AS total_income, "
-        "  SUM(CASE WHEN type = 'expense' THEN amount ELSE 0 END) AS total_expense "
-        "FROM records "
-        "GROUP BY month "
-        "ORDER BY month DESC;";
-
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        printf("❌ 查询失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return;
+    if (totals.count > 1) qsort(totals.rows, totals.count, sizeof(CategoryTotal), compare_category_total);
+    char unknown[48];
+    for (int i = 0; i < totals.count; i++) {
+        const char* path = totals.rows[i].path;
+        if (!path) {
+            snprintf(unknown, sizeof(unknown), "（未知分类 #%d）", totals.rows[i].category_id);
+            path = unknown;
+        }
+        fn(ctx, path, totals.rows[i].total);
     }
+    free(totals.rows);
+    return !totals.error;
+}
 
-    printf("\n📊 月度报表（基于业务日期）\n");
-    printf("%-8s %-12s %-12s %-12s\n", "年月", "收入", "支出", "结余");
-    print_separator(50);
+// 报表打印状态（列宽 + 合计）
+typedef struct {
+    int label_width;
+    int64_t income;
+    int64_t expense;
+    int found;
+} ReportPrinter;
+
+static void print_period_row(void* ctx, const char* label, int64_t income, int64_t expense) {
+    ReportPrinter* p = ctx;
+    char income_text[MONEY_BUF_SIZE], expense_text[MONEY_BUF_SIZE], balance_text[MONEY_BUF_SIZE];
+    format_money(income, income_text, sizeof(income_text));
+    format_money(expense, expense_text, sizeof(expense_text));
+    format_money(income - expense, balance_text, sizeof(balance_text));
+    printf("%-*s %-12s %-12s %-12s\n", p->label_width, label, income_text, expense_text, balance_text);
+    p->income += income;
+    p->expense += expense;
+    p->found = 1;
+}
 
-    double grand_income = 0.0, grand_expense = 0.0;
-    int found = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const char* month = (const char*)sqlite3_column_text(stmt, 0);
-        double income = sqlite3_column_double(stmt, 1);
-        double expense = sqlite3_column_double(stmt, 2);
-        double balance = income - expense;
-
-        printf("%-8s %-12.2f %-12.2f %-12.2f\n", month, income, expense, balance);
-        grand_income += income;
-        grand_expense += expense;
-        found = 1;
+static void show_period_report(int yearly) {
+    ReportPrinter p = { yearly ? 6 : 8, 0, 0, 0 };
+    int line = yearly ? 48 : 50;
+
+    printf("\n📊 %s报表（基于业务日期）\n", yearly ? "年度" : "月度");
+    printf("%-*s %-12s %-12s %-12s\n", p.label_width, yearly ? "年份" : "年月", "收入", "支出", "结余");
+    print_separator(line);
+
+    if (!report_period_totals(yearly, print_period_row, &p)) {
+        printf("❌ 查询失败。\n");
+        return;
     }
 
-    if (!found) {
+    if (!p.found) {
         printf("📝 暂无记录。\n");
     } else {
-        print_separator(50);
-        printf("%-8s %-12.2f %-12.2f %-12.2f\n", 
-               "总计", grand_income, grand_expense, grand_income - grand_expense);
+        print_separator(line);
+        p.found = 0;
+        print_period_row(&p, "总计", p.income, p.expense);
     }
+}
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+//月度统计报表
+void show_monthly_report(void) {
+    show_period_report(0);
 }
 
 //年度统计报表
 void show_yearly_report(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
-        return;
-    }
-
-    const char* sql = 
-        "SELECT "
-        "  strftime('%Y', date) AS year, "
-        "  SUM(CASE WHEN type = 'income' THEN amount ELSE 0 END) AS total_income, "
-        "  SUM(CASE WHEN type = 'expense' THEN amount ELSE 0 END) AS total_expense "
-        "FROM records "
-        "GROUP BY year "
-        "ORDER BY year DESC;";
-
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        printf("❌ 查询失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return;
-    }
-
-    printf("\n📊 年度报表（基于业务日期）\n");
-    printf("%-6s %-12s %-12s %-12s\n", "年份", "收入", "支出", "结余");
-    print_separator(48);
-
-    double grand_income = 0.0, grand_expense = 0.0;
-    int found = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const char* year = (const char*)sqlite3_column_text(stmt, 0);
-        double income = sqlite3_column_double(stmt, 1);
-        double expense = sqlite3_column_double(stmt, 2);
-        double balance = income - expense;
-
-        printf("%-6s %-12.2f %-12.2f %-12.2f\n", year, income, expense, balance);
-        grand_income += income;
-        grand_expense += expense;
-        found = 1;
-    }
-
-    if (!found) {
-        printf("📝 暂无记录。\n");
-    } else {
-        print_separator(48);
-        printf("%-6s %-12.2f %-12.2f %-12.2f\n", 
-               "总计", grand_income, grand_expense, grand_income - grand_expense);
-    }
+    show_period_report(1);
+}
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+static void print_category_row(void* ctx, const char* category, int64_t total) {
+    ReportPrinter* p = ctx;
+    char total_text[MONEY_BUF_SIZE];
+    format_money(total, total_text, sizeof(total_text));
+    printf("%-20s %s\n", category, total_text);
+    p->income += total;
+    p->found = 1;
 }
 
 //分类统计报表
@@ -1211,111 +1240,49 @@ void show_category_report(void) {
         report_title = "📉 支出分类统计";
     }
 
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
-        return;
-    }
-
-    // ✅ 正确 JOIN categories，构建分类路径
-    const char* sql = 
-        "SELECT "
-        "  CASE "
-        "    WHEN c_parent.name IS NOT NULL THEN c_parent.name || ' > ' || c_child.name "
-        "    ELSE c_child.name "
-        "  END AS category_path, "
-        "  SUM(r.amount) AS total "
-        "FROM records r "
-        "JOIN categories c_child ON r.category_id = c_child.id "
-        "LEFT JOIN categories c_parent ON c_child.parent_id = c_parent.id "
-        "WHERE r.type = ? "
-        "GROUP BY category_path "
-        "ORDER BY total DESC;";
-
-    sqlite3_stmt* stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        printf("❌ 查询失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return;
-    }
-    sqlite3_bind_text(stmt, 1, type_filter, -1, SQLITE_STATIC);
-
     printf("\n%s\n", report_title);
     printf("%-20s %s\n", "分类", "金额");
     print_separator(30);
 
-    double grand_total = 0.0;
-    int found = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        const char* category = (const char*)sqlite3_column_text(stmt, 0);
-        double total = sqlite3_column_double(stmt, 1);
-        printf("%-20s %.2f\n", category, total);
-        grand_total += total;
-        found = 1;
+    ReportPrinter p = { 20, 0, 0, 0 };
+    if (!report_category_totals(type_filter, print_category_row, &p)) {
+        printf("❌ 查询失败。\n");
+        return;
     }
 
-    if (!found) {
+    if (!p.found) {
         printf("📝 暂无 %s 记录。\n", 
                strcmp(type_filter, "income") == 0 ? "收入" : "支出");
     } else {
         print_separator(30);
-        printf("%-20s %.2f\n", "总计", grand_total);
+        char total_text[MONEY_BUF_SIZE];
+        format_money(p.income, total_text, sizeof(total_text));
+        printf("%-20s %s\n", "总计", total_text);
     }
-
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
 }
 
 //账户选择（扁平列表）
 int select_account(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return -1;
     }
 
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, name FROM accounts ORDER BY id;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+    const DimList* accounts = dim_accounts();
+    if (!accounts) {
         printf("❌ 查询账户失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
         return -1;
     }
 
     printf("\n--- 选择账户 ---\n");
-    int count = 0;
-    int capacity = 50;
-    int* account_ids = malloc(capacity * sizeof(int));
-    if (!account_ids) {
-        printf("❌ 内存不足\n");
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        return -1;
-    }
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        if (count >= capacity) {
-            capacity *= 2;
-            int* tmp = realloc(account_ids, capacity * sizeof(int));
-            if (!tmp) {
-                free(account_ids);
-                sqlite3_finalize(stmt);
-                sqlite3_close(db);
-                return -1;
-            }
-            account_ids = tmp;
-        }
-        account_ids[count] = sqlite3_column_int(stmt, 0);
-        const char* name = (const char*)sqlite3_column_text(stmt, 1);
-        printf("%d. %s\n", count + 1, name);
-        count++;
+    int count = accounts->count;
+    for (int i = 0; i < count; i++) {
+        printf("%d. %s\n", i + 1, accounts->entries[i].name);
     }
-    sqlite3_finalize(stmt);
 
     if (count == 0) {
         printf("⚠️ 无可用账户，请先在系统设置中添加。\n");
-        free(account_ids);
-        sqlite3_close(db);
         return -1;
     }
 
@@ -1330,84 +1297,49 @@ int select_account(void) {
 
     if (choice < 1 || choice > count) {
         printf("❌ 无效选项！\n");
-        free(account_ids);
-        sqlite3_close(db);
         return -1;
     }
 
-    int selected_id = account_ids[choice - 1];
-    free(account_ids);
-    sqlite3_close(db);
-    return selected_id;
+    return accounts->entries[choice - 1].id;
 }
 
 // 分类选择（带层级）
 int select_category(const char* type) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库: %s\n", sqlite3_errmsg(db));
+    const CategoryTree* tree = category_tree_get();
+    if (!tree) {
+        printf("❌ 查询分类失败。\n");
         return -1;
     }
 
-    // 查询一级分类
-    sqlite3_stmt* stmt;
-    const char* sql_top = 
-        "SELECT id, name FROM categories WHERE type = ? AND parent_id IS NULL ORDER BY id;";
-    if (sqlite3_prepare_v2(db, sql_top, -1, &stmt, NULL) != SQLITE_OK) {
-        printf("❌ 查询分类失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return -1;
-    }
-    sqlite3_bind_text(stmt, 1, type, -1, SQLITE_STATIC);
-
     printf("\n--- 选择%s分类 ---\n", 
            strcmp(type, "income") == 0 ? "收入" : "支出");
 
-    #define MAX_CATEGORIES 200
-    int all_ids[MAX_CATEGORIES];
-    char all_labels[MAX_CATEGORIES][100];
-    int total = 0;
+    // 先序遍历：一级分类按类型筛选，子分类跟随其父分类
+    int* ids = malloc(sizeof(int) * (tree->count > 0 ? tree->count : 1));
+    if (!ids) return -1;
+    int total = 0, parent_shown = 0;
 
-    // 添加一级分类
-    while (sqlite3_step(stmt) == SQLITE_ROW && total < MAX_CATEGORIES) {
-        int id = sqlite3_column_int(stmt, 0);
-        const char* name = (const char*)sqlite3_column_text(stmt, 1);
-        all_ids[total] = id;
-        snprintf(all_labels[total], sizeof(all_labels[total]), "%s", name);
-        total++;
+    printf("\n可用分类:\n");
+    for (int i = 0; i < tree->count; i++) {
+        const CategoryNode* node = &tree->nodes[i];
+        if (node->depth == 0) {
+            parent_shown = (strcmp(node->type, type) == 0);
+            if (!parent_shown) continue;
+            ids[total++] = node->id;
+            printf("%2d. %s\n", total, node->name);
+        } else if (parent_shown) {
+            ids[total++] = node->id;
+            printf("%2d.   └─ %s\n", total, node->name);
+        }
     }
-    sqlite3_finalize(stmt);
 
     if (total == 0) {
         printf("⚠️ 暂无%s分类，请先添加。\n", 
                strcmp(type, "income") == 0 ? "收入" : "支出");
-        sqlite3_close(db);
+        free(ids);
         return -1;
     }
 
-    // 添加子分类
-    for (int i = 0; i < total && total < MAX_CATEGORIES; i++) {
-        sqlite3_stmt* sub_stmt;
-        const char* sql_sub = "SELECT id, name FROM categories WHERE parent_id = ? ORDER BY id;";
-        if (sqlite3_prepare_v2(db, sql_sub, -1, &sub_stmt, NULL) != SQLITE_OK) continue;
-        sqlite3_bind_int(sub_stmt, 1, all_ids[i]);
-
-        while (sqlite3_step(sub_stmt) == SQLITE_ROW && total < MAX_CATEGORIES) {
-            int sub_id = sqlite3_column_int(sub_stmt, 0);
-            const char* sub_name = (const char*)sqlite3_column_text(sub_stmt, 1);
-            all_ids[total] = sub_id;
-            snprintf(all_labels[total], sizeof(all_labels[total]), "  └─ %s", sub_name);
-            total++;
-        }
-        sqlite3_finalize(sub_stmt);
-    }
-
-    // 显示完整列表
-    printf("\n可用分类:\n");
-    for (int i = 0; i < total; i++) {
-        printf("%2d. %s\n", i + 1, all_labels[i]);
-    }
-
     int choice;
     printf("请选择编号 (1-%d): ", total);
     if (scanf("%d", &choice) != 1) choice = -1;
@@ -1415,36 +1347,32 @@ int select_category(const char* type) {
 
     if (choice < 1 || choice > total) {
         printf("❌ 无效选项！\n");
-        sqlite3_close(db);
+        free(ids);
         return -1;
     }
 
-    int selected_id = all_ids[choice - 1];
-    sqlite3_close(db);
+    int selected_id = ids[choice - 1];
+    free(ids);
     return selected_id;
 }
 
 //成员选择器函数
 int select_member(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return -1;
     }
 
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, name FROM members ORDER BY id;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        sqlite3_close(db);
+    const DimList* members = dim_members();
+    if (!members) {
         return -1;
     }
 
     printf("\n【成员列表】\n");
     printf("0) 跳过（默认本人）\n");
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const char* name = (const char*)sqlite3_column_text(stmt, 1);
-        printf("%d) %s\n", id, name);
+    for (int i = 0; i < members->count; i++) {
+        printf("%d) %s\n", members->entries[i].id, members->entries[i].name);
     }
 
     int choice;
@@ -1456,8 +1384,5 @@ int select_member(void) {
     }
     getchar(); // 清除换行
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-
     return (choice > 0) ? choice : -1; // -1 表示使用默认
 }
\ No newline at end of file
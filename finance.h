@@ -2,17 +2,43 @@
 #ifndef FINANCE_H
 #define FINANCE_H
 
+#include <stdio.h>
+#include <stdint.h>
+#include "sqlite3.h"
+
 void init_finance_database(void);
+int drop_record_indexes(sqlite3* db);
 void add_record(void);
 void list_records(void);
 void edit_record(void);
 void delete_record(void);
 void export_to_csv(void);
+long write_records_csv(FILE* fp);
+long write_records_csv_where(FILE* fp, int with_bom, const char* tail_sql,
+                             const char* const* params, int param_count);
+
+// 列表查询公共部分：只取 records 的窄列，分类/账户/成员名称由维度缓存解析（列顺序见 print_record_row）
+#define RECORD_LIST_SELECT \
+    "SELECT r.id, r.date, r.type, r.category_id, r.account_id, r.member_id, " \
+    "r.amount, r.remark, r.updated_at " \
+    "FROM records r "
+void print_record_header(void);
+void print_record_row(sqlite3_stmt* stmt);
+long write_records_csv_stmt(FILE* fp, int with_bom, sqlite3_stmt* stmt);
+sqlite3_int64 insert_record(const char* date, const char* type, int category_id, int64_t amount,
+                            int account_id, int member_id, const char* remark);
 void query_by_date(void);
 void query_by_category(void);
 void show_monthly_report(void);
 void show_yearly_report(void);
 void show_category_report(void);
+
+// 报表数据（菜单与命令行共用）
+typedef void (*PeriodRowFn)(void* ctx, const char* period, int64_t income, int64_t expense);
+typedef void (*CategoryRowFn)(void* ctx, const char* category, int64_t total);
+int report_period_totals(int yearly, PeriodRowFn fn, void* ctx);
+int report_category_totals(const char* type, CategoryRowFn fn, void* ctx);
+
 int select_category(const char* type);
 int select_account(void);
 int select_member(void);
@@ -0,0 +1,535 @@
+// import.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "csv.h"
+#include "money.h"
+#include "utils.h"
+#include "finance.h"
+#include "date.h"
+#include "import.h"
+#include "rollup.h"
+#include "search.h"
+#include "balance.h"
+#include "dim.h"
+
+#define IMPORT_BATCH_ROWS 50000     // 每个事务的记录数
+#define IMPORT_MAX_ERRORS 10        // 最多逐条打印的错误行
+#define IMPORT_CACHE_KB (256 * 1024) // 导入期间的页缓存，避免事务中途溢出到磁盘
+#define IMPORT_BULK_MIN_ROWS 100000 // 预计行数超过此值且不少于现有记录时走批量路径
+#define IMPORT_BYTES_PER_ROW 64     // 按文件大小估算行数
+
+// === 名称 -> id 哈希表（开放寻址，FNV-1a）===
+typedef struct {
+    char* name;
+    int id;
+    char type[8];                   // 仅分类使用
+} NameEntry;
+
+typedef struct {
+    NameEntry* slots;
+    size_t cap;                     // 2 的幂
+    size_t count;
+} NameMap;
+
+static uint32_t name_hash(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static NameEntry* name_map_find(NameMap* m, const char* name) {
+    size_t i = name_hash(name) & (m->cap - 1);
+    while (m->slots[i].name) {
+        if (strcmp(m->slots[i].name, name) == 0) return &m->slots[i];
+        i = (i + 1) & (m->cap - 1);
+    }
+    return NULL;
+}
+
+static int name_map_put(NameMap* m, const char* name, int id, const char* type);
+
+static int name_map_grow(NameMap* m) {
+    NameMap grown = { calloc(m->cap * 2, sizeof(NameEntry)), m->cap * 2, 0 };
+    if (!grown.slots) return 0;
+    for (size_t i = 0; i < m->cap; i++) {
+        NameEntry* e = &m->slots[i];
+        if (!e->name) continue;
+        size_t j = name_hash(e->name) & (grown.cap - 1);
+        while (grown.slots[j].name) j = (j + 1) & (grown.cap - 1);
+        grown.slots[j] = *e;
+        grown.count++;
+    }
+    free(m->slots);
+    *m = grown;
+    return 1;
+}
+
+static int name_map_put(NameMap* m, const char* name, int id, const char* type) {
+    if ((m->count + 1) * 2 > m->cap && !name_map_grow(m)) return 0;
+    size_t i = name_hash(name) & (m->cap - 1);
+    while (m->slots[i].name) i = (i + 1) & (m->cap - 1);
+    m->slots[i].name = strdup(name);
+    if (!m->slots[i].name) return 0;
+    m->slots[i].id = id;
+    snprintf(m->slots[i].type, sizeof(m->slots[i].type), "%s", type ? type : "");
+    m->count++;
+    return 1;
+}
+
+static int name_map_init(NameMap* m) {
+    m->cap = 64;
+    m->count = 0;
+    m->slots = calloc(m->cap, sizeof(NameEntry));
+    return m->slots != NULL;
+}
+
+static void name_map_free(NameMap* m) {
+    if (!m->slots) return;
+    for (size_t i = 0; i < m->cap; i++) free(m->slots[i].name);
+    free(m->slots);
+    m->slots = NULL;
+}
+
+// 一次查询载入整张维度表
+static int load_names(sqlite3* db, const char* sql, NameMap* m) {
+    sqlite3_stmt* stmt = db_prepare(db, sql);
+    if (!stmt) return 0;
+    int ok = 1;
+    while (ok && sqlite3_step(stmt) == SQLITE_ROW) {
+        ok = name_map_put(m, (const char*)sqlite3_column_text(stmt, 1),
+                          sqlite3_column_int(stmt, 0),
+                          (const char*)sqlite3_column_text(stmt, 2));
+    }
+    db_release(stmt);
+    return ok;
+}
+
+// 插入一行维度数据并加入哈希表，返回新 id（失败返回 0）
+static int create_name(sqlite3* db, NameMap* m, const char* sql,
+                       const char* name, int parent_id, const char* type) {
+    sqlite3_stmt* stmt = db_prepare(db, sql);
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    if (type) {
+        if (parent_id > 0) sqlite3_bind_int(stmt, 2, parent_id);
+        else sqlite3_bind_null(stmt, 2);
+        sqlite3_bind_text(stmt, 3, type, -1, SQLITE_STATIC);
+    }
+    int id = 0;
+    if (sqlite3_step(stmt) == SQLITE_DONE) {
+        id = (int)sqlite3_last_insert_rowid(db);
+    }
+    db_release(stmt);
+    if (id > 0 && !name_map_put(m, name, id, type)) return 0;
+    return id;
+}
+
+// === 本批汇总增量（月份 × 类型 × 分类 × 成员）===
+typedef struct {
+    char month[8];                  // 'YYYY-MM'，空串表示空槽
+    int income;
+    int category_id;
+    int member_id;
+    int64_t total;
+    int64_t cnt;
+} RollupDelta;
+
+typedef struct {
+    RollupDelta* slots;
+    size_t cap;                     // 2 的幂
+    size_t count;
+} RollupMap;
+
+static size_t rollup_slot(const RollupMap* m, const char* month, int income, int category_id, int member_id) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 7; i++) h = (h ^ (unsigned char)month[i]) * 16777619u;
+    h = (h ^ (uint32_t)income) * 16777619u;
+    h = (h ^ (uint32_t)category_id) * 16777619u;
+    h = (h ^ (uint32_t)member_id) * 16777619u;
+    size_t i = h & (m->cap - 1);
+    while (m->slots[i].month[0]) {
+        const RollupDelta* d = &m->slots[i];
+        if (d->income == income && d->category_id == category_id && d->member_id == member_id
+            && memcmp(d->month, month, 7) == 0) {
+            break;
+        }
+        i = (i + 1) & (m->cap - 1);
+    }
+    return i;
+}
+
+static int rollup_map_add(RollupMap* m, const char* date, int income, int category_id, int member_id, int64_t amount) {
+    if ((m->count + 1) * 2 > m->cap) {
+        RollupMap grown = { calloc(m->cap * 2, sizeof(RollupDelta)), m->cap * 2, m->count };
+        if (!grown.slots) return 0;
+        for (size_t i = 0; i < m->cap; i++) {
+            const RollupDelta* d = &m->slots[i];
+            if (d->month[0]) grown.slots[rollup_slot(&grown, d->month, d->income, d->category_id, d->member_id)] = *d;
+        }
+        free(m->slots);
+        *m = grown;
+    }
+    RollupDelta* d = &m->slots[rollup_slot(m, date, income, category_id, member_id)];
+    if (!d->month[0]) {
+        memcpy(d->month, date, 7);
+        d->month[7] = '\0';
+        d->income = income;
+        d->category_id = category_id;
+        d->member_id = member_id;
+        m->count++;
+    }
+    d->total += amount;
+    d->cnt++;
+    return 1;
+}
+
+// === 导入上下文 ===
+typedef struct {
+    sqlite3* db;
+    NameMap categories;
+    NameMap accounts;
+    NameMap members;
+    int64_t* deltas;                // 按账户 id 索引的本批余额变化
+    int deltas_cap;
+    long pending;                   // 本批已插入、尚未提交的记录数
+    int bulk;                       // 批量路径：汇总触发器已暂停，由 rollups 维护
+    RollupMap rollups;
+    char now[20];                   // 导入时刻，所有记录共用（逐行 localtime 换算开销很大）
+    ImportStats* stats;
+    FILE* err;                      // 逐行跳过原因与错误（命令行/守护进程模式为 cli_err）
+} Importer;
+
+static int add_delta(Importer* im, int account_id, int64_t delta) {
+    if (account_id >= im->deltas_cap) {
+        int cap = im->deltas_cap ? im->deltas_cap : 64;
+        while (cap <= account_id) cap *= 2;
+        int64_t* grown = realloc(im->deltas, sizeof(int64_t) * cap);
+        if (!grown) return 0;
+        memset(grown + im->deltas_cap, 0, sizeof(int64_t) * (cap - im->deltas_cap));
+        im->deltas = grown;
+        im->deltas_cap = cap;
+    }
+    im->deltas[account_id] += delta;
+    return 1;
+}
+
+// 每批提交前把累计的余额变化一次性写入各账户
+static int flush_deltas(Importer* im) {
+    sqlite3_stmt* stmt = db_prepare(im->db, "UPDATE accounts SET balance = balance + ? WHERE id = ?");
+    if (!stmt) return 0;
+    int ok = 1;
+    for (int id = 1; ok && id < im->deltas_cap; id++) {
+        if (im->deltas[id] == 0) continue;
+        sqlite3_bind_int64(stmt, 1, im->deltas[id]);
+        sqlite3_bind_int(stmt, 2, id);
+        ok = (sqlite3_step(stmt) == SQLITE_DONE);
+        sqlite3_reset(stmt);
+        im->deltas[id] = 0;
+    }
+    db_release(stmt);
+    return ok;
+}
+
+static int resolve_category(Importer* im, const char* parent, const char* child, const char* type) {
+    const char* sql = "INSERT INTO categories (name, parent_id, type) VALUES (?, ?, ?);";
+    const char* name = child[0] ? child : parent;
+    if (name[0] == '\0') return 0;
+
+    NameEntry* e = name_map_find(&im->categories, name);
+    if (e) return (strcmp(e->type, type) == 0) ? e->id : -1;
+
+    int parent_id = 0;
+    if (child[0] && parent[0]) {
+        NameEntry* p = name_map_find(&im->categories, parent);
+        if (p) {
+            if (strcmp(p->type, type) != 0) return -1;
+            parent_id = p->id;
+        } else {
+            parent_id = create_name(im->db, &im->categories, sql, parent, 0, type);
+            if (parent_id <= 0) return 0;
+            im->stats->created_categories++;
+        }
+    }
+    int id = create_name(im->db, &im->categories, sql, name, parent_id, type);
+    if (id > 0) im->stats->created_categories++;
+    return id;
+}
+
+static int resolve_simple(Importer* im, NameMap* m, const char* sql, const char* name, int* created) {
+    NameEntry* e = name_map_find(m, name);
+    if (e) return e->id;
+    int id = create_name(im->db, m, sql, name, 0, NULL);
+    if (id > 0) (*created)++;
+    return id;
+}
+
+static void report_row_error(Importer* im, long line, const char* reason) {
+    if (im->stats->skipped < IMPORT_MAX_ERRORS) {
+        fprintf(im->err, "⚠️  第 %ld 行已跳过：%s\n", line, reason);
+    }
+    im->stats->skipped++;
+}
+
+// 处理一条 CSV 记录；字段顺序与 export_to_csv 一致
+static void import_row(Importer* im, sqlite3_stmt* insert, const CsvReader* r) {
+    if (r->field_count < 9) {
+        report_row_error(im, r->line, "列数不足");
+        return;
+    }
+    const char* const* f = r->fields;
+    const char* date = f[1];
+    const char* type_text = f[2];
+    const char* updated_at = (r->field_count > 9 && f[9][0]) ? f[9] : NULL;
+
+    if (!date_is_valid(date)) {
+        report_row_error(im, r->line, "日期无效");
+        return;
+    }
+
+    const char* type;
+    if (strcmp(type_text, "收入") == 0 || strcmp(type_text, "income") == 0) {
+        type = "income";
+    } else if (strcmp(type_text, "支出") == 0 || strcmp(type_text, "expense") == 0) {
+        type = "expense";
+    } else {
+        report_row_error(im, r->line, "类型无效");
+        return;
+    }
+
+    int64_t amount;
+    if (!parse_money(f[7], &amount) || amount <= 0) {
+        report_row_error(im, r->line, "金额无效");
+        return;
+    }
+
+    int category_id = resolve_category(im, f[3], f[4], type);
+    if (category_id <= 0) {
+        report_row_error(im, r->line, category_id < 0 ? "分类类型与记录类型不符" : "分类无效");
+        return;
+    }
+    if (f[5][0] == '\0') {
+        report_row_error(im, r->line, "缺少账户");
+        return;
+    }
+    int account_id = resolve_simple(im, &im->accounts, "INSERT INTO accounts (name) VALUES (?);",
+                                    f[5], &im->stats->created_accounts);
+    int member_id = 0;
+    if (f[6][0]) {
+        member_id = resolve_simple(im, &im->members, "INSERT INTO members (name) VALUES (?);",
+                                   f[6], &im->stats->created_members);
+    }
+    if (account_id <= 0 || (f[6][0] && member_id <= 0)) {
+        report_row_error(im, r->line, "无法创建账户或成员");
+        return;
+    }
+
+    sqlite3_bind_text(insert, 1, date, -1, SQLITE_STATIC);
+    sqlite3_bind_text(insert, 2, type, -1, SQLITE_STATIC);
+    sqlite3_bind_int(insert, 3, category_id);
+    sqlite3_bind_int64(insert, 4, amount);
+    sqlite3_bind_int(insert, 5, account_id);
+    if (member_id > 0) sqlite3_bind_int(insert, 6, member_id);
+    else sqlite3_bind_null(insert, 6);
+    if (f[8][0]) sqlite3_bind_text(insert, 7, f[8], -1, SQLITE_STATIC);
+    else sqlite3_bind_null(insert, 7);
+    sqlite3_bind_text(insert, 8, im->now, -1, SQLITE_STATIC);
+    sqlite3_bind_text(insert, 9, updated_at ? updated_at : im->now, -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(insert);
+    sqlite3_reset(insert);
+    if (rc != SQLITE_DONE) {
+        report_row_error(im, r->line, sqlite3_errmsg(im->db));
+        return;
+    }
+    int income = (strcmp(type, "income") == 0);
+    add_delta(im, account_id, income ? amount : -amount);
+    if (im->bulk) rollup_map_add(&im->rollups, date, income, category_id, member_id, amount);
+    im->pending++;
+}
+
+// 批量路径下把本批汇总增量写入汇总表（与记录同一事务）
+static int flush_rollups(Importer* im) {
+    RollupMap* m = &im->rollups;
+    int ok = 1;
+    for (size_t i = 0; i < m->cap; i++) {
+        RollupDelta* d = &m->slots[i];
+        if (!d->month[0]) continue;
+        if (ok) {
+            ok = rollup_add(im->db, d->month, d->income ? "income" : "expense",
+                            d->category_id, d->member_id, d->total, d->cnt);
+        }
+        memset(d, 0, sizeof(*d));
+    }
+    m->count = 0;
+    return ok;
+}
+
+// 提交当前批次：余额变化 + 汇总增量 + COMMIT
+static int commit_batch(Importer* im) {
+    if (!flush_deltas(im) || (im->bulk && !flush_rollups(im))
+        || sqlite3_exec(im->db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        return 0;
+    }
+    im->stats->imported += im->pending;
+    im->pending = 0;
+    return 1;
+}
+
+static long estimate_rows(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+    long size = (fseek(fp, 0, SEEK_END) == 0) ? ftell(fp) : 0;
+    fclose(fp);
+    return size > 0 ? size / IMPORT_BYTES_PER_ROW : 0;
+}
+
+static long count_records(sqlite3* db) {
+    long n = 0;
+    sqlite3_stmt* stmt = db_prepare(db, "SELECT COUNT(*) FROM records;");
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) n = (long)sqlite3_column_int64(stmt, 0);
+    db_release(stmt);
+    return n;
+}
+
+// 导入期间放大页缓存并暂停 WAL 自动检查点（每批提交都做一次检查点代价很高），
+// 结束后恢复配置并一次性检查点
+static void set_import_pragmas(sqlite3* db, int importing) {
+    char sql[96];
+    int kb = importing ? IMPORT_CACHE_KB : db_profile_spec(db_current_profile())->cache_size_kb;
+    snprintf(sql, sizeof(sql), "PRAGMA cache_size = -%d; PRAGMA wal_autocheckpoint = %d;",
+             kb, importing ? 0 : 1000);
+    sqlite3_exec(db, sql, NULL, NULL, NULL);
+    if (!importing) sqlite3_exec(db, "PRAGMA wal_checkpoint(TRUNCATE);", NULL, NULL, NULL);
+}
+
+int import_csv_file(const char* path, ImportStats* stats, FILE* err) {
+    memset(stats, 0, sizeof(*stats));
+    sqlite3* db = db_get();
+    if (!db) return 0;
+
+    CsvReader reader;
+    if (!csv_reader_open(&reader, path)) return 0;
+
+    Importer im;
+    memset(&im, 0, sizeof(im));
+    im.db = db;
+    im.stats = stats;
+    im.err = err ? err : stderr;
+    im.rollups.cap = 1024;
+    im.rollups.slots = calloc(im.rollups.cap, sizeof(RollupDelta));
+    int ok = im.rollups.slots != NULL
+          && name_map_init(&im.categories) && name_map_init(&im.accounts) && name_map_init(&im.members)
+          && load_names(db, "SELECT id, name, type FROM categories;", &im.categories)
+          && load_names(db, "SELECT id, name, NULL FROM accounts;", &im.accounts)
+          && load_names(db, "SELECT id, name, NULL FROM members;", &im.members);
+
+    // 大批量导入：先删除二级索引、暂停汇总、余额检查点与备注索引触发器，写完后一次性排序建索引，
+    // 比逐行维护 5 个随机顺序的 B 树快得多；汇总改为按批聚合后写入，检查点与备注索引最后整体重建
+    long estimated = estimate_rows(path);
+    im.bulk = ok && estimated >= IMPORT_BULK_MIN_ROWS && estimated >= count_records(db);
+    if (im.bulk && !(drop_record_indexes(db) && suspend_rollups(db)
+                     && suspend_balance_ledger(db) && suspend_search_index(db))) {
+        im.bulk = 0;
+        init_finance_database();
+    }
+    set_import_pragmas(db, 1);
+
+    sqlite3_stmt* now_stmt = db_prepare(db, "SELECT datetime('now', 'localtime');");
+    if (now_stmt && sqlite3_step(now_stmt) == SQLITE_ROW) {
+        snprintf(im.now, sizeof(im.now), "%s", (const char*)sqlite3_column_text(now_stmt, 0));
+    }
+    db_release(now_stmt);
+
+    // 整个导入复用同一条 INSERT
+    sqlite3_stmt* insert = NULL;
+    if (ok && (insert = db_prepare(db,
+            "INSERT INTO records (date, type, category_id, amount, account_id, member_id, remark, created_at, updated_at) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);")) == NULL) {
+        fprintf(im.err, "❌ 准备语句失败: %s\n", sqlite3_errmsg(db));
+        ok = 0;
+    }
+
+    int rc = 0;
+    long in_batch = 0;
+    int first = 1;
+    while (ok && (rc = csv_read_record(&reader)) == 1) {
+        if (first) {
+            first = 0;
+            if (strcmp(reader.fields[0], "ID") == 0) continue;   // 表头
+        }
+        if (in_batch == 0 && sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK) {
+            ok = 0;
+            break;
+        }
+        import_row(&im, insert, &reader);
+        if (++in_batch == IMPORT_BATCH_ROWS) {
+            ok = commit_batch(&im);
+            in_batch = 0;
+        }
+    }
+    if (rc < 0) {
+        fprintf(im.err, "❌ 第 %ld 行 CSV 格式错误（引号未闭合或内存不足），导入中止。\n", reader.line);
+        ok = 0;
+    }
+    if (ok && in_batch > 0) {
+        ok = commit_batch(&im);
+    }
+    if (!ok && !sqlite3_get_autocommit(db)) {
+        sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);   // 只丢弃未提交的当前批次
+    }
+
+    db_release(insert);
+    if (im.bulk) {
+        resume_rollups(db);
+        init_finance_database();    // 按版本号重建索引与备注索引
+    }
+    set_import_pragmas(db, 0);
+    if (stats->created_categories || stats->created_accounts || stats->created_members) {
+        dim_invalidate();
+    }
+    name_map_free(&im.categories);
+    name_map_free(&im.accounts);
+    name_map_free(&im.members);
+    free(im.deltas);
+    free(im.rollups.slots);
+    csv_reader_close(&reader);
+    return ok;
+}
+
+void import_from_csv(void) {
+    char filename[256];
+    printf("请输入导入文件名（默认: records.csv）: ");
+    if (fgets(filename, sizeof(filename), stdin) == NULL) {
+        filename[0] = '\0';
+    }
+    filename[strcspn(filename, "\n")] = 0;
+    if (strlen(filename) == 0) {
+        strcpy(filename, "records.csv");
+    }
+
+    ImportStats stats;
+    double start = now_ms();
+    int ok = import_csv_file(filename, &stats, stderr);
+    double elapsed = now_ms() - start;
+
+    if (!ok && stats.imported == 0 && stats.skipped == 0) {
+        printf("❌ 无法导入文件 \"%s\"\n", filename);
+        return;
+    }
+    if (stats.skipped > IMPORT_MAX_ERRORS) {
+        printf("⚠️  另有 %ld 行被跳过（未逐条列出）\n", stats.skipped - IMPORT_MAX_ERRORS);
+    }
+    printf("%s 导入 %ld 条记录，跳过 %ld 行（耗时 %.0f ms）\n",
+           ok ? "✅" : "⚠️ ", stats.imported, stats.skipped, elapsed);
+    if (stats.created_categories || stats.created_accounts || stats.created_members) {
+        printf("   新建分类 %d 个、账户 %d 个、成员 %d 个\n",
+               stats.created_categories, stats.created_accounts, stats.created_members);
+    }
+}
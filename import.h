@@ -0,0 +1,22 @@
+// import.h
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include <stdio.h>
+
+// 导入统计
+typedef struct {
+    long imported;
+    long skipped;
+    int created_categories;
+    int created_accounts;
+    int created_members;
+} ImportStats;
+
+// 按导出格式（ID,日期,类型,父分类,子分类,账户,成员,金额,备注,更新时间）批量导入
+// 缺失的分类/账户/成员自动创建；逐行跳过原因与错误写到 err（NULL 为 stderr）
+// 返回 1 成功，0 失败（无法打开文件或事务失败）
+int import_csv_file(const char* path, ImportStats* stats, FILE* err);
+void import_from_csv(void);
+
+#endif
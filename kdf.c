@@ -0,0 +1,166 @@
+// kdf.c
+#ifdef _WIN32
+#define _CRT_RAND_S     // rand_s
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sha256.h"
+#include "utils.h"
+#include "kdf.h"
+
+#define HMAC_BLOCK 64
+
+// 预先吸收 (key ^ ipad) / (key ^ opad) 的两个上下文；之后每次 HMAC 只需复制上下文，
+// 对 32 字节消息各做一次压缩
+typedef struct {
+    SHA256_CTX inner;
+    SHA256_CTX outer;
+} HmacKey;
+
+static void hmac_key_init(HmacKey* hk, const uint8_t* key, size_t key_len) {
+    uint8_t block[HMAC_BLOCK] = {0};
+    if (key_len > HMAC_BLOCK) {
+        sha256(key, key_len, block);
+    } else {
+        memcpy(block, key, key_len);
+    }
+
+    uint8_t pad[HMAC_BLOCK];
+    for (int i = 0; i < HMAC_BLOCK; i++) pad[i] = block[i] ^ 0x36;
+    sha256_init(&hk->inner);
+    sha256_update(&hk->inner, pad, HMAC_BLOCK);
+    for (int i = 0; i < HMAC_BLOCK; i++) pad[i] = block[i] ^ 0x5c;
+    sha256_init(&hk->outer);
+    sha256_update(&hk->outer, pad, HMAC_BLOCK);
+
+    memset(block, 0, sizeof(block));
+    memset(pad, 0, sizeof(pad));
+}
+
+static void hmac_finish(const HmacKey* hk, SHA256_CTX* inner, uint8_t out[32]) {
+    uint8_t digest[SHA256_BLOCK_SIZE];
+    sha256_final(inner, digest);
+    SHA256_CTX outer = hk->outer;
+    sha256_update(&outer, digest, sizeof(digest));
+    sha256_final(&outer, out);
+}
+
+void hmac_sha256(const uint8_t* key, size_t key_len, const uint8_t* msg, size_t msg_len, uint8_t out[32]) {
+    HmacKey hk;
+    hmac_key_init(&hk, key, key_len);
+    SHA256_CTX inner = hk.inner;
+    sha256_update(&inner, msg, msg_len);
+    hmac_finish(&hk, &inner, out);
+    memset(&hk, 0, sizeof(hk));
+}
+
+// DK = T1 || T2 || ...，Ti = U1 ^ U2 ^ ... ^ Uc，U1 = HMAC(P, S || INT(i))，Uj = HMAC(P, Uj-1)
+void pbkdf2_hmac_sha256(const uint8_t* password, size_t password_len,
+                        const uint8_t* salt, size_t salt_len,
+                        uint32_t iterations, uint8_t* out, size_t out_len) {
+    HmacKey hk;
+    hmac_key_init(&hk, password, password_len);
+
+    for (uint32_t block = 1; out_len > 0; block++) {
+        uint8_t counter[4] = { (uint8_t)(block >> 24), (uint8_t)(block >> 16),
+                               (uint8_t)(block >> 8), (uint8_t)block };
+        uint8_t u[SHA256_BLOCK_SIZE], t[SHA256_BLOCK_SIZE];
+
+        SHA256_CTX inner = hk.inner;
+        sha256_update(&inner, salt, salt_len);
+        sha256_update(&inner, counter, sizeof(counter));
+        hmac_finish(&hk, &inner, u);
+        memcpy(t, u, sizeof(t));
+
+        for (uint32_t j = 1; j < iterations; j++) {
+            inner = hk.inner;
+            sha256_update(&inner, u, sizeof(u));
+            hmac_finish(&hk, &inner, u);
+            for (int i = 0; i < SHA256_BLOCK_SIZE; i++) t[i] ^= u[i];
+        }
+
+        size_t take = out_len < sizeof(t) ? out_len : sizeof(t);
+        memcpy(out, t, take);
+        out += take;
+        out_len -= take;
+        memset(u, 0, sizeof(u));
+        memset(t, 0, sizeof(t));
+    }
+    memset(&hk, 0, sizeof(hk));
+}
+
+uint32_t kdf_calibrate(double target_ms, double* rate) {
+    static const uint8_t password[] = "calibration";
+    static const uint8_t salt[] = "0123456789abcdef";
+    uint8_t out[SHA256_BLOCK_SIZE];
+
+    // 逐步加倍直到单次耗时足够长，避免计时粒度影响
+    uint32_t probe = 4096;
+    double elapsed = 0;
+    for (;;) {
+        double t0 = now_ms();
+        pbkdf2_hmac_sha256(password, sizeof(password) - 1, salt, sizeof(salt) - 1, probe, out, sizeof(out));
+        elapsed = now_ms() - t0;
+        if (elapsed >= 50.0 || probe >= KDF_MAX_ITERATIONS / 2) break;
+        probe *= 2;
+    }
+
+    double per_second = elapsed > 0 ? probe / (elapsed / 1000.0) : (double)KDF_MAX_ITERATIONS;
+    if (rate) *rate = per_second;
+
+    double wanted = per_second * target_ms / 1000.0;
+    if (wanted < KDF_MIN_ITERATIONS) return KDF_MIN_ITERATIONS;
+    if (wanted > KDF_MAX_ITERATIONS) return KDF_MAX_ITERATIONS;
+    return (uint32_t)(wanted / 1000.0) * 1000;      // 取整到千
+}
+
+int kdf_random_bytes(uint8_t* out, size_t len) {
+#ifdef _WIN32
+    while (len > 0) {
+        unsigned int value;
+        if (rand_s(&value) != 0) return 0;
+        size_t take = len < sizeof(value) ? len : sizeof(value);
+        memcpy(out, &value, take);
+        out += take;
+        len -= take;
+    }
+    return 1;
+#else
+    FILE* fp = fopen("/dev/urandom", "rb");
+    if (!fp) return 0;
+    size_t got = fread(out, 1, len, fp);
+    fclose(fp);
+    return got == len;
+#endif
+}
+
+// === 已知答案测试 ===
+typedef struct {
+    const char* password;
+    const char* salt;
+    uint32_t iterations;
+    const char* key;        // 64 字节派生密钥的十六进制
+} KdfVector;
+
+static const KdfVector kdf_vectors[] = {
+    { "passwd", "salt", 1,
+      "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc"
+      "49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783" },
+    { "Password", "NaCl", 80000,
+      "4ddcd8f60b98be21830cee5ef22701f9641a4418d04c0414aeff08876b34ab56"
+      "a1d425a1225833549adb841b51c9b3176a272bdebba1d078478f62b397f33c8d" },
+};
+
+int kdf_self_test(void) {
+    for (size_t v = 0; v < sizeof(kdf_vectors) / sizeof(kdf_vectors[0]); v++) {
+        const KdfVector* kv = &kdf_vectors[v];
+        uint8_t key[64];
+        char hex[sizeof(key) * 2 + 1];
+        pbkdf2_hmac_sha256((const uint8_t*)kv->password, strlen(kv->password),
+                           (const uint8_t*)kv->salt, strlen(kv->salt), kv->iterations, key, sizeof(key));
+        for (size_t i = 0; i < sizeof(key); i++) sprintf(hex + i * 2, "%02x", key[i]);
+        if (strcmp(hex, kv->key) != 0) return 0;
+    }
+    return 1;
+}
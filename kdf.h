@@ -0,0 +1,30 @@
+// kdf.h
+#ifndef KDF_H
+#define KDF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 口令派生：PBKDF2-HMAC-SHA256（RFC 8018），迭代次数越大，暴力破解每次猜测的代价越高。
+// 新口令默认使用 KDF_DEFAULT_ITERATIONS，可按本机速度校准（见 kdf_calibrate）
+#define KDF_DEFAULT_ITERATIONS 600000
+#define KDF_MIN_ITERATIONS     100000
+#define KDF_MAX_ITERATIONS     100000000
+#define KDF_TARGET_MS          100.0      // 校准目标：一次验证约 100 毫秒
+
+void hmac_sha256(const uint8_t* key, size_t key_len, const uint8_t* msg, size_t msg_len, uint8_t out[32]);
+void pbkdf2_hmac_sha256(const uint8_t* password, size_t password_len,
+                        const uint8_t* salt, size_t salt_len,
+                        uint32_t iterations, uint8_t* out, size_t out_len);
+
+// 实测本机每秒迭代次数，返回使一次派生耗时约 target_ms 的迭代次数（已取整并限制在上下限内）；
+// rate 可为 NULL
+uint32_t kdf_calibrate(double target_ms, double* rate);
+
+// 操作系统提供的密码学安全随机数，成功返回 1
+int kdf_random_bytes(uint8_t* out, size_t len);
+
+// 已知答案测试（RFC 7914 第 11 节 PBKDF2-HMAC-SHA256 向量），通过返回 1
+int kdf_self_test(void);
+
+#endif
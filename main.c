@@ -9,8 +9,15 @@
 #include "utils.h"
 #include "finance.h"
 #include "settings.h"
+#include "db.h"
+#include "import.h"
+#include "cli.h"
+#include "query.h"
+#include "search.h"
+#include "balance.h"
+#include "pivot.h"
 
-int main() {
+int main(int argc, char** argv) {
 
 //确定UTF-8编码环境
 #ifdef _WIN32
@@ -19,9 +26,20 @@ int main() {
     setlocale(LC_ALL, ".UTF8");
 #endif
 
+//带参数时走非交互命令行模式（脚本/定时任务）
+    if (argc > 1) {
+        return cli_main(argc, argv);
+    }
+
+//打开共享数据库连接（整个进程只打开一次）
+    if (!db_open(DATABASE_NAME)) return 1;
+
 //开发模式
 #ifndef DEBUG_MODE
-    if (!login_at_startup()) return 1; // 内部已处理初始化
+    if (!login_at_startup()) {
+        db_close();
+        return 1; // 内部已处理初始化
+    }
 #endif
 
 init_finance_database();// 首次运行时初始化数据库（包括成员、账户、分类等）
@@ -41,6 +59,11 @@ init_finance_database();// 首次运行时初始化数据库（包括成员、
         printf("9.  年度统计\n");
         printf("10. 分类统计\n");
         printf("11. 系统设置\n"); 
+        printf("12. 导入记录\n");
+        printf("13. 组合查询\n");
+        printf("14. 搜索备注\n");
+        printf("15. 账户余额\n");
+        printf("16. 透视报表\n");
         printf("0.  退出\n");
         printf("请选择: ");
 
@@ -64,10 +87,16 @@ init_finance_database();// 首次运行时初始化数据库（包括成员、
             case 9: show_yearly_report(); press_any_key_to_continue(); break;
             case 10: show_category_report(); press_any_key_to_continue(); break;
             case 11: show_settings_menu(); break;  // ← 新增：进入系统设置
+            case 12: import_from_csv(); press_any_key_to_continue(); break;
+            case 13: query_records_menu(); press_any_key_to_continue(); break;
+            case 14: search_remarks_menu(); press_any_key_to_continue(); break;
+            case 15: show_balances_menu(); press_any_key_to_continue(); break;
+            case 16: pivot_report_menu(); press_any_key_to_continue(); break;
             case 0: printf("再见！\n"); break;
             default: printf("无效选项！\n"); press_any_key_to_continue();
         }
     } while (choice != 0);
 
+    db_close();
     return 0;
 }
\ No newline at end of file
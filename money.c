@@ -0,0 +1,78 @@
+// money.c
+#include <stdio.h>
+#include <string.h>
+#include "money.h"
+
+// 上限：万亿元（防止溢出，远超家庭账本需要）
+#define MONEY_MAX_CENTS 100000000000000LL
+
+// 解析金额文本（如 "12"、"-3.5"、"0.05"），最多两位小数，不经过浮点
+// 成功返回 1 并写入 *out_cents；格式错误或超出范围返回 0
+int parse_money(const char* text, int64_t* out_cents) {
+    if (!text || !out_cents) return 0;
+
+    const char* p = text;
+    while (*p == ' ' || *p == '\t') p++;
+
+    int negative = 0;
+    if (*p == '+' || *p == '-') {
+        negative = (*p == '-');
+        p++;
+    }
+
+    int64_t units = 0;
+    int int_digits = 0;
+    while (*p >= '0' && *p <= '9') {
+        units = units * 10 + (*p - '0');
+        if (units > MONEY_MAX_CENTS / 100) return 0;
+        p++;
+        int_digits++;
+    }
+
+    int64_t frac = 0;
+    int frac_digits = 0;
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            if (frac_digits == 2) return 0; // 不接受超过分的精度
+            frac = frac * 10 + (*p - '0');
+            p++;
+            frac_digits++;
+        }
+    }
+    if (int_digits == 0 && frac_digits == 0) return 0;
+    if (frac_digits == 1) frac *= 10;
+
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p != '\0') return 0;
+
+    int64_t cents = units * 100 + frac;
+    *out_cents = negative ? -cents : cents;
+    return 1;
+}
+
+// 格式化为 "-1234.56" 形式（手写转换，避免 printf 浮点开销与舍入误差）
+size_t format_money(int64_t cents, char* buf, size_t size) {
+    if (!buf || size == 0) return 0;
+
+    char tmp[MONEY_BUF_SIZE];
+    int pos = sizeof(tmp);
+    tmp[--pos] = '\0';
+
+    // 取绝对值时用无符号，避免 INT64_MIN 溢出
+    uint64_t v = (cents < 0) ? (uint64_t)0 - (uint64_t)cents : (uint64_t)cents;
+    tmp[--pos] = (char)('0' + v % 10); v /= 10;
+    tmp[--pos] = (char)('0' + v % 10); v /= 10;
+    tmp[--pos] = '.';
+    do {
+        tmp[--pos] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (cents < 0) tmp[--pos] = '-';
+
+    size_t len = sizeof(tmp) - 1 - (size_t)pos;
+    if (len >= size) len = size - 1;
+    memcpy(buf, tmp + pos, len);
+    buf[len] = '\0';
+    return len;
+}
@@ -0,0 +1,14 @@
+// money.h
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 金额统一以 64 位整数“分”存储与计算，只在输入/显示边界转换
+#define MONEY_BUF_SIZE 32   // 足够容纳任意 int64 金额的文本形式
+
+int parse_money(const char* text, int64_t* out_cents);
+size_t format_money(int64_t cents, char* buf, size_t size);   // 返回写入长度
+
+#endif
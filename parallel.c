@@ -0,0 +1,271 @@
+// parallel.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "parallel.h"
+
+// === 工作线程数 ===
+static int cpu_count(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+
+int parallel_threads_setting(void) {
+    int threads = db_get_setting_int("report_threads", 0);
+    return (threads >= 0 && threads <= PARALLEL_MAX_THREADS) ? threads : 0;
+}
+
+int parallel_threads_set(int threads) {
+    if (threads < 0 || threads > PARALLEL_MAX_THREADS) return 0;
+    return db_set_setting_int("report_threads", threads);
+}
+
+int parallel_threads_effective(void) {
+    int threads = parallel_threads_setting();
+    if (threads == 0) threads = cpu_count();
+    return threads > PARALLEL_MAX_THREADS ? PARALLEL_MAX_THREADS : threads;
+}
+
+// === 只读连接池 ===
+// 连接在报表之间保留（省去打开文件与解析表结构）；共享连接改动表结构时 SQLite 会自动重新解析
+static sqlite3* pool[PARALLEL_MAX_THREADS];
+static char* pool_path;
+
+void parallel_reset(void) {
+    for (int i = 0; i < PARALLEL_MAX_THREADS; i++) {
+        sqlite3_close(pool[i]);
+        pool[i] = NULL;
+    }
+    free(pool_path);
+    pool_path = NULL;
+}
+
+static sqlite3* pool_get(int i, const char* path) {
+    if (pool_path && strcmp(pool_path, path) != 0) parallel_reset();
+    if (!pool_path && !(pool_path = strdup(path))) return NULL;
+    if (pool[i]) return pool[i];
+
+    sqlite3* conn = NULL;
+    if (sqlite3_open_v2(path, &conn, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK) {
+        fprintf(stderr, "❌ 无法打开只读连接: %s\n", conn ? sqlite3_errmsg(conn) : "内存不足");
+        sqlite3_close(conn);
+        return NULL;
+    }
+    sqlite3_busy_timeout(conn, 5000);
+    db_apply_profile(conn, db_current_profile());   // 缓存与 mmap 大小
+    pool[i] = conn;
+    return conn;
+}
+
+// === 部分合计 ===
+// 以整数键（年月序号或分类 id）为下标的 [键][类型] 数组，按需向两端扩展
+#define KEYED_MAX_SPAN (1 << 20)
+
+typedef struct {
+    int base;           // 最小键
+    int span;           // 已分配的键数
+    int64_t* sums;      // [(键 - base) * 2 + 类型]，类型 0 支出、1 收入
+} KeyedSums;
+
+static int keyed_add(KeyedSums* k, int key, int income, int64_t cents) {
+    if (!k->sums || key < k->base || key >= k->base + k->span) {
+        int lo = k->sums ? (key < k->base ? key : k->base) : key;
+        int hi = k->sums ? (key >= k->base + k->span ? key + 1 : k->base + k->span) : key + 1;
+        int span = k->span ? k->span : 64;
+        while (span < hi - lo) span *= 2;
+        if (span > KEYED_MAX_SPAN) return 0;
+        if (key < k->base) lo = hi - span;         // 向低端扩展时留出余量
+        int64_t* grown = calloc((size_t)span * 2, sizeof(int64_t));
+        if (!grown) return 0;
+        if (k->sums) memcpy(grown + (size_t)(k->base - lo) * 2, k->sums, sizeof(int64_t) * k->span * 2);
+        free(k->sums);
+        k->sums = grown;
+        k->base = lo;
+        k->span = span;
+    }
+    k->sums[(size_t)(key - k->base) * 2 + income] += cents;
+    return 1;
+}
+
+static int keyed_merge(KeyedSums* into, const KeyedSums* part) {
+    for (int i = 0; i < part->span; i++) {
+        for (int t = 0; t < 2; t++) {
+            int64_t v = part->sums[(size_t)i * 2 + t];
+            if (v != 0 && !keyed_add(into, part->base + i, t, v)) return 0;
+        }
+    }
+    return 1;
+}
+
+// === 分段扫描 ===
+typedef struct {
+    sqlite3* conn;
+    const char* sql;            // 列：键、type、amount；?1 ?2 为 rowid 区间，?3 为类型（可选）
+    const char* type;
+    sqlite3_int64 first, last;
+    int by_month;               // 键列为 date 文本，按年月分桶；否则为分类 id
+    KeyedSums sums;
+    int ok;
+} ScanPart;
+
+// 'YYYY-MM-...' -> 年 * 12 + 月 - 1；与汇总表的 substr(date, 1, 7) 对应，格式不符返回 -1
+static int month_key(const unsigned char* date) {
+    if (!date) return -1;
+    for (int i = 0; i < 7; i++) {
+        if (i == 4 ? date[i] != '-' : (date[i] < '0' || date[i] > '9')) return -1;
+    }
+    int year = (date[0] - '0') * 1000 + (date[1] - '0') * 100 + (date[2] - '0') * 10 + (date[3] - '0');
+    int month = (date[5] - '0') * 10 + (date[6] - '0');
+    if (month < 1 || month > 12) return -1;
+    return year * 12 + month - 1;
+}
+
+static void* scan_part(void* arg) {
+    ScanPart* p = arg;
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(p->conn, p->sql, -1, &stmt, NULL) != SQLITE_OK) return NULL;
+    sqlite3_bind_int64(stmt, 1, p->first);
+    sqlite3_bind_int64(stmt, 2, p->last);
+    if (p->type) sqlite3_bind_text(stmt, 3, p->type, -1, SQLITE_STATIC);
+
+    int rc = SQLITE_OK, ok = 1;
+    while (ok && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        int key = p->by_month ? month_key(sqlite3_column_text(stmt, 0)) : sqlite3_column_int(stmt, 0);
+        const unsigned char* type = sqlite3_column_text(stmt, 1);
+        int income = (type && strcmp((const char*)type, "income") == 0);
+        ok = key >= 0 && keyed_add(&p->sums, key, income, sqlite3_column_int64(stmt, 2));
+    }
+    p->ok = ok && rc == SQLITE_DONE;
+    sqlite3_finalize(stmt);
+    return NULL;
+}
+
+// 把 [MIN(rowid), MAX(rowid)] 等分给各线程，合并结果写入 out
+static int parallel_scan(const char* sql, const char* type, int by_month, KeyedSums* out) {
+    sqlite3* db = db_get();
+    if (!db) return 0;
+    // 工作连接看不到共享连接未提交的修改；内存数据库无法再打开
+    const char* path = sqlite3_db_filename(db, "main");
+    if (!path || !*path || !sqlite3_get_autocommit(db)) return 0;
+
+    sqlite3_int64 first = 0, last = -1;
+    sqlite3_stmt* stmt = db_prepare(db, "SELECT MIN(rowid), MAX(rowid) FROM records;");
+    if (!stmt) return 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        first = sqlite3_column_int64(stmt, 0);
+        last = sqlite3_column_int64(stmt, 1);
+    }
+    db_release(stmt);
+    if (last < first) return 1;   // 空表
+
+    sqlite3_int64 rows = last - first + 1;
+    int threads = parallel_threads_effective();
+    if (rows / PARALLEL_MIN_ROWS_PER_THREAD < threads) {
+        threads = (int)(rows / PARALLEL_MIN_ROWS_PER_THREAD);
+        if (threads < 1) threads = 1;
+    }
+
+    ScanPart parts[PARALLEL_MAX_THREADS];
+    pthread_t tids[PARALLEL_MAX_THREADS];
+    int started[PARALLEL_MAX_THREADS] = { 0 };
+    memset(parts, 0, sizeof(parts));
+    int ok = 1;
+    sqlite3_int64 step = rows / threads;
+    for (int i = 0; i < threads && ok; i++) {
+        ScanPart* p = &parts[i];
+        p->conn = pool_get(i, path);
+        p->sql = sql;
+        p->type = type;
+        p->by_month = by_month;
+        p->first = first + step * i;
+        p->last = (i == threads - 1) ? last : p->first + step - 1;
+        ok = p->conn != NULL;
+    }
+    // 第 0 段在当前线程执行
+    for (int i = 1; i < threads && ok; i++) {
+        started[i] = (pthread_create(&tids[i], NULL, scan_part, &parts[i]) == 0);
+        if (!started[i]) scan_part(&parts[i]);
+    }
+    if (ok) scan_part(&parts[0]);
+    for (int i = 1; i < threads; i++) {
+        if (started[i]) pthread_join(tids[i], NULL);
+    }
+
+    // 按区间顺序合并
+    for (int i = 0; i < threads; i++) {
+        ok = ok && parts[i].ok && keyed_merge(out, &parts[i].sums);
+        free(parts[i].sums.sums);
+    }
+    if (!ok) {
+        free(out->sums);
+        memset(out, 0, sizeof(*out));
+    }
+    return ok;
+}
+
+// === 报表 ===
+// 金额恒大于 0（表约束），因此合计非 0 即该组有记录
+
+int parallel_period_totals(int yearly, PeriodRowFn fn, void* ctx) {
+    KeyedSums months = { 0, 0, NULL };
+    if (!parallel_scan("SELECT date, type, amount FROM records WHERE rowid BETWEEN ?1 AND ?2;",
+                       NULL, 1, &months)) {
+        return 0;
+    }
+
+    // 按年时先把月份并入年份；两种报表都是新的在前
+    char label[16];
+    int year_key = -1;
+    int64_t income = 0, expense = 0;
+    for (int i = months.span - 1; i >= 0; i--) {
+        int key = months.base + i;
+        int64_t in = months.sums[(size_t)i * 2 + 1];
+        int64_t out = months.sums[(size_t)i * 2];
+        if (in == 0 && out == 0) continue;
+        if (!yearly) {
+            snprintf(label, sizeof(label), "%04d-%02d", key / 12, key % 12 + 1);
+            fn(ctx, label, in, out);
+            continue;
+        }
+        if (key / 12 != year_key && year_key >= 0) {
+            snprintf(label, sizeof(label), "%04d", year_key);
+            fn(ctx, label, income, expense);
+            income = expense = 0;
+        }
+        year_key = key / 12;
+        income += in;
+        expense += out;
+    }
+    if (yearly && year_key >= 0) {
+        snprintf(label, sizeof(label), "%04d", year_key);
+        fn(ctx, label, income, expense);
+    }
+    free(months.sums);
+    return 1;
+}
+
+int parallel_category_totals(const char* type, CategorySumFn fn, void* ctx) {
+    KeyedSums categories = { 0, 0, NULL };
+    if (!parallel_scan("SELECT category_id, type, amount FROM records "
+                       "WHERE rowid BETWEEN ?1 AND ?2 AND type = ?3;",
+                       type, 0, &categories)) {
+        return 0;
+    }
+
+    int income = strcmp(type, "income") == 0;
+    for (int i = 0; i < categories.span; i++) {
+        int64_t total = categories.sums[(size_t)i * 2 + income];
+        if (total != 0) fn(ctx, categories.base + i, total);
+    }
+    free(categories.sums);
+    return 1;
+}
@@ -0,0 +1,25 @@
+// parallel.h
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "finance.h"
+#include "snapshot.h"
+
+// 并行扫描报表引擎：按 rowid 把 records 切成连续区间，每个工作线程用自己的只读连接
+// 扫描一段并累加到私有的部分合计，最后按区间顺序合并（整数求和，与线程数无关，结果与串行一致）。
+// 工作线程数（app_settings 'report_threads'）：0 表示按 CPU 核数自动选择
+#define PARALLEL_MAX_THREADS      16
+#define PARALLEL_MIN_ROWS_PER_THREAD 20000   // 记录太少时少开线程
+
+int parallel_threads_setting(void);
+int parallel_threads_set(int threads);
+int parallel_threads_effective(void);   // 设置为 0 时的实际线程数
+
+// 与 snapshot_* 同形；无法并行（内存数据库、共享连接有未提交事务、日期格式异常）时返回 0，调用方改用汇总表
+int parallel_period_totals(int yearly, PeriodRowFn fn, void* ctx);
+int parallel_category_totals(const char* type, CategorySumFn fn, void* ctx);
+
+// 关闭缓存的只读连接
+void parallel_reset(void);
+
+#endif
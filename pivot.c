@@ -0,0 +1,620 @@
+// pivot.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sqlite3.h"
+#include "money.h"
+#include "csv.h"
+#include "category.h"
+#include "dim.h"
+#include "query.h"
+#include "pivot.h"
+
+#define PIVOT_MAX_CELLS 1000000     // 行数 × 列数上限
+#define PIVOT_MIN_WIDTH 8           // 表格数值列最小宽度
+#define PIVOT_KEY_INVALID (-1)      // 日期无法解析
+
+static const char* const dim_keywords[PIVOT_DIM_COUNT] = {
+    "none", "month", "quarter", "year", "category1", "category2", "member", "account", "type",
+};
+static const char* const dim_labels[PIVOT_DIM_COUNT] = {
+    "全部", "年月", "季度", "年份", "一级分类", "分类", "成员", "账户", "类型",
+};
+static const char* const measure_keywords[PIVOT_MEASURE_COUNT] = {
+    "sum", "count", "avg", "min", "max",
+};
+static const char* const measure_labels[PIVOT_MEASURE_COUNT] = {
+    "合计", "笔数", "平均", "最小", "最大",
+};
+
+const char* pivot_dim_keyword(int dim) {
+    return (dim >= 0 && dim < PIVOT_DIM_COUNT) ? dim_keywords[dim] : "";
+}
+
+const char* pivot_dim_label(int dim) {
+    return (dim >= 0 && dim < PIVOT_DIM_COUNT) ? dim_labels[dim] : "";
+}
+
+int pivot_dim_parse(const char* keyword) {
+    for (int i = 0; i < PIVOT_DIM_COUNT; i++) {
+        if (strcmp(keyword, dim_keywords[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char* pivot_measure_keyword(int measure) {
+    return (measure >= 0 && measure < PIVOT_MEASURE_COUNT) ? measure_keywords[measure] : "";
+}
+
+const char* pivot_measure_label(int measure) {
+    return (measure >= 0 && measure < PIVOT_MEASURE_COUNT) ? measure_labels[measure] : "";
+}
+
+int pivot_measure_parse(const char* keyword) {
+    for (int i = 0; i < PIVOT_MEASURE_COUNT; i++) {
+        if (strcmp(keyword, measure_keywords[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// === 哈希聚合 ===
+// 开放寻址，键为 (行键, 列键)；每格同时累计合计、笔数、最小、最大，任一度量都可由此得出
+typedef struct {
+    int row, col;
+    long count;             // 0 表示空槽
+    int64_t sum, min, max;
+} PivotCell;
+
+typedef struct {
+    PivotCell* cells;
+    int cap;                // 2 的幂
+    int used;
+} PivotTable;
+
+static unsigned cell_hash(int row, int col) {
+    return (unsigned)row * 0x9E3779B1u ^ (unsigned)col * 0x85EBCA77u;
+}
+
+static PivotCell* table_slot(PivotCell* cells, int cap, int row, int col) {
+    unsigned mask = (unsigned)cap - 1;
+    unsigned i = cell_hash(row, col) & mask;
+    while (cells[i].count && (cells[i].row != row || cells[i].col != col)) i = (i + 1) & mask;
+    return &cells[i];
+}
+
+static int table_grow(PivotTable* t) {
+    int cap = t->cap ? t->cap * 2 : 256;
+    PivotCell* cells = calloc((size_t)cap, sizeof(PivotCell));
+    if (!cells) return 0;
+    for (int i = 0; i < t->cap; i++) {
+        if (t->cells[i].count) *table_slot(cells, cap, t->cells[i].row, t->cells[i].col) = t->cells[i];
+    }
+    free(t->cells);
+    t->cells = cells;
+    t->cap = cap;
+    return 1;
+}
+
+static void cell_add(PivotCell* c, int64_t cents) {
+    if (c->count == 0 || cents < c->min) c->min = cents;
+    if (c->count == 0 || cents > c->max) c->max = cents;
+    c->sum += cents;
+    c->count++;
+}
+
+static void cell_merge(PivotCell* into, const PivotCell* from) {
+    if (!from || from->count == 0) return;
+    if (into->count == 0 || from->min < into->min) into->min = from->min;
+    if (into->count == 0 || from->max > into->max) into->max = from->max;
+    into->sum += from->sum;
+    into->count += from->count;
+}
+
+// === 维度 ===
+// 扫描列：0 date, 1 type, 2 category_id, 3 member_id, 4 account_id, 5 amount
+#define PIVOT_SELECT \
+    "SELECT r.date, r.type, r.category_id, r.member_id, r.account_id, r.amount FROM records r "
+
+static int date_key(const unsigned char* date, int dim) {
+    if (!date) return PIVOT_KEY_INVALID;
+    for (int i = 0; i < 7; i++) {
+        if (i == 4 ? date[i] != '-' : (date[i] < '0' || date[i] > '9')) return PIVOT_KEY_INVALID;
+    }
+    int year = (date[0] - '0') * 1000 + (date[1] - '0') * 100 + (date[2] - '0') * 10 + (date[3] - '0');
+    int month = (date[5] - '0') * 10 + (date[6] - '0');
+    if (month < 1 || month > 12) return PIVOT_KEY_INVALID;
+    if (dim == PIVOT_DIM_YEAR) return year;
+    if (dim == PIVOT_DIM_QUARTER) return year * 4 + (month - 1) / 3;
+    return year * 12 + month - 1;
+}
+
+static int dim_key(int dim, sqlite3_stmt* stmt) {
+    switch (dim) {
+    case PIVOT_DIM_MONTH:
+    case PIVOT_DIM_QUARTER:
+    case PIVOT_DIM_YEAR:
+        return date_key(sqlite3_column_text(stmt, 0), dim);
+    case PIVOT_DIM_CATEGORY1: {
+        int id = sqlite3_column_int(stmt, 2);
+        const CategoryNode* node = category_tree_find(id);
+        return (node && node->parent_id) ? node->parent_id : id;
+    }
+    case PIVOT_DIM_CATEGORY2: return sqlite3_column_int(stmt, 2);
+    case PIVOT_DIM_MEMBER:    return sqlite3_column_int(stmt, 3);   // NULL -> 0
+    case PIVOT_DIM_ACCOUNT:   return sqlite3_column_int(stmt, 4);
+    case PIVOT_DIM_TYPE: {
+        const char* type = (const char*)sqlite3_column_text(stmt, 1);
+        return (type && strcmp(type, "income") == 0) ? 1 : 0;
+    }
+    default: return 0;
+    }
+}
+
+static void dim_label(int dim, int key, char* buf, size_t size) {
+    const char* name = NULL;
+    if (key == PIVOT_KEY_INVALID && dim >= PIVOT_DIM_MONTH && dim <= PIVOT_DIM_YEAR) {
+        snprintf(buf, size, "（日期无效）");
+        return;
+    }
+    switch (dim) {
+    case PIVOT_DIM_MONTH:   snprintf(buf, size, "%04d-%02d", key / 12, key % 12 + 1); return;
+    case PIVOT_DIM_QUARTER: snprintf(buf, size, "%04dQ%d", key / 4, key % 4 + 1); return;
+    case PIVOT_DIM_YEAR:    snprintf(buf, size, "%04d", key); return;
+    case PIVOT_DIM_CATEGORY1:
+    case PIVOT_DIM_CATEGORY2: {
+        const CategoryNode* node = category_tree_find(key);
+        if (!node) {
+            snprintf(buf, size, "（未知分类 #%d）", key);
+            return;
+        }
+        name = dim == PIVOT_DIM_CATEGORY1 ? node->name : node->path;
+        break;
+    }
+    case PIVOT_DIM_MEMBER:
+        name = key ? dim_member_name(key) : "（无成员）";
+        if (!name) name = "（已删除成员）";
+        break;
+    case PIVOT_DIM_ACCOUNT:
+        name = dim_account_name(key);
+        if (!name) name = "（已删除账户）";
+        break;
+    case PIVOT_DIM_TYPE: name = key ? "收入" : "支出"; break;
+    default: name = "全部"; break;
+    }
+    snprintf(buf, size, "%s", name);
+}
+
+// 排序依据：时间维度按先后，分类按分类树先序（子分类紧跟父分类），收入在支出之前，其余按 id
+static int64_t dim_rank(int dim, int key) {
+    if (dim == PIVOT_DIM_CATEGORY1 || dim == PIVOT_DIM_CATEGORY2) {
+        const CategoryTree* tree = category_tree_get();
+        const CategoryNode* node = category_tree_find(key);
+        if (tree && node) return node - tree->nodes;
+        return (int64_t)(tree ? tree->count : 0) + key;
+    }
+    if (dim == PIVOT_DIM_TYPE) return -key;
+    return key;
+}
+
+// === 坐标轴：某一维度上出现过的键，按显示顺序排列 ===
+typedef struct {
+    int64_t rank;
+    int key;
+    int pos;                // 在显示顺序中的位置
+} AxisItem;
+
+typedef struct {
+    AxisItem* by_rank;      // 显示顺序
+    AxisItem* by_key;       // 按键排序，用于查位置
+    int count;
+} PivotAxis;
+
+static int compare_rank(const void* a, const void* b) {
+    const AxisItem* x = a;
+    const AxisItem* y = b;
+    if (x->rank != y->rank) return x->rank < y->rank ? -1 : 1;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static int compare_key(const void* a, const void* b) {
+    const AxisItem* x = a;
+    const AxisItem* y = b;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+static int axis_build(PivotAxis* axis, int dim, const PivotTable* t, int use_col) {
+    memset(axis, 0, sizeof(*axis));
+    axis->by_rank = malloc(sizeof(AxisItem) * (t->used + 1));
+    axis->by_key = malloc(sizeof(AxisItem) * (t->used + 1));
+    if (!axis->by_rank || !axis->by_key) return 0;
+
+    // 先按键去重
+    int n = 0;
+    for (int i = 0; i < t->cap; i++) {
+        if (t->cells[i].count) axis->by_key[n++].key = use_col ? t->cells[i].col : t->cells[i].row;
+    }
+    qsort(axis->by_key, n, sizeof(AxisItem), compare_key);
+    int unique = 0;
+    for (int i = 0; i < n; i++) {
+        if (unique == 0 || axis->by_rank[unique - 1].key != axis->by_key[i].key) {
+            axis->by_rank[unique].key = axis->by_key[i].key;
+            axis->by_rank[unique].rank = dim_rank(dim, axis->by_key[i].key);
+            unique++;
+        }
+    }
+    qsort(axis->by_rank, unique, sizeof(AxisItem), compare_rank);
+    for (int i = 0; i < unique; i++) axis->by_rank[i].pos = i;
+    memcpy(axis->by_key, axis->by_rank, sizeof(AxisItem) * unique);
+    qsort(axis->by_key, unique, sizeof(AxisItem), compare_key);
+    axis->count = unique;
+    return 1;
+}
+
+static int axis_pos(const PivotAxis* axis, int key) {
+    AxisItem probe = { 0, key, 0 };
+    const AxisItem* hit = bsearch(&probe, axis->by_key, axis->count, sizeof(AxisItem), compare_key);
+    return hit ? hit->pos : -1;
+}
+
+static void axis_free(PivotAxis* axis) {
+    free(axis->by_rank);
+    free(axis->by_key);
+}
+
+// === 透视结果 ===
+typedef struct {
+    int rows_dim, cols_dim;
+    PivotAxis rows, cols;
+    PivotCell* grid;        // [行][列]，count 为 0 表示该格无记录
+    PivotCell* row_totals;
+    PivotCell* col_totals;
+    PivotCell total;
+    const char* type_note;  // 自动只统计支出时的说明
+} Pivot;
+
+typedef struct {
+    int rows_dim, cols_dim;
+    PivotTable table;
+    int error;
+} PivotScan;
+
+static int scan_row(void* ctx, sqlite3_stmt* stmt) {
+    PivotScan* s = ctx;
+    PivotTable* t = &s->table;
+    if ((t->used + 1) * 10 > t->cap * 7 && !table_grow(t)) {   // 负载因子 0.7
+        s->error = 1;
+        return 0;
+    }
+    int row = dim_key(s->rows_dim, stmt);
+    int col = dim_key(s->cols_dim, stmt);
+    PivotCell* c = table_slot(t->cells, t->cap, row, col);
+    if (c->count == 0) {
+        c->row = row;
+        c->col = col;
+        t->used++;
+    }
+    cell_add(c, sqlite3_column_int64(stmt, 5));
+    return 1;
+}
+
+static void pivot_free(Pivot* p) {
+    axis_free(&p->rows);
+    axis_free(&p->cols);
+    free(p->grid);
+    free(p->row_totals);
+    free(p->col_totals);
+}
+
+static int pivot_build(const PivotSpec* spec, Pivot* p, FILE* err) {
+    memset(p, 0, sizeof(*p));
+    if (spec->rows < 0 || spec->rows >= PIVOT_DIM_COUNT || spec->cols < 0 || spec->cols >= PIVOT_DIM_COUNT
+        || spec->measure < 0 || spec->measure >= PIVOT_MEASURE_COUNT) {
+        fprintf(err, "❌ 透视维度或度量无效\n");
+        return 0;
+    }
+    if (!category_tree_get()) return 0;
+
+    RecordFilter filter = spec->filter;
+    if (!filter.type && spec->rows != PIVOT_DIM_TYPE && spec->cols != PIVOT_DIM_TYPE) {
+        filter.type = "expense";
+        p->type_note = "未按类型分组也未限定类型，只统计支出";
+    }
+
+    PivotScan scan = { spec->rows, spec->cols, { NULL, 0, 0 }, 0 };
+    long n = record_query_each(&filter, PIVOT_SELECT, scan_row, &scan, err);
+    if (scan.error) fprintf(err, "❌ 内存不足\n");
+    if (n < 0 || scan.error) {
+        free(scan.table.cells);
+        return 0;
+    }
+
+    p->rows_dim = spec->rows;
+    p->cols_dim = spec->cols;
+    int ok = axis_build(&p->rows, spec->rows, &scan.table, 0)
+          && axis_build(&p->cols, spec->cols, &scan.table, 1);
+    if (ok && (int64_t)p->rows.count * p->cols.count > PIVOT_MAX_CELLS) {
+        fprintf(err, "❌ 透视表过大（%d 行 × %d 列），请缩小筛选范围或换用更粗的维度\n",
+                p->rows.count, p->cols.count);
+        ok = 0;
+    }
+    if (ok) {
+        p->grid = calloc((size_t)p->rows.count * p->cols.count + 1, sizeof(PivotCell));
+        p->row_totals = calloc((size_t)p->rows.count + 1, sizeof(PivotCell));
+        p->col_totals = calloc((size_t)p->cols.count + 1, sizeof(PivotCell));
+        ok = p->grid && p->row_totals && p->col_totals;
+    }
+    for (int i = 0; ok && i < scan.table.cap; i++) {
+        const PivotCell* c = &scan.table.cells[i];
+        if (!c->count) continue;
+        int r = axis_pos(&p->rows, c->row);
+        int k = axis_pos(&p->cols, c->col);
+        p->grid[(size_t)r * p->cols.count + k] = *c;
+        cell_merge(&p->row_totals[r], c);
+        cell_merge(&p->col_totals[k], c);
+        cell_merge(&p->total, c);
+    }
+    free(scan.table.cells);
+    if (!ok) pivot_free(p);
+    return ok;
+}
+
+// 度量值文本；空格子返回空串
+static void measure_text(int measure, const PivotCell* c, char* buf, size_t size) {
+    if (!c || c->count == 0) {
+        buf[0] = '\0';
+        return;
+    }
+    switch (measure) {
+    case PIVOT_MEASURE_RECORDS: snprintf(buf, size, "%ld", c->count); return;
+    case PIVOT_MEASURE_AVG: {
+        // 四舍五入到分（远离零）
+        int64_t half = c->count / 2;
+        int64_t avg = c->sum >= 0 ? (c->sum + half) / c->count : -((-c->sum + half) / c->count);
+        format_money(avg, buf, size);
+        return;
+    }
+    case PIVOT_MEASURE_MIN: format_money(c->min, buf, size); return;
+    case PIVOT_MEASURE_MAX: format_money(c->max, buf, size); return;
+    default: format_money(c->sum, buf, size); return;
+    }
+}
+
+// r、k 等于行数/列数时取合计行/合计列
+static const PivotCell* pivot_cell(const Pivot* p, int r, int k) {
+    if (r == p->rows.count) return k == p->cols.count ? &p->total : &p->col_totals[k];
+    return k == p->cols.count ? &p->row_totals[r] : &p->grid[(size_t)r * p->cols.count + k];
+}
+
+// 不分组的一侧只有一行/一列，本身就是合计；收入与支出合在一起没有意义，按类型分组的一侧也不出合计
+static int has_total_col(const Pivot* p) {
+    return p->cols_dim != PIVOT_DIM_NONE && p->cols_dim != PIVOT_DIM_TYPE;
+}
+
+static int has_total_row(const Pivot* p) {
+    return p->rows_dim != PIVOT_DIM_NONE && p->rows_dim != PIVOT_DIM_TYPE;
+}
+
+static void corner_label(const Pivot* p, char* buf, size_t size) {
+    if (p->cols_dim == PIVOT_DIM_NONE) {
+        snprintf(buf, size, "%s", pivot_dim_label(p->rows_dim));
+    } else {
+        snprintf(buf, size, "%s \\ %s", pivot_dim_label(p->rows_dim), pivot_dim_label(p->cols_dim));
+    }
+}
+
+static void column_label(const Pivot* p, int measure, int k, char* buf, size_t size) {
+    if (p->cols_dim == PIVOT_DIM_NONE) snprintf(buf, size, "%s", pivot_measure_label(measure));
+    else dim_label(p->cols_dim, p->cols.by_rank[k].key, buf, size);
+}
+
+int pivot_write_csv(const PivotSpec* spec, FILE* fp, int with_bom, FILE* err) {
+    Pivot p;
+    if (!pivot_build(spec, &p, err ? err : stderr)) return 0;
+
+    CsvWriter w;
+    if (!csv_writer_init(&w, fp)) {
+        pivot_free(&p);
+        return 0;
+    }
+    if (with_bom) csv_write_raw(&w, "\xEF\xBB\xBF", 3);
+
+    char text[256];
+    corner_label(&p, text, sizeof(text));
+    csv_write_field(&w, text, strlen(text));
+    for (int k = 0; k < p.cols.count; k++) {
+        column_label(&p, spec->measure, k, text, sizeof(text));
+        csv_write_field(&w, text, strlen(text));
+    }
+    if (has_total_col(&p)) csv_write_field(&w, "合计", strlen("合计"));
+    csv_end_row(&w);
+
+    for (int r = 0; r <= p.rows.count; r++) {
+        int is_total = (r == p.rows.count);
+        if (is_total && !has_total_row(&p)) break;
+        if (is_total) snprintf(text, sizeof(text), "合计");
+        else dim_label(p.rows_dim, p.rows.by_rank[r].key, text, sizeof(text));
+        csv_write_field(&w, text, strlen(text));
+        for (int k = 0; k <= p.cols.count; k++) {
+            if (k == p.cols.count && !has_total_col(&p)) break;
+            const PivotCell* c = pivot_cell(&p, r, k);
+            measure_text(spec->measure, c, text, sizeof(text));
+            csv_write_field(&w, text, strlen(text));
+        }
+        csv_end_row(&w);
+    }
+    pivot_free(&p);
+    return csv_writer_finish(&w);
+}
+
+// === 表格输出 ===
+// 终端显示宽度：东亚文字与全角符号占两列
+static int text_width(const char* s) {
+    int width = 0;
+    const unsigned char* p = (const unsigned char*)s;
+    while (*p) {
+        unsigned cp;
+        int len;
+        if (*p < 0x80) { cp = *p; len = 1; }
+        else if ((*p & 0xE0) == 0xC0) { cp = *p & 0x1F; len = 2; }
+        else if ((*p & 0xF0) == 0xE0) { cp = *p & 0x0F; len = 3; }
+        else { cp = *p & 0x07; len = 4; }
+        for (int i = 1; i < len && (p[i] & 0xC0) == 0x80; i++) cp = (cp << 6) | (p[i] & 0x3F);
+        for (int i = 0; i < len && *p; i++) p++;
+        int wide = (cp >= 0x1100 && cp <= 0x115F) || (cp >= 0x2E80 && cp <= 0xA4CF)
+                || (cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0xF900 && cp <= 0xFAFF)
+                || (cp >= 0xFE30 && cp <= 0xFE4F) || (cp >= 0xFF00 && cp <= 0xFF60)
+                || (cp >= 0xFFE0 && cp <= 0xFFE6) || cp >= 0x1F300;
+        width += wide ? 2 : 1;
+    }
+    return width;
+}
+
+static void print_padded(const char* s, int width, int right) {
+    int pad = width - text_width(s);
+    if (right) printf("%*s%s", pad > 0 ? pad : 0, "", s);
+    else printf("%s%*s", s, pad > 0 ? pad : 0, "");
+}
+
+int pivot_print(const PivotSpec* spec, FILE* err) {
+    Pivot p;
+    if (!pivot_build(spec, &p, err ? err : stderr)) return 0;
+
+    printf("\n📊 透视报表：%s × %s，%s\n", pivot_dim_label(spec->rows), pivot_dim_label(spec->cols),
+           pivot_measure_label(spec->measure));
+    if (p.type_note) printf("（%s）\n", p.type_note);
+    if (p.total.count == 0) {
+        printf("📝 没有符合条件的记录。\n");
+        pivot_free(&p);
+        return 1;
+    }
+
+    // 各列宽度：表头与所有数值的最大显示宽度
+    int columns = p.cols.count + (has_total_col(&p) ? 1 : 0);
+    int rows = p.rows.count + (has_total_row(&p) ? 1 : 0);
+    int* widths = calloc((size_t)columns + 1, sizeof(int));
+    if (!widths) {
+        pivot_free(&p);
+        return 0;
+    }
+    char text[256];
+    corner_label(&p, text, sizeof(text));
+    widths[0] = text_width(text);
+    for (int k = 0; k < columns; k++) {
+        if (k < p.cols.count) column_label(&p, spec->measure, k, text, sizeof(text));
+        else snprintf(text, sizeof(text), "合计");
+        widths[k + 1] = text_width(text) > PIVOT_MIN_WIDTH ? text_width(text) : PIVOT_MIN_WIDTH;
+    }
+    for (int r = 0; r < rows; r++) {
+        int is_total = (r == p.rows.count);
+        if (is_total) snprintf(text, sizeof(text), "合计");
+        else dim_label(p.rows_dim, p.rows.by_rank[r].key, text, sizeof(text));
+        if (text_width(text) > widths[0]) widths[0] = text_width(text);
+        for (int k = 0; k < columns; k++) {
+            const PivotCell* c = pivot_cell(&p, r, k);
+            measure_text(spec->measure, c, text, sizeof(text));
+            if (text_width(text) > widths[k + 1]) widths[k + 1] = text_width(text);
+        }
+    }
+
+    int line = widths[0];
+    for (int k = 0; k < columns; k++) line += 2 + widths[k + 1];
+
+    corner_label(&p, text, sizeof(text));
+    print_padded(text, widths[0], 0);
+    for (int k = 0; k < columns; k++) {
+        if (k < p.cols.count) column_label(&p, spec->measure, k, text, sizeof(text));
+        else snprintf(text, sizeof(text), "合计");
+        printf("  ");
+        print_padded(text, widths[k + 1], 1);
+    }
+    printf("\n");
+    for (int i = 0; i < line; i++) printf("-");
+    printf("\n");
+
+    for (int r = 0; r < rows; r++) {
+        int is_total = (r == p.rows.count);
+        if (is_total) {
+            for (int i = 0; i < line; i++) printf("-");
+            printf("\n");
+            snprintf(text, sizeof(text), "合计");
+        } else {
+            dim_label(p.rows_dim, p.rows.by_rank[r].key, text, sizeof(text));
+        }
+        print_padded(text, widths[0], 0);
+        for (int k = 0; k < columns; k++) {
+            const PivotCell* c = pivot_cell(&p, r, k);
+            measure_text(spec->measure, c, text, sizeof(text));
+            printf("  ");
+            print_padded(text, widths[k + 1], 1);
+        }
+        printf("\n");
+    }
+    printf("共 %ld 条记录，%d 行 × %d 列。\n", p.total.count, p.rows.count, p.cols.count);
+
+    free(widths);
+    pivot_free(&p);
+    return 1;
+}
+
+// === 交互菜单 ===
+static int read_choice(const char* prompt, int lo, int hi, int fallback) {
+    char input[32];
+    printf("%s", prompt);
+    if (fgets(input, sizeof(input), stdin) == NULL) return -1;
+    input[strcspn(input, "\n")] = 0;
+    if (input[0] == '\0') return fallback;
+    char* end;
+    long v = strtol(input, &end, 10);
+    if (*end != '\0' || v < lo || v > hi) {
+        printf("❌ 无效选项！\n");
+        return -1;
+    }
+    return (int)v;
+}
+
+void pivot_report_menu(void) {
+    PivotSpec spec;
+    printf("\n📊 透视报表\n维度: ");
+    for (int i = 0; i < PIVOT_DIM_COUNT; i++) printf("%d=%s  ", i, dim_labels[i]);
+    printf("\n");
+    if ((spec.rows = read_choice("行维度 [默认 1 年月]: ", 0, PIVOT_DIM_COUNT - 1, PIVOT_DIM_MONTH)) < 0) return;
+    if ((spec.cols = read_choice("列维度 [默认 4 一级分类]: ", 0, PIVOT_DIM_COUNT - 1, PIVOT_DIM_CATEGORY1)) < 0) return;
+
+    printf("度量: ");
+    for (int i = 0; i < PIVOT_MEASURE_COUNT; i++) printf("%d=%s  ", i + 1, measure_labels[i]);
+    printf("\n");
+    int measure = read_choice("度量 [默认 1 合计]: ", 1, PIVOT_MEASURE_COUNT, 1);
+    if (measure < 0) return;
+    spec.measure = measure - 1;
+
+    RecordFilterInput in;
+    printf("筛选条件（各项直接回车表示不限）\n");
+    if (!record_filter_prompt(&in)) return;
+    spec.filter = in.filter;
+
+    int output = read_choice("输出 (1=显示表格 [默认], 2=导出 CSV): ", 1, 2, 1);
+    if (output < 0) return;
+    if (output == 1) {
+        if (!pivot_print(&spec, stderr)) printf("❌ 查询失败。\n");
+        return;
+    }
+
+    char filename[256];
+    printf("请输入导出文件名（如 pivot.csv）: ");
+    if (fgets(filename, sizeof(filename), stdin) == NULL) return;
+    filename[strcspn(filename, "\n")] = 0;
+    if (filename[0] == '\0') {
+        printf("❌ 文件名不能为空！\n");
+        return;
+    }
+    FILE* fp = fopen(filename, "wb");
+    if (!fp) {
+        printf("❌ 无法创建文件 \"%s\"\n", filename);
+        return;
+    }
+    int ok = pivot_write_csv(&spec, fp, 1, stderr);   // 带 BOM，便于 Excel 打开
+    if (fclose(fp) != 0) ok = 0;
+    if (ok) printf("✅ 已导出到 \"%s\"\n", filename);
+    else printf("❌ 导出失败。\n");
+}
@@ -0,0 +1,50 @@
+// pivot.h
+#ifndef PIVOT_H
+#define PIVOT_H
+
+#include <stdio.h>
+#include "query.h"
+
+// 透视报表：按所选行维度 × 列维度对筛选后的记录金额求合计/笔数/平均/最小/最大。
+// 一趟扫描，按 (行键, 列键) 哈希聚合，输出表格或 CSV（带合计行与合计列）。
+// 未按类型分组也未限定类型时只统计支出（收入与支出相加没有意义）
+#define PIVOT_DIM_NONE      0   // 不分组
+#define PIVOT_DIM_MONTH     1
+#define PIVOT_DIM_QUARTER   2
+#define PIVOT_DIM_YEAR      3
+#define PIVOT_DIM_CATEGORY1 4   // 一级分类（子分类并入父分类）
+#define PIVOT_DIM_CATEGORY2 5   // 完整分类路径
+#define PIVOT_DIM_MEMBER    6
+#define PIVOT_DIM_ACCOUNT   7
+#define PIVOT_DIM_TYPE      8
+#define PIVOT_DIM_COUNT     9
+
+#define PIVOT_MEASURE_SUM     0
+#define PIVOT_MEASURE_RECORDS 1   // 笔数
+#define PIVOT_MEASURE_AVG     2
+#define PIVOT_MEASURE_MIN     3
+#define PIVOT_MEASURE_MAX     4
+#define PIVOT_MEASURE_COUNT   5
+
+typedef struct {
+    int rows;               // PIVOT_DIM_*
+    int cols;
+    int measure;            // PIVOT_MEASURE_*
+    RecordFilter filter;
+} PivotSpec;
+
+// 命令行关键字（month、category1、sum ...）与中文名；解析失败返回 -1
+const char* pivot_dim_keyword(int dim);
+const char* pivot_dim_label(int dim);
+int pivot_dim_parse(const char* keyword);
+const char* pivot_measure_keyword(int measure);
+const char* pivot_measure_label(int measure);
+int pivot_measure_parse(const char* keyword);
+
+// 成功返回 1；失败原因写到 err（NULL 为 stderr）
+int pivot_print(const PivotSpec* spec, FILE* err);
+int pivot_write_csv(const PivotSpec* spec, FILE* fp, int with_bom, FILE* err);
+
+void pivot_report_menu(void);
+
+#endif
@@ -0,0 +1,361 @@
+// query.c
+// 组合查询：把 RecordFilter 拼成一条参数化 SQL（条件只随“是否设置”变化，语句可被缓存复用），
+// 结果流式交给列表打印、CSV 写出或只做计数
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "money.h"
+#include "date.h"
+#include "category.h"
+#include "dim.h"
+#include "finance.h"
+#include "query.h"
+
+#define QUERY_MAX_PARAMS 16
+#define QUERY_SQL_SIZE 1024
+#define QUERY_PATTERN_SIZE 256
+
+typedef struct {
+    int is_text;
+    sqlite3_int64 i;
+    const char* s;
+} QueryParam;
+
+typedef struct {
+    char sql[QUERY_SQL_SIZE];
+    size_t len;
+    int clauses;
+    QueryParam params[QUERY_MAX_PARAMS];
+    int count;
+    char from[DATE_TEXT_LEN + 1];
+    char to[DATE_TEXT_LEN + 1];
+    char pattern[QUERY_PATTERN_SIZE];   // 分类关键词的 %..% 模式
+} QueryBuilder;
+
+void record_filter_init(RecordFilter* f) {
+    memset(f, 0, sizeof(*f));
+}
+
+static void append_sql(QueryBuilder* b, const char* text) {
+    int n = snprintf(b->sql + b->len, sizeof(b->sql) - b->len, "%s", text);
+    if (n > 0) b->len += (size_t)n;
+    if (b->len >= sizeof(b->sql)) b->len = sizeof(b->sql) - 1;
+}
+
+// 追加一个条件（自动补 WHERE / AND）
+static void add_clause(QueryBuilder* b, const char* clause) {
+    append_sql(b, b->clauses++ ? "AND " : "WHERE ");
+    append_sql(b, clause);
+}
+
+static void add_int(QueryBuilder* b, sqlite3_int64 v) {
+    QueryParam* p = &b->params[b->count++];
+    p->is_text = 0;
+    p->i = v;
+}
+
+static void add_text(QueryBuilder* b, const char* s) {
+    QueryParam* p = &b->params[b->count++];
+    p->is_text = 1;
+    p->s = s;
+}
+
+// 条件顺序即参数顺序。日期区间比较 date 文本（与天数区间等价）：单独使用时走
+// idx_records_date_id，与类型同时出现时走 idx_records_type_date 的 (type, date) 复合前缀，
+// 两者都与 ORDER BY date, id 同序，无需额外排序；其余条件落在各自的单列索引上，
+// 由 SQLite 按选择性挑选，金额与备注只在取到的行上过滤
+static void build_where(QueryBuilder* b, const RecordFilter* f) {
+    if (f->has_from) date_format(f->day_from, b->from);
+    if (f->has_to) date_format(f->day_to, b->to);
+    if (f->has_from && f->has_to) {
+        add_clause(b, "r.date BETWEEN ? AND ? ");
+        add_text(b, b->from);
+        add_text(b, b->to);
+    } else if (f->has_from) {
+        add_clause(b, "r.date >= ? ");
+        add_text(b, b->from);
+    } else if (f->has_to) {
+        add_clause(b, "r.date <= ? ");
+        add_text(b, b->to);
+    }
+    if (f->type) {
+        add_clause(b, "r.type = ? ");
+        add_text(b, f->type);
+    }
+    if (f->category_id) {
+        // 分类只有两级：自身加直接子分类即整棵子树
+        add_clause(b, "r.category_id IN (SELECT id FROM categories WHERE id = ? OR parent_id = ?) ");
+        add_int(b, f->category_id);
+        add_int(b, f->category_id);
+    }
+    if (f->category_like) {
+        // 分类集合在子查询中一次算出，主查询不必 JOIN categories
+        add_clause(b, "r.category_id IN (SELECT c.id FROM categories c "
+                      "LEFT JOIN categories p ON c.parent_id = p.id "
+                      "WHERE c.name LIKE ? OR (p.name IS NOT NULL AND p.name LIKE ?)) ");
+        snprintf(b->pattern, sizeof(b->pattern), "%%%s%%", f->category_like);
+        add_text(b, b->pattern);
+        add_text(b, b->pattern);
+    }
+    if (f->account_id) {
+        add_clause(b, "r.account_id = ? ");
+        add_int(b, f->account_id);
+    }
+    if (f->member_id) {
+        add_clause(b, "r.member_id = ? ");
+        add_int(b, f->member_id);
+    }
+    if (f->has_min) {
+        add_clause(b, "r.amount >= ? ");
+        add_int(b, f->amount_min);
+    }
+    if (f->has_max) {
+        add_clause(b, "r.amount <= ? ");
+        add_int(b, f->amount_max);
+    }
+    if (f->remark) {
+        add_clause(b, "instr(r.remark, ?) > 0 ");   // 按字面包含，不受 % _ 影响
+        add_text(b, f->remark);
+    }
+}
+
+// select + WHERE + tail 编译并绑定参数，用完须 db_release
+static sqlite3_stmt* prepare_filtered(const char* select, const RecordFilter* f, const char* tail,
+                                      QueryBuilder* b, FILE* err) {
+    sqlite3* db = db_get();
+    if (!db) {
+        fprintf(err, "❌ 数据库未打开。\n");
+        return NULL;
+    }
+
+    b->len = 0;
+    b->clauses = 0;
+    b->count = 0;
+    append_sql(b, select);
+    build_where(b, f);
+    append_sql(b, tail);
+
+    sqlite3_stmt* stmt = db_prepare(db, b->sql);
+    if (!stmt) {
+        fprintf(err, "❌ 查询准备失败: %s\n", sqlite3_errmsg(db));
+        return NULL;
+    }
+    for (int i = 0; i < b->count; i++) {
+        const QueryParam* p = &b->params[i];
+        if (p->is_text) {
+            sqlite3_bind_text(stmt, i + 1, p->s, -1, SQLITE_STATIC);
+        } else {
+            sqlite3_bind_int64(stmt, i + 1, p->i);
+        }
+    }
+    return stmt;
+}
+
+// 与 list_records 相同的顺序（新的在前）
+#define QUERY_ORDER "ORDER BY r.date DESC, r.id DESC;"
+
+long record_query_print(const RecordFilter* f, FILE* err) {
+    QueryBuilder b;
+    sqlite3_stmt* stmt = prepare_filtered(RECORD_LIST_SELECT, f, QUERY_ORDER, &b, err ? err : stderr);
+    if (!stmt) return -1;
+
+    print_record_header();
+    long count = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        print_record_row(stmt);
+        count++;
+    }
+    db_release(stmt);
+    return count;
+}
+
+long record_query_csv(const RecordFilter* f, FILE* fp, int with_bom, FILE* err) {
+    QueryBuilder b;
+    sqlite3_stmt* stmt = prepare_filtered(RECORD_LIST_SELECT, f, QUERY_ORDER, &b, err ? err : stderr);
+    if (!stmt) return -1;
+    long count = write_records_csv_stmt(fp, with_bom, stmt);
+    db_release(stmt);
+    return count;
+}
+
+int record_query_count(const RecordFilter* f, QueryTotals* out, FILE* err) {
+    if (!err) err = stderr;
+    memset(out, 0, sizeof(*out));
+    QueryBuilder b;
+    sqlite3_stmt* stmt = prepare_filtered(
+        "SELECT COUNT(*), "
+        "COALESCE(SUM(CASE WHEN r.type = 'income' THEN r.amount END), 0), "
+        "COALESCE(SUM(CASE WHEN r.type = 'expense' THEN r.amount END), 0) "
+        "FROM records r ", f, ";", &b, err);
+    if (!stmt) return 0;
+    int ok = (sqlite3_step(stmt) == SQLITE_ROW);
+    if (ok) {
+        out->count = (long)sqlite3_column_int64(stmt, 0);
+        out->income = sqlite3_column_int64(stmt, 1);
+        out->expense = sqlite3_column_int64(stmt, 2);
+    } else {
+        fprintf(err, "❌ 查询失败: %s\n", sqlite3_errmsg(db_get()));
+    }
+    db_release(stmt);
+    return ok;
+}
+
+long record_query_each(const RecordFilter* f, const char* select, RecordRowFn fn, void* ctx, FILE* err) {
+    if (!err) err = stderr;
+    QueryBuilder b;
+    sqlite3_stmt* stmt = prepare_filtered(select, f, ";", &b, err);
+    if (!stmt) return -1;
+    long count = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (!fn(ctx, stmt)) break;
+        count++;
+    }
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) fprintf(err, "❌ 查询失败: %s\n", sqlite3_errmsg(db_get()));
+    db_release(stmt);
+    return rc == SQLITE_DONE ? count : -1;
+}
+
+// === 交互菜单 ===
+// 读一行（去掉换行），EOF 返回 0
+static int read_line(const char* prompt, char* buf, size_t size) {
+    printf("%s", prompt);
+    if (fgets(buf, (int)size, stdin) == NULL) return 0;
+    buf[strcspn(buf, "\n")] = 0;
+    return 1;
+}
+
+static int find_dim_id(const DimList* list, const char* name) {
+    for (int i = 0; list && i < list->count; i++) {
+        if (strcmp(list->entries[i].name, name) == 0) return list->entries[i].id;
+    }
+    return 0;
+}
+
+// 名称与某个分类完全一致时按子树过滤（有类型条件时只认同类型），否则按关键词
+static int find_category_id(const char* name, const char* type) {
+    const CategoryTree* tree = category_tree_get();
+    for (int i = 0; tree && i < tree->count; i++) {
+        const CategoryNode* n = &tree->nodes[i];
+        if (strcmp(n->name, name) == 0 && (!type || strcmp(n->type, type) == 0)) return n->id;
+    }
+    return 0;
+}
+
+static int read_date_bound(const char* prompt, int* has, int32_t* day) {
+    char input[32];
+    if (!read_line(prompt, input, sizeof(input))) return 0;
+    if (input[0] == '\0') return 1;
+    if (!date_parse_days(input, day)) {
+        printf("❌ 日期无效！应为 YYYY-MM-DD 格式的有效日期\n");
+        return 0;
+    }
+    *has = 1;
+    return 1;
+}
+
+static int read_amount_bound(const char* prompt, int* has, int64_t* cents) {
+    char input[32];
+    if (!read_line(prompt, input, sizeof(input))) return 0;
+    if (input[0] == '\0') return 1;
+    if (!parse_money(input, cents) || *cents < 0) {
+        printf("❌ 金额无效（最多两位小数）: %s\n", input);
+        return 0;
+    }
+    *has = 1;
+    return 1;
+}
+
+int record_filter_prompt(RecordFilterInput* in) {
+    RecordFilter* f = &in->filter;
+    record_filter_init(f);
+    char input[64];
+
+    if (!read_date_bound("起始日期 (YYYY-MM-DD): ", &f->has_from, &f->day_from)) return 0;
+    if (!read_date_bound("结束日期 (YYYY-MM-DD): ", &f->has_to, &f->day_to)) return 0;
+    if (f->has_from && f->has_to && f->day_from > f->day_to) {
+        printf("❌ 起始日期晚于结束日期。\n");
+        return 0;
+    }
+
+    if (!read_line("类型 (1=收入, 2=支出): ", input, sizeof(input))) return 0;
+    if (strcmp(input, "1") == 0) f->type = "income";
+    else if (strcmp(input, "2") == 0) f->type = "expense";
+    else if (input[0] != '\0') {
+        printf("❌ 无效类型！\n");
+        return 0;
+    }
+
+    if (!read_line("分类（名称或关键词）: ", in->category, sizeof(in->category))) return 0;
+    if (in->category[0] != '\0') {
+        f->category_id = find_category_id(in->category, f->type);
+        if (!f->category_id) f->category_like = in->category;
+    }
+
+    if (!read_line("账户名称: ", input, sizeof(input))) return 0;
+    if (input[0] != '\0' && !(f->account_id = find_dim_id(dim_accounts(), input))) {
+        printf("❌ 找不到账户: %s\n", input);
+        return 0;
+    }
+    if (!read_line("成员名称: ", input, sizeof(input))) return 0;
+    if (input[0] != '\0' && !(f->member_id = find_dim_id(dim_members(), input))) {
+        printf("❌ 找不到成员: %s\n", input);
+        return 0;
+    }
+
+    if (!read_amount_bound("最小金额: ", &f->has_min, &f->amount_min)) return 0;
+    if (!read_amount_bound("最大金额: ", &f->has_max, &f->amount_max)) return 0;
+
+    if (!read_line("备注包含: ", in->remark, sizeof(in->remark))) return 0;
+    if (in->remark[0] != '\0') f->remark = in->remark;
+    return 1;
+}
+
+void query_records_menu(void) {
+    RecordFilterInput in;
+    char input[64];
+
+    printf("\n🔍 组合查询（各项直接回车表示不限）\n");
+    if (!record_filter_prompt(&in)) return;
+    const RecordFilter* f = &in.filter;
+
+    if (!read_line("输出 (1=显示列表 [默认], 2=只统计, 3=导出 CSV): ", input, sizeof(input))) return;
+
+    if (input[0] == '2') {
+        QueryTotals t;
+        if (!record_query_count(f, &t, stderr)) {
+            printf("❌ 查询失败。\n");
+            return;
+        }
+        char income[MONEY_BUF_SIZE], expense[MONEY_BUF_SIZE], balance[MONEY_BUF_SIZE];
+        format_money(t.income, income, sizeof(income));
+        format_money(t.expense, expense, sizeof(expense));
+        format_money(t.income - t.expense, balance, sizeof(balance));
+        printf("📊 共 %ld 条  收入 %s  支出 %s  结余 %s\n", t.count, income, expense, balance);
+    } else if (input[0] == '3') {
+        char filename[256];
+        if (!read_line("请输入导出文件名（如 query.csv）: ", filename, sizeof(filename))) return;
+        if (filename[0] == '\0') {
+            printf("❌ 文件名不能为空！\n");
+            return;
+        }
+        FILE* fp = fopen(filename, "wb");
+        if (!fp) {
+            printf("❌ 无法创建文件 \"%s\"\n", filename);
+            return;
+        }
+        long count = record_query_csv(f, fp, 1, stderr);   // 带 BOM，便于 Excel 打开
+        if (fclose(fp) != 0) count = -1;
+        if (count < 0) {
+            printf("❌ 导出失败。\n");
+            return;
+        }
+        printf("✅ 已导出 %ld 条记录到 \"%s\"\n", count, filename);
+    } else {
+        long count = record_query_print(f, stderr);
+        if (count == 0) printf("📝 未找到符合条件的记录。\n");
+        else if (count > 0) printf("共 %ld 条记录。\n", count);
+    }
+}
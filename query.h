@@ -0,0 +1,49 @@
+// query.h
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "sqlite3.h"
+
+// 组合查询条件：各条件之间为 AND，未设置的条件不出现在 SQL 中
+typedef struct {
+    int has_from, has_to;
+    int32_t day_from, day_to;       // 日期区间（date_to_days 天数，含两端）
+    const char* type;               // income / expense，NULL 不限
+    int category_id;                // 该分类及其子分类，0 不限
+    const char* category_like;      // 分类关键词（子分类或父分类名包含），NULL 不限
+    int account_id;                 // 0 不限
+    int member_id;                  // 0 不限
+    int has_min, has_max;
+    int64_t amount_min, amount_max; // 金额区间（分，含两端）
+    const char* remark;             // 备注包含，NULL 不限
+} RecordFilter;
+
+typedef struct {
+    long count;
+    int64_t income;
+    int64_t expense;
+} QueryTotals;
+
+void record_filter_init(RecordFilter* f);
+
+// 以下均生成一条参数化 SQL，结果按日期倒序流式输出；失败返回 -1（count 返回 0），原因写到 err（NULL 为 stderr）
+long record_query_print(const RecordFilter* f, FILE* err);
+long record_query_csv(const RecordFilter* f, FILE* fp, int with_bom, FILE* err);
+int record_query_count(const RecordFilter* f, QueryTotals* out, FILE* err);
+// 不排序，逐行回调（select 以 "FROM records r " 结尾，列由调用方决定）；fn 返回 0 时中止并返回 -1
+typedef int (*RecordRowFn)(void* ctx, sqlite3_stmt* stmt);
+long record_query_each(const RecordFilter* f, const char* select, RecordRowFn fn, void* ctx, FILE* err);
+
+// 交互输入筛选条件（各项回车表示不限）；字符串条件指向本结构内的缓冲。输入无效返回 0
+typedef struct {
+    RecordFilter filter;
+    char category[64];
+    char remark[128];
+} RecordFilterInput;
+
+int record_filter_prompt(RecordFilterInput* in);
+void query_records_menu(void);
+
+#endif
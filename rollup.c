@@ -0,0 +1,199 @@
+// rollup.c
+#include <stdio.h>
+#include <stdint.h>
+#include "rollup.h"
+#include "db.h"
+#include "utils.h"
+
+// 汇总表结构或触发器变化时递增，启动时自动重建
+#define ROLLUP_VERSION 1
+
+static const char* const rollup_schema_sql =
+    "CREATE TABLE IF NOT EXISTS rollup_month_type ("
+    "  month TEXT NOT NULL,"                 // 'YYYY-MM'
+    "  type TEXT NOT NULL,"
+    "  total INTEGER NOT NULL DEFAULT 0,"    // 分
+    "  cnt INTEGER NOT NULL DEFAULT 0,"
+    "  PRIMARY KEY (month, type)"
+    ") WITHOUT ROWID;"
+
+    "CREATE TABLE IF NOT EXISTS rollup_month_category_member ("
+    "  month TEXT NOT NULL,"
+    "  type TEXT NOT NULL,"
+    "  category_id INTEGER NOT NULL,"
+    "  member_id INTEGER NOT NULL,"
+    "  total INTEGER NOT NULL DEFAULT 0,"
+    "  cnt INTEGER NOT NULL DEFAULT 0,"
+    "  PRIMARY KEY (month, type, category_id, member_id)"
+    ") WITHOUT ROWID;"
+
+    // 新增：累加到对应月份
+    "CREATE TRIGGER IF NOT EXISTS trg_rollup_records_insert AFTER INSERT ON records BEGIN "
+    "  INSERT INTO rollup_month_type (month, type, total, cnt) "
+    "    VALUES (substr(NEW.date, 1, 7), NEW.type, NEW.amount, 1) "
+    "    ON CONFLICT(month, type) DO UPDATE SET total = total + excluded.total, cnt = cnt + 1;"
+    "  INSERT INTO rollup_month_category_member (month, type, category_id, member_id, total, cnt) "
+    "    VALUES (substr(NEW.date, 1, 7), NEW.type, NEW.category_id, COALESCE(NEW.member_id, 0), NEW.amount, 1) "
+    "    ON CONFLICT(month, type, category_id, member_id) "
+    "    DO UPDATE SET total = total + excluded.total, cnt = cnt + 1;"
+    "END;"
+
+    // 删除：从原月份扣减，计数归零的行一并删除
+    "CREATE TRIGGER IF NOT EXISTS trg_rollup_records_delete AFTER DELETE ON records BEGIN "
+    "  UPDATE rollup_month_type SET total = total - OLD.amount, cnt = cnt - 1 "
+    "    WHERE month = substr(OLD.date, 1, 7) AND type = OLD.type;"
+    "  DELETE FROM rollup_month_type "
+    "    WHERE month = substr(OLD.date, 1, 7) AND type = OLD.type AND cnt <= 0;"
+    "  UPDATE rollup_month_category_member SET total = total - OLD.amount, cnt = cnt - 1 "
+    "    WHERE month = substr(OLD.date, 1, 7) AND type = OLD.type "
+    "      AND category_id = OLD.category_id AND member_id = COALESCE(OLD.member_id, 0);"
+    "  DELETE FROM rollup_month_category_member "
+    "    WHERE month = substr(OLD.date, 1, 7) AND type = OLD.type "
+    "      AND category_id = OLD.category_id AND member_id = COALESCE(OLD.member_id, 0) AND cnt <= 0;"
+    "END;"
+
+    // 修改：先按旧值扣减，再按新值累加
+    "CREATE TRIGGER IF NOT EXISTS trg_rollup_records_update "
+    "AFTER UPDATE OF date, type, amount, category_id, member_id ON records BEGIN "
+    "  UPDATE rollup_month_type SET total = total - OLD.amount, cnt = cnt - 1 "
+    "    WHERE month = substr(OLD.date, 1, 7) AND type = OLD.type;"
+    "  DELETE FROM rollup_month_type "
+    "    WHERE month = substr(OLD.date, 1, 7) AND type = OLD.type AND cnt <= 0;"
+    "  UPDATE rollup_month_category_member SET total = total - OLD.amount, cnt = cnt - 1 "
+    "    WHERE month = substr(OLD.date, 1, 7) AND type = OLD.type "
+    "      AND category_id = OLD.category_id AND member_id = COALESCE(OLD.member_id, 0);"
+    "  DELETE FROM rollup_month_category_member "
+    "    WHERE month = substr(OLD.date, 1, 7) AND type = OLD.type "
+    "      AND category_id = OLD.category_id AND member_id = COALESCE(OLD.member_id, 0) AND cnt <= 0;"
+    "  INSERT INTO rollup_month_type (month, type, total, cnt) "
+    "    VALUES (substr(NEW.date, 1, 7), NEW.type, NEW.amount, 1) "
+    "    ON CONFLICT(month, type) DO UPDATE SET total = total + excluded.total, cnt = cnt + 1;"
+    "  INSERT INTO rollup_month_category_member (month, type, category_id, member_id, total, cnt) "
+    "    VALUES (substr(NEW.date, 1, 7), NEW.type, NEW.category_id, COALESCE(NEW.member_id, 0), NEW.amount, 1) "
+    "    ON CONFLICT(month, type, category_id, member_id) "
+    "    DO UPDATE SET total = total + excluded.total, cnt = cnt + 1;"
+    "END;";
+
+// 从 records 全量重算汇总（调用方负责事务）
+static int rebuild_rollups_in(sqlite3* db) {
+    const char* sql =
+        "DELETE FROM rollup_month_type;"
+        "DELETE FROM rollup_month_category_member;"
+        "INSERT INTO rollup_month_category_member (month, type, category_id, member_id, total, cnt) "
+        "  SELECT substr(date, 1, 7), type, category_id, COALESCE(member_id, 0), SUM(amount), COUNT(*) "
+        "  FROM records GROUP BY 1, 2, 3, 4;"
+        // 粗粒度表由细粒度表汇总得到，只扫描 records 一次
+        "INSERT INTO rollup_month_type (month, type, total, cnt) "
+        "  SELECT month, type, SUM(total), SUM(cnt) FROM rollup_month_category_member "
+        "  GROUP BY 1, 2;";
+    char* err = NULL;
+    if (sqlite3_exec(db, sql, NULL, NULL, &err) != SQLITE_OK) {
+        fprintf(stderr, "❌ 重建汇总失败: %s\n", err ? err : sqlite3_errmsg(db));
+        sqlite3_free(err);
+        return 0;
+    }
+    return 1;
+}
+
+// 创建汇总表与触发器；版本变化（含首次）时删除旧触发器并重建数据
+void init_rollups(sqlite3* db) {
+    if (!db) return;
+
+    if (db_get_setting_int("rollup_version", 0) == ROLLUP_VERSION) return;
+
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = (sqlite3_exec(db,
+        "DROP TRIGGER IF EXISTS trg_rollup_records_insert;"
+        "DROP TRIGGER IF EXISTS trg_rollup_records_delete;"
+        "DROP TRIGGER IF EXISTS trg_rollup_records_update;"
+        "DROP TABLE IF EXISTS rollup_month_type;"
+        "DROP TABLE IF EXISTS rollup_month_category_member;", NULL, NULL, NULL) == SQLITE_OK);
+    if (ok && sqlite3_exec(db, rollup_schema_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "❌ 创建汇总表失败: %s\n", sqlite3_errmsg(db));
+        ok = 0;
+    }
+    if (ok) ok = rebuild_rollups_in(db);
+    if (ok) ok = db_set_setting_int("rollup_version", ROLLUP_VERSION);
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+}
+
+// 批量写入前暂停增量维护：删除触发器并作废版本号，之后由 init_rollups 重建
+int suspend_rollups(sqlite3* db) {
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = (sqlite3_exec(db,
+        "DROP TRIGGER IF EXISTS trg_rollup_records_insert;"
+        "DROP TRIGGER IF EXISTS trg_rollup_records_delete;"
+        "DROP TRIGGER IF EXISTS trg_rollup_records_update;"
+        "DELETE FROM app_settings WHERE key = 'rollup_version';", NULL, NULL, NULL) == SQLITE_OK);
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+    return ok;
+}
+
+// 暂停后恢复：补回触发器并标记汇总为最新（调用方已用 rollup_add 维护数据）
+int resume_rollups(sqlite3* db) {
+    if (sqlite3_exec(db, rollup_schema_sql, NULL, NULL, NULL) != SQLITE_OK) return 0;
+    return db_set_setting_int("rollup_version", ROLLUP_VERSION);
+}
+
+int64_t rollup_record_count(sqlite3* db) {
+    if (db_get_setting_int("rollup_version", 0) != ROLLUP_VERSION) return -1;
+    sqlite3_stmt* stmt = db_prepare(db, "SELECT COALESCE(SUM(cnt), 0) FROM rollup_month_type;");
+    if (!stmt) return -1;
+    int64_t n = (sqlite3_step(stmt) == SQLITE_ROW) ? sqlite3_column_int64(stmt, 0) : -1;
+    db_release(stmt);
+    return n;
+}
+
+// 把一组预先聚合的记录计入汇总（批量导入时代替逐行触发器）
+int rollup_add(sqlite3* db, const char* month, const char* type,
+               int category_id, int member_id, int64_t total, int64_t cnt) {
+    sqlite3_stmt* stmt = db_prepare(db,
+        "INSERT INTO rollup_month_type (month, type, total, cnt) VALUES (?, ?, ?, ?) "
+        "ON CONFLICT(month, type) DO UPDATE SET total = total + excluded.total, cnt = cnt + excluded.cnt;");
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, month, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, type, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, total);
+    sqlite3_bind_int64(stmt, 4, cnt);
+    int ok = (sqlite3_step(stmt) == SQLITE_DONE);
+    db_release(stmt);
+    if (!ok) return 0;
+
+    stmt = db_prepare(db,
+        "INSERT INTO rollup_month_category_member (month, type, category_id, member_id, total, cnt) "
+        "VALUES (?, ?, ?, ?, ?, ?) "
+        "ON CONFLICT(month, type, category_id, member_id) "
+        "DO UPDATE SET total = total + excluded.total, cnt = cnt + excluded.cnt;");
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, month, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, type, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 3, category_id);
+    sqlite3_bind_int(stmt, 4, member_id);
+    sqlite3_bind_int64(stmt, 5, total);
+    sqlite3_bind_int64(stmt, 6, cnt);
+    ok = (sqlite3_step(stmt) == SQLITE_DONE);
+    db_release(stmt);
+    return ok;
+}
+
+// 手动重建（用于修复或校验），返回 1 表示成功
+int rebuild_rollups(void) {
+    sqlite3* db = db_get();
+    if (!db) return 0;
+
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = rebuild_rollups_in(db);
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+    return ok;
+}
+
+// 设置菜单入口
+void rebuild_rollups_menu(void) {
+    printf("⏳ 正在从全部记录重建月度汇总...\n");
+    double start = now_ms();
+    if (rebuild_rollups()) {
+        printf("✅ 汇总重建完成（耗时 %.0f ms）。\n", now_ms() - start);
+    } else {
+        printf("❌ 汇总重建失败。\n");
+    }
+}
@@ -0,0 +1,21 @@
+// rollup.h
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdint.h>
+#include "sqlite3.h"
+
+// 月度汇总表（由 records 上的触发器增量维护，报表只读汇总行）
+//   rollup_month_type            : 月份 × 类型
+//   rollup_month_category_member : 月份 × 类型 × 分类 × 成员（member_id = 0 表示无成员）
+void init_rollups(sqlite3* db);
+int rebuild_rollups(void);
+int suspend_rollups(sqlite3* db);
+int resume_rollups(sqlite3* db);
+int rollup_add(sqlite3* db, const char* month, const char* type,
+               int category_id, int member_id, int64_t total, int64_t cnt);
+// 汇总表记录的 records 总条数；汇总未启用（如导入中）时返回 -1
+int64_t rollup_record_count(sqlite3* db);
+void rebuild_rollups_menu(void);
+
+#endif
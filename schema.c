@@ -0,0 +1,212 @@
+// schema.c
+#include <stdio.h>
+#include <string.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "schema.h"
+
+// records.day：date 对应的 1970-01-01 起天数（虚拟生成列，不占存储；列式快照读取时计算）
+#define RECORDS_DAY_COLUMN_SQL \
+    "day INTEGER GENERATED ALWAYS AS (CAST(julianday(date) - 2440587.5 AS INTEGER)) VIRTUAL"
+
+// accounts / records 列定义（建表与金额迁移重建共用）
+#define ACCOUNTS_COLUMNS_SQL \
+    "id INTEGER PRIMARY KEY AUTOINCREMENT, " \
+    "name TEXT NOT NULL UNIQUE, " \
+    "balance INTEGER DEFAULT 0"
+
+#define RECORDS_COLUMNS_SQL \
+    "  id INTEGER PRIMARY KEY AUTOINCREMENT," \
+    "  amount INTEGER NOT NULL CHECK(amount > 0)," \
+    "  type TEXT NOT NULL CHECK(type IN ('income', 'expense')), " \
+    "  category_id INTEGER NOT NULL," \
+    "  account_id INTEGER NOT NULL," \
+    "  member_id INTEGER," \
+    "  remark TEXT," \
+    "  date TEXT NOT NULL CHECK(date LIKE '____-__-__')," \
+    "  created_at TEXT DEFAULT (datetime('now', 'localtime')), " \
+    "  updated_at TEXT DEFAULT (datetime('now', 'localtime')), " \
+    "  " RECORDS_DAY_COLUMN_SQL "," \
+    "  FOREIGN KEY(category_id) REFERENCES categories(id)," \
+    "  FOREIGN KEY(account_id) REFERENCES accounts(id)," \
+    "  FOREIGN KEY(member_id) REFERENCES members(id)"
+
+typedef struct {
+    int version;                // 执行后的 user_version
+    const char* name;
+    int (*apply)(sqlite3* db);  // 在事务内执行，成功返回 1
+    int rebuilds_tables;        // 重建表：关闭外键执行，提交前做外键检查
+} SchemaStep;
+
+static int column_exists(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = db_prepare(db, sql);
+    if (!stmt) return 0;
+    int exists = (sqlite3_step(stmt) == SQLITE_ROW);
+    db_release(stmt);
+    return exists;
+}
+
+// 版本 1～4 对应引入 user_version 之前的历史迁移，旧库可能已部分执行过，
+// 因此各步先检查现状；之后新增的步骤只会执行一次，无需再做检查
+
+// v1：基础表
+static int create_base_tables(sqlite3* db) {
+    const char* sql =
+        // 管理员（单行）
+        "CREATE TABLE IF NOT EXISTS admin ("
+        "  id INTEGER PRIMARY KEY CHECK (id = 1), "
+        "  password_hash TEXT NOT NULL, "
+        "  salt TEXT NOT NULL);"
+        // 分类表（支持父子结构）
+        "CREATE TABLE IF NOT EXISTS categories ("
+        "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "  name TEXT NOT NULL UNIQUE,"
+        "  parent_id INTEGER,"
+        "  type TEXT NOT NULL CHECK(type IN ('income', 'expense')), "
+        "  FOREIGN KEY(parent_id) REFERENCES categories(id));"
+        // 账户表（balance 单位：分）
+        "CREATE TABLE IF NOT EXISTS accounts (" ACCOUNTS_COLUMNS_SQL ");"
+        // 成员表（家庭成员）
+        "CREATE TABLE IF NOT EXISTS members ("
+        "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "  name TEXT NOT NULL UNIQUE);"
+        // 记录表（核心，amount 单位：分）
+        "CREATE TABLE IF NOT EXISTS records (" RECORDS_COLUMNS_SQL ");"
+        // 应用配置表（键值对）
+        "CREATE TABLE IF NOT EXISTS app_settings ("
+        "  key TEXT PRIMARY KEY,"
+        "  value TEXT NOT NULL);";
+    return sqlite3_exec(db, sql, NULL, NULL, NULL) == SQLITE_OK;
+}
+
+// v2：金额从 REAL（元）转为 INTEGER（分）
+// SQLite 不能修改列类型，按官方流程重建表（外键关闭与提交前检查由 apply_step 负责）
+static int migrate_money_to_cents(sqlite3* db) {
+    sqlite3_stmt* stmt = db_prepare(db,
+        "SELECT type FROM pragma_table_info('records') WHERE name = 'amount';");
+    if (!stmt) return 0;
+    int is_real = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* type = (const char*)sqlite3_column_text(stmt, 0);
+        is_real = (type && strcasecmp(type, "REAL") == 0);
+    }
+    db_release(stmt);
+    if (!is_real) return 1;
+
+    fprintf(stderr, "⏳ 正在将金额迁移为整数（分），请稍候...\n");
+    const char* migrate_sql =
+        "CREATE TABLE accounts_new (" ACCOUNTS_COLUMNS_SQL ");"
+        "INSERT INTO accounts_new (id, name, balance) "
+        "  SELECT id, name, CAST(ROUND(COALESCE(balance, 0) * 100) AS INTEGER) FROM accounts;"
+        "DROP TABLE accounts;"
+        "ALTER TABLE accounts_new RENAME TO accounts;"
+        "CREATE TABLE records_new (" RECORDS_COLUMNS_SQL ");"
+        "INSERT INTO records_new (id, amount, type, category_id, account_id, member_id, "
+        "                         remark, date, created_at, updated_at) "
+        "  SELECT id, CAST(ROUND(amount * 100) AS INTEGER), type, category_id, account_id, member_id, "
+        "         remark, date, created_at, updated_at FROM records;"
+        "DROP TABLE records;"
+        "ALTER TABLE records_new RENAME TO records;"
+        // 索引与触发器随旧表删除，清除派生结构的版本号让各模块重建
+        "DELETE FROM app_settings WHERE key IN "
+        "  ('records_index_version', 'rollup_version', 'balance_version', 'search_version');";
+    if (sqlite3_exec(db, migrate_sql, NULL, NULL, NULL) != SQLITE_OK) return 0;
+    fprintf(stderr, "✅ 金额迁移完成。\n");
+    return 1;
+}
+
+// v3：records.day 生成列（VIRTUAL 列可直接 ALTER TABLE 添加，不重写数据）
+static int add_day_column(sqlite3* db) {
+    if (column_exists(db, "SELECT 1 FROM pragma_table_xinfo('records') WHERE name = 'day';")) return 1;
+    return sqlite3_exec(db, "ALTER TABLE records ADD COLUMN " RECORDS_DAY_COLUMN_SQL ";",
+                        NULL, NULL, NULL) == SQLITE_OK;
+}
+
+// v4：accounts.opening_balance，按 账面余额 − 已有记录净额 推出期初
+static int add_opening_balance(sqlite3* db) {
+    if (column_exists(db, "SELECT 1 FROM pragma_table_info('accounts') WHERE name = 'opening_balance';")) {
+        return 1;
+    }
+    return sqlite3_exec(db,
+        "ALTER TABLE accounts ADD COLUMN opening_balance INTEGER NOT NULL DEFAULT 0;"
+        "UPDATE accounts SET opening_balance = balance - COALESCE(("
+        "  SELECT SUM(CASE WHEN r.type = 'income' THEN r.amount ELSE -r.amount END) "
+        "  FROM records r WHERE r.account_id = accounts.id), 0);",
+        NULL, NULL, NULL) == SQLITE_OK;
+}
+
+// v5：admin.iterations，PBKDF2 迭代次数（0 表示旧版单次 SHA256，下次登录时升级）
+static int add_kdf_iterations(sqlite3* db) {
+    return sqlite3_exec(db, "ALTER TABLE admin ADD COLUMN iterations INTEGER NOT NULL DEFAULT 0;",
+                        NULL, NULL, NULL) == SQLITE_OK;
+}
+
+// 按版本号升序排列；新增步骤追加在末尾并同步修改 SCHEMA_VERSION
+static const SchemaStep schema_steps[] = {
+    { 1, "基础表",           create_base_tables,    0 },
+    { 2, "金额改为整数分",   migrate_money_to_cents, 1 },
+    { 3, "日期天数列",       add_day_column,        0 },
+    { 4, "账户期初余额",     add_opening_balance,   0 },
+    { 5, "口令迭代次数",     add_kdf_iterations,    0 },
+};
+
+int schema_version(sqlite3* db) {
+    int version = -1;
+    sqlite3_stmt* stmt = db_prepare(db, "PRAGMA user_version;");
+    if (!stmt) return -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) version = sqlite3_column_int(stmt, 0);
+    db_release(stmt);
+    return version;
+}
+
+static int foreign_keys_intact(sqlite3* db) {
+    sqlite3_stmt* check = db_prepare(db, "PRAGMA foreign_key_check;");
+    if (!check) return 0;
+    int intact = (sqlite3_step(check) == SQLITE_DONE);
+    db_release(check);
+    if (!intact) fprintf(stderr, "❌ 升级后外键检查失败\n");
+    return intact;
+}
+
+static int apply_step(sqlite3* db, const SchemaStep* step) {
+    // PRAGMA foreign_keys 在事务内无效，须在 BEGIN 之前切换
+    if (step->rebuilds_tables) sqlite3_exec(db, "PRAGMA foreign_keys = OFF;", NULL, NULL, NULL);
+
+    // IMMEDIATE：先拿写锁再复查版本，多个进程同时启动时每步只执行一次
+    int ok = (sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) == SQLITE_OK);
+    if (ok && schema_version(db) < step->version) {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "PRAGMA user_version = %d;", step->version);
+        ok = step->apply(db)
+          && (!step->rebuilds_tables || foreign_keys_intact(db))
+          && sqlite3_exec(db, sql, NULL, NULL, NULL) == SQLITE_OK;
+    }
+    if (!ok) {
+        fprintf(stderr, "❌ 数据库升级到版本 %d（%s）失败: %s\n", step->version, step->name, sqlite3_errmsg(db));
+    }
+    if (!sqlite3_get_autocommit(db)) sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+
+    if (step->rebuilds_tables) sqlite3_exec(db, "PRAGMA foreign_keys = ON;", NULL, NULL, NULL);
+    return ok;
+}
+
+int schema_migrate(sqlite3* db) {
+    if (!db) return 0;
+
+    int version = schema_version(db);
+    if (version == SCHEMA_VERSION) return 1;
+    if (version < 0) {
+        fprintf(stderr, "❌ 读取数据库版本失败: %s\n", sqlite3_errmsg(db));
+        return 0;
+    }
+    if (version > SCHEMA_VERSION) {
+        fprintf(stderr, "❌ 数据库版本 %d 高于本程序支持的 %d，请升级程序。\n", version, SCHEMA_VERSION);
+        return 0;
+    }
+
+    for (size_t i = 0; i < sizeof(schema_steps) / sizeof(schema_steps[0]); i++) {
+        if (schema_steps[i].version <= version) continue;
+        if (!apply_step(db, &schema_steps[i])) return 0;
+    }
+    return 1;
+}
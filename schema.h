@@ -0,0 +1,16 @@
+// schema.h
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include "sqlite3.h"
+
+// 表结构版本记在 PRAGMA user_version（数据库文件头，读取不访问任何表）。
+// 启动时版本已是最新则直接返回，不执行任何 DDL；否则依次执行缺少的升级步骤，
+// 每一步在一个事务内完成并同时写入新版本号，中途失败不会留下半升级的结构。
+// 索引、汇总表、余额检查点、备注索引等可重建的派生结构仍由各模块按 app_settings 中的版本号维护
+#define SCHEMA_VERSION 5
+
+int schema_version(sqlite3* db);
+int schema_migrate(sqlite3* db);    // 成功（含无需升级）返回 1
+
+#endif
@@ -0,0 +1,310 @@
+// search.c
+#include <stdio.h>
+#include <string.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "utils.h"
+#include "finance.h"
+#include "search.h"
+
+// 索引表、触发器或分词规则变化时递增，启动时自动重建
+// 2：内置 trigram 分词器代替程序内注册的分词器，其他 SQLite 工具也能写 records
+#define SEARCH_VERSION 2
+
+#define SEARCH_MATCH_SIZE 1024
+#define SEARCH_MAX_TERMS 8
+#define SEARCH_TRIGRAM 3        // trigram 只能索引至少 3 个字符的搜索词
+
+// === 索引维护 ===
+// 版本 1 的索引表声明了程序内分词器 "remark"；较旧的 SQLite 删除 FTS5 表时也要先载入其分词器，
+// 这里注册一个不产生任何词的空实现，仅供升级时删除旧表
+static int legacy_instance;
+
+static int legacy_create(void* ctx, const char** argv, int argc, Fts5Tokenizer** out) {
+    (void)ctx; (void)argv; (void)argc;
+    *out = (Fts5Tokenizer*)&legacy_instance;
+    return SQLITE_OK;
+}
+
+static void legacy_delete(Fts5Tokenizer* t) {
+    (void)t;
+}
+
+static int legacy_tokenize(Fts5Tokenizer* t, void* ctx, int flags, const char* text, int n,
+                           int (*emit)(void*, int, const char*, int, int, int)) {
+    (void)t; (void)ctx; (void)flags; (void)text; (void)n; (void)emit;
+    return SQLITE_OK;
+}
+
+static sqlite3* registered_db;
+static int available;
+
+int search_available(void) {
+    return available;
+}
+
+int search_register(sqlite3* db) {
+    if (!db) return 0;
+    if (db == registered_db) return available;
+    registered_db = db;
+    available = 0;
+
+    // 取 fts5_api 指针（未编译 FTS5 时 fts5() 函数不存在），trigram 需要 SQLite 3.34+
+    fts5_api* api = NULL;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT fts5(?1);", -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_pointer(stmt, 1, (void*)&api, "fts5_api_ptr", NULL);
+        sqlite3_step(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (!api) return 0;
+
+    void* user_data = NULL;
+    fts5_tokenizer tokenizer;
+    available = (api->xFindTokenizer(api, "trigram", &user_data, &tokenizer) == SQLITE_OK);
+    static fts5_tokenizer legacy = { legacy_create, legacy_delete, legacy_tokenize };
+    if (available) api->xCreateTokenizer(api, "remark", NULL, &legacy, NULL);
+    return available;
+}
+
+// 备注为空的记录不进索引；删除/修改时按同一条件从索引移除旧内容（外部内容表要求与写入时一致）
+static const char* const search_schema_sql =
+    "CREATE VIRTUAL TABLE IF NOT EXISTS records_fts USING fts5("
+    "  remark, content = 'records', content_rowid = 'id', tokenize = 'trigram');"
+
+    "CREATE TRIGGER IF NOT EXISTS trg_fts_records_insert AFTER INSERT ON records "
+    "WHEN NEW.remark <> '' BEGIN "
+    "  INSERT INTO records_fts (rowid, remark) VALUES (NEW.id, NEW.remark);"
+    "END;"
+
+    "CREATE TRIGGER IF NOT EXISTS trg_fts_records_delete AFTER DELETE ON records "
+    "WHEN OLD.remark <> '' BEGIN "
+    "  INSERT INTO records_fts (records_fts, rowid, remark) VALUES ('delete', OLD.id, OLD.remark);"
+    "END;"
+
+    "CREATE TRIGGER IF NOT EXISTS trg_fts_records_update AFTER UPDATE OF remark ON records BEGIN "
+    "  INSERT INTO records_fts (records_fts, rowid, remark) "
+    "    SELECT 'delete', OLD.id, OLD.remark WHERE OLD.remark <> '';"
+    "  INSERT INTO records_fts (rowid, remark) "
+    "    SELECT NEW.id, NEW.remark WHERE NEW.remark <> '';"
+    "END;";
+
+static const char* const search_drop_triggers_sql =
+    "DROP TRIGGER IF EXISTS trg_fts_records_insert;"
+    "DROP TRIGGER IF EXISTS trg_fts_records_delete;"
+    "DROP TRIGGER IF EXISTS trg_fts_records_update;";
+
+// 从 records 全量重建索引（调用方负责事务）
+static int rebuild_search_index_in(sqlite3* db) {
+    const char* sql =
+        "INSERT INTO records_fts (records_fts) VALUES ('delete-all');"
+        "INSERT INTO records_fts (rowid, remark) SELECT id, remark FROM records WHERE remark <> '';"
+        "INSERT INTO records_fts (records_fts) VALUES ('optimize');";   // 合并为单个段，查询最快
+    char* err = NULL;
+    if (sqlite3_exec(db, sql, NULL, NULL, &err) != SQLITE_OK) {
+        fprintf(stderr, "❌ 重建备注索引失败: %s\n", err ? err : sqlite3_errmsg(db));
+        sqlite3_free(err);
+        return 0;
+    }
+    return 1;
+}
+
+void init_search_index(sqlite3* db) {
+    if (!db || !search_register(db)) return;
+
+    if (db_get_setting_int("search_version", 0) == SEARCH_VERSION) return;
+
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = (sqlite3_exec(db, search_drop_triggers_sql, NULL, NULL, NULL) == SQLITE_OK
+           && sqlite3_exec(db, "DROP TABLE IF EXISTS records_fts;", NULL, NULL, NULL) == SQLITE_OK);
+    if (!ok) fprintf(stderr, "❌ 删除旧备注索引失败: %s\n", sqlite3_errmsg(db));
+    if (ok && sqlite3_exec(db, search_schema_sql, NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "❌ 创建备注索引失败: %s\n", sqlite3_errmsg(db));
+        ok = 0;
+    }
+    if (ok) ok = rebuild_search_index_in(db);
+    if (ok) ok = db_set_setting_int("search_version", SEARCH_VERSION);
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+}
+
+int suspend_search_index(sqlite3* db) {
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = (sqlite3_exec(db, search_drop_triggers_sql, NULL, NULL, NULL) == SQLITE_OK
+           && sqlite3_exec(db, "DELETE FROM app_settings WHERE key = 'search_version';",
+                           NULL, NULL, NULL) == SQLITE_OK);
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+    return ok;
+}
+
+int rebuild_search_index(void) {
+    sqlite3* db = db_get();
+    if (!db || !available) return 0;
+
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok = rebuild_search_index_in(db);
+    sqlite3_exec(db, ok ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+    return ok;
+}
+
+// === 搜索 ===
+// 用户输入按空白分成若干词，词之间为 AND，各自匹配备注中任意位置的子串（不区分 ASCII 大小写）。
+// 至少 3 个字符的词作为短语交给 trigram 索引；更短的词索引无法处理，改用 LIKE 在结果上过滤，
+// 全部都是短词时退化为全表扫描（无相关度，按日期倒序）
+typedef struct {
+    char match[SEARCH_MATCH_SIZE];              // FTS5 查询串，空串表示没有长词
+    char patterns[SEARCH_MATCH_SIZE];           // LIKE 模式串依次存放
+    const char* likes[SEARCH_MAX_TERMS];
+    int like_count;
+} SearchQuery;
+
+static int utf8_chars(const char* s, size_t n) {
+    int chars = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (((unsigned char)s[i] & 0xC0) != 0x80) chars++;
+    }
+    return chars;
+}
+
+// 返回词数，为空或过长返回 0
+static int build_query(const char* text, SearchQuery* q) {
+    size_t match_len = 0, pattern_len = 0;
+    int terms = 0;
+    q->like_count = 0;
+    const char* p = text;
+    while (*p) {
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p) break;
+        size_t n = strcspn(p, " \t");
+        if (++terms > SEARCH_MAX_TERMS) return 0;
+
+        if (utf8_chars(p, n) >= SEARCH_TRIGRAM) {
+            if (match_len + n * 2 + 4 >= sizeof(q->match)) return 0;
+            if (match_len) q->match[match_len++] = ' ';
+            q->match[match_len++] = '"';
+            for (size_t i = 0; i < n; i++) {
+                if (p[i] == '"') q->match[match_len++] = '"';    // 短语内的双引号写两次
+                q->match[match_len++] = p[i];
+            }
+            q->match[match_len++] = '"';
+        } else {
+            if (pattern_len + n * 2 + 3 >= sizeof(q->patterns)) return 0;
+            q->likes[q->like_count++] = q->patterns + pattern_len;
+            q->patterns[pattern_len++] = '%';
+            for (size_t i = 0; i < n; i++) {
+                if (p[i] == '%' || p[i] == '_' || p[i] == '\\') q->patterns[pattern_len++] = '\\';
+                q->patterns[pattern_len++] = p[i];
+            }
+            q->patterns[pattern_len++] = '%';
+            q->patterns[pattern_len++] = '\0';
+        }
+        p += n;
+    }
+    q->match[match_len] = '\0';
+    return terms;
+}
+
+static sqlite3_stmt* prepare_search(const char* text, int limit, SearchQuery* q, FILE* err) {
+    sqlite3* db = db_get();
+    if (!db) return NULL;
+    if (!available) {
+        fprintf(err, "❌ 当前 SQLite 未启用 FTS5（或版本低于 3.34），无法搜索备注。\n");
+        return NULL;
+    }
+    if (!build_query(text, q)) {
+        fprintf(err, "❌ 搜索词为空或过长。\n");
+        return NULL;
+    }
+
+    // 按相关度排序，同分时新的在前
+    char sql[1024];
+    int len = snprintf(sql, sizeof(sql), "%s", RECORD_LIST_SELECT);
+    if (q->match[0]) {
+        len += snprintf(sql + len, sizeof(sql) - len,
+                        "JOIN records_fts ON records_fts.rowid = r.id WHERE records_fts MATCH ? ");
+    }
+    for (int i = 0; i < q->like_count; i++) {
+        len += snprintf(sql + len, sizeof(sql) - len, "%s r.remark LIKE ? ESCAPE '\\' ",
+                        (i == 0 && !q->match[0]) ? "WHERE" : "AND");
+    }
+    snprintf(sql + len, sizeof(sql) - len, "ORDER BY %sr.date DESC, r.id DESC LIMIT ?;",
+             q->match[0] ? "records_fts.rank, " : "");
+
+    sqlite3_stmt* stmt = db_prepare(db, sql);
+    if (!stmt) {
+        fprintf(err, "❌ 查询准备失败: %s\n", sqlite3_errmsg(db));
+        return NULL;
+    }
+    int param = 1;
+    if (q->match[0]) sqlite3_bind_text(stmt, param++, q->match, -1, SQLITE_STATIC);
+    for (int i = 0; i < q->like_count; i++) {
+        sqlite3_bind_text(stmt, param++, q->likes[i], -1, SQLITE_STATIC);
+    }
+    sqlite3_bind_int(stmt, param, limit > 0 ? limit : -1);
+    return stmt;
+}
+
+long search_remarks_print(const char* text, int limit, FILE* err) {
+    if (!err) err = stderr;
+    SearchQuery query;
+    sqlite3_stmt* stmt = prepare_search(text, limit, &query, err);
+    if (!stmt) return -1;
+
+    print_record_header();
+    long count = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        print_record_row(stmt);
+        count++;
+    }
+    if (rc != SQLITE_DONE) {
+        fprintf(err, "❌ 搜索失败: %s\n", sqlite3_errmsg(db_get()));
+        count = -1;
+    }
+    db_release(stmt);
+    return count;
+}
+
+long search_remarks_csv(const char* text, int limit, FILE* fp, int with_bom, FILE* err) {
+    if (!err) err = stderr;
+    SearchQuery query;
+    sqlite3_stmt* stmt = prepare_search(text, limit, &query, err);
+    if (!stmt) return -1;
+    long count = write_records_csv_stmt(fp, with_bom, stmt);
+    db_release(stmt);
+    return count;
+}
+
+#define SEARCH_MENU_LIMIT 50
+
+void search_remarks_menu(void) {
+    char input[256];
+    printf("请输入备注关键词（多个词用空格分隔，需同时包含）: ");
+    if (fgets(input, sizeof(input), stdin) == NULL) {
+        printf("❌ 输入失败。\n");
+        return;
+    }
+    input[strcspn(input, "\n")] = 0;
+
+    double start = now_ms();
+    long count = search_remarks_print(input, SEARCH_MENU_LIMIT, stderr);
+    if (count == 0) {
+        printf("📝 没有备注包含“%s”的记录。\n", input);
+    } else if (count > 0) {
+        printf("🔍 按相关度显示 %ld 条（最多 %d 条，耗时 %.1f ms）\n", count, SEARCH_MENU_LIMIT,
+               now_ms() - start);
+    }
+}
+
+void rebuild_search_index_menu(void) {
+    if (!available) {
+        printf("❌ 当前 SQLite 未启用 FTS5（或版本低于 3.34），无法建立备注索引。\n");
+        return;
+    }
+    printf("⏳ 正在从全部记录重建备注索引...\n");
+    double start = now_ms();
+    if (rebuild_search_index()) {
+        printf("✅ 备注索引重建完成（耗时 %.0f ms）。\n", now_ms() - start);
+    } else {
+        printf("❌ 备注索引重建失败。\n");
+    }
+}
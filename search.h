@@ -0,0 +1,24 @@
+// search.h
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdio.h>
+#include "sqlite3.h"
+
+// 备注全文索引：FTS5 外部内容表 records_fts（只存倒排索引，正文仍在 records.remark），
+// 由 records 上的触发器同步。使用 SQLite 内置的 trigram 分词器，任意位置的子串都能命中，
+// 其他 SQLite 工具写 records 时触发器同样可用；不足 3 个字符的搜索词改为 LIKE 过滤。
+int search_register(sqlite3* db);       // 检测 FTS5 与 trigram 是否可用（每个连接一次）
+void init_search_index(sqlite3* db);    // 建表与触发器；版本变化（含首次）时重建索引
+int suspend_search_index(sqlite3* db);  // 批量写入前删除触发器，之后由 init_search_index 重建
+int rebuild_search_index(void);
+int search_available(void);
+
+// 按相关度（bm25）排序，limit <= 0 表示不限；返回条数，失败返回 -1，原因写到 err（NULL 为 stderr）
+long search_remarks_print(const char* text, int limit, FILE* err);
+long search_remarks_csv(const char* text, int limit, FILE* fp, int with_bom, FILE* err);
+
+void search_remarks_menu(void);
+void rebuild_search_index_menu(void);
+
+#endif
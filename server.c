@@ -0,0 +1,743 @@
+// server.c
+#define _GNU_SOURCE     // accept4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "server.h"
+
+#ifndef __linux__
+int server_run(const char* socket_path, int workers) {
+    (void)socket_path;
+    (void)workers;
+    fprintf(stderr, "❌ 守护进程模式仅支持 Linux（依赖 epoll 与 Unix 域套接字）\n");
+    return 0;
+}
+#else
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "db.h"
+#include "cli.h"
+
+#define SERVER_MAX_CONNS    64
+#define SERVER_MAX_LINE     (64 * 1024)         // 单个请求上限
+#define SERVER_MAX_PENDING  (4 * 1024 * 1024)   // 单个连接积压的未处理请求上限
+#define SERVER_MAX_FIELDS   32
+#define SERVER_READ_CHUNK   8192
+
+// === 可增长缓冲区 ===
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} Buf;
+
+static int buf_append(Buf* b, const char* s, size_t n) {
+    if (b->len + n > b->cap) {
+        size_t cap = b->cap ? b->cap : 256;
+        while (cap < b->len + n) cap *= 2;
+        char* grown = realloc(b->data, cap);
+        if (!grown) return 0;
+        b->data = grown;
+        b->cap = cap;
+    }
+    if (n > 0) memcpy(b->data + b->len, s, n);
+    b->len += n;
+    return 1;
+}
+
+static int buf_puts(Buf* b, const char* s) {
+    return buf_append(b, s, strlen(s));
+}
+
+// 丢弃开头 n 字节
+static void buf_consume(Buf* b, size_t n) {
+    memmove(b->data, b->data + n, b->len - n);
+    b->len -= n;
+}
+
+static void buf_free(Buf* b) {
+    free(b->data);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
+
+// 写出 JSON 字符串（含引号）：转义引号、反斜杠与控制字符，其余 UTF-8 原样成段复制
+static int buf_json_string(Buf* b, const char* s, size_t n) {
+    if (!buf_append(b, "\"", 1)) return 0;
+    size_t run = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        char esc[8];
+        switch (c) {
+        case '"':  strcpy(esc, "\\\""); break;
+        case '\\': strcpy(esc, "\\\\"); break;
+        case '\n': strcpy(esc, "\\n"); break;
+        case '\r': strcpy(esc, "\\r"); break;
+        case '\t': strcpy(esc, "\\t"); break;
+        default:   snprintf(esc, sizeof(esc), "\\u%04x", c); break;
+        }
+        if (!buf_append(b, s + run, i - run) || !buf_puts(b, esc)) return 0;
+        run = i + 1;
+    }
+    return buf_append(b, s + run, n - run) && buf_append(b, "\"", 1);
+}
+
+// === 请求解析：只接受一层 JSON 对象，值为字符串、数字、true/false/null ===
+typedef struct {
+    Buf strings;                            // 解码后的键与值，各以 '\0' 结尾
+    size_t key_off[SERVER_MAX_FIELDS];
+    size_t value_off[SERVER_MAX_FIELDS];
+    int count;
+    char id[64];                            // 原样回显的 id 片段，没有时为 null
+} Request;
+
+static const char* skip_ws(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    return p;
+}
+
+static int hex4(const char* p, const char* end, unsigned* out) {
+    if (end - p < 4) return 0;
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (unsigned)(c - 'A' + 10);
+        else return 0;
+    }
+    *out = v;
+    return 1;
+}
+
+static int append_utf8(Buf* b, unsigned cp) {
+    char u[4];
+    size_t n;
+    if (cp < 0x80) {
+        u[0] = (char)cp; n = 1;
+    } else if (cp < 0x800) {
+        u[0] = (char)(0xC0 | (cp >> 6)); u[1] = (char)(0x80 | (cp & 0x3F)); n = 2;
+    } else if (cp < 0x10000) {
+        u[0] = (char)(0xE0 | (cp >> 12)); u[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        u[2] = (char)(0x80 | (cp & 0x3F)); n = 3;
+    } else {
+        u[0] = (char)(0xF0 | (cp >> 18)); u[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        u[2] = (char)(0x80 | ((cp >> 6) & 0x3F)); u[3] = (char)(0x80 | (cp & 0x3F)); n = 4;
+    }
+    return buf_append(b, u, n);
+}
+
+// p 指向开头的引号；解码后追加到 out（以 '\0' 结尾），返回结尾引号之后的位置，出错返回 NULL
+static const char* parse_string(const char* p, const char* end, Buf* out) {
+    p++;
+    while (p < end && *p != '"') {
+        if ((unsigned char)*p < 0x20) return NULL;
+        if (*p != '\\') {
+            const char* run = p;
+            while (p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20) p++;
+            if (!buf_append(out, run, (size_t)(p - run))) return NULL;
+            continue;
+        }
+        if (++p >= end) return NULL;
+        char c = *p++;
+        const char* simple = NULL;
+        switch (c) {
+        case '"': simple = "\""; break;
+        case '\\': simple = "\\"; break;
+        case '/': simple = "/"; break;
+        case 'b': simple = "\b"; break;
+        case 'f': simple = "\f"; break;
+        case 'n': simple = "\n"; break;
+        case 'r': simple = "\r"; break;
+        case 't': simple = "\t"; break;
+        case 'u': {
+            unsigned cp, low;
+            if (!hex4(p, end, &cp)) return NULL;
+            p += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {         // 代理对
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !hex4(p + 2, end, &low)
+                    || low < 0xDC00 || low > 0xDFFF) return NULL;
+                p += 6;
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            } else if ((cp >= 0xDC00 && cp <= 0xDFFF) || cp == 0) {
+                return NULL;                            // 孤立低代理；\u0000 会截断 C 字符串
+            }
+            if (!append_utf8(out, cp)) return NULL;
+            continue;
+        }
+        default: return NULL;
+        }
+        if (!buf_append(out, simple, 1)) return NULL;
+    }
+    if (p >= end || !buf_append(out, "", 1)) return NULL;
+    return p + 1;
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// JSON 数字：-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static int is_json_number(const char* s, size_t n) {
+    size_t i = 0;
+    if (i < n && s[i] == '-') i++;
+    if (i >= n || !is_digit(s[i])) return 0;
+    if (s[i++] != '0') while (i < n && is_digit(s[i])) i++;
+    if (i < n && s[i] == '.') {
+        if (++i >= n || !is_digit(s[i])) return 0;
+        while (i < n && is_digit(s[i])) i++;
+    }
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+        if (++i < n && (s[i] == '+' || s[i] == '-')) i++;
+        if (i >= n || !is_digit(s[i])) return 0;
+        while (i < n && is_digit(s[i])) i++;
+    }
+    return i == n;
+}
+
+// 数字与 true/false/null：取到分隔符为止，校验后原文追加到 out（id 会原样写回响应，必须是合法 JSON）
+static const char* parse_scalar(const char* p, const char* end, Buf* out) {
+    const char* start = p;
+    while (p < end && (*p == '-' || *p == '+' || *p == '.' || is_digit(*p)
+                       || (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'))) p++;
+    size_t n = (size_t)(p - start);
+    int literal = (n == 4 && (memcmp(start, "true", 4) == 0 || memcmp(start, "null", 4) == 0))
+               || (n == 5 && memcmp(start, "false", 5) == 0);
+    if (!literal && !is_json_number(start, n)) return NULL;
+    if (!buf_append(out, start, n) || !buf_append(out, "", 1)) return NULL;
+    return p;
+}
+
+static const char* parse_request(const char* line, size_t len, Request* req) {
+    const char* end = line + len;
+    const char* p = skip_ws(line, end);
+    strcpy(req->id, "null");
+    if (p >= end || *p != '{') return "请求必须是 JSON 对象";
+    p = skip_ws(p + 1, end);
+    if (p < end && *p == '}') return "缺少 op";
+
+    for (;;) {
+        if (p >= end || *p != '"') return "JSON 格式错误：键必须是字符串";
+        size_t key_off = req->strings.len;
+        if (!(p = parse_string(p, end, &req->strings))) return "JSON 格式错误：字符串无效";
+        p = skip_ws(p, end);
+        if (p >= end || *p != ':') return "JSON 格式错误：缺少冒号";
+        p = skip_ws(p + 1, end);
+        if (p >= end) return "JSON 格式错误：缺少取值";
+        if (*p == '{' || *p == '[') return "不支持嵌套的对象或数组";
+
+        const char* value_start = p;
+        size_t value_off = req->strings.len;
+        p = (*p == '"') ? parse_string(p, end, &req->strings) : parse_scalar(p, end, &req->strings);
+        if (!p) return "JSON 格式错误：取值无效";
+
+        const char* key = req->strings.data + key_off;
+        const char* value = req->strings.data + value_off;
+        if (strcmp(key, "id") == 0) {
+            size_t raw = (size_t)(p - value_start);
+            if (raw >= sizeof(req->id)) return "id 过长";
+            memcpy(req->id, value_start, raw);
+            req->id[raw] = '\0';
+        } else if (!(*value_start != '"' && strcmp(value, "null") == 0)) {
+            if (req->count >= SERVER_MAX_FIELDS) return "字段过多";
+            req->key_off[req->count] = key_off;
+            req->value_off[req->count] = value_off;
+            req->count++;
+        }
+
+        p = skip_ws(p, end);
+        if (p < end && *p == ',') {
+            p = skip_ws(p + 1, end);
+            continue;
+        }
+        if (p < end && *p == '}') break;
+        return "JSON 格式错误：缺少逗号或右括号";
+    }
+    if (skip_ws(p + 1, end) != end) return "JSON 格式错误：对象之后有多余内容";
+    return NULL;
+}
+
+// === 连接与服务器状态 ===
+typedef struct {
+    int fd;
+    Buf in;             // 尚未切成行的输入（仅事件循环线程访问）
+    Buf pending;        // 已收到、未处理的请求行，'\n' 分隔
+    Buf out;            // 待发送的响应
+    size_t out_sent;
+    uint32_t events;    // 当前注册的 epoll 事件
+    int busy;           // 工作线程正在处理它的一条请求（同一连接逐条处理，保证应答顺序）
+    int eof;            // 对端不再发送：处理完已收到的请求后关闭
+    int dead;           // 读写出错：空闲时直接关闭
+    int oversized;      // 请求过长或积压过多：不再读取
+} Conn;
+
+typedef struct {
+    int epoll_fd;
+    int listen_fd;
+    int wake_fd;        // eventfd：工作线程产生响应后唤醒事件循环
+    int signal_fd;
+
+    pthread_mutex_t lock;       // 保护连接状态（in 除外）、工作队列与计数
+    pthread_cond_t work_ready;
+    pthread_mutex_t db_lock;    // 共享连接与语句缓存不是线程安全的，命令串行执行
+
+    Conn* conns[SERVER_MAX_CONNS];
+    Conn* queue[SERVER_MAX_CONNS];      // 有待处理请求的连接（每个连接至多排队一次）
+    int queue_head, queue_count;
+    int stopping;
+    long requests;
+} Server;
+
+// epoll 事件的 data.ptr：连接指针，或以下标记
+static int tag_listen, tag_wake, tag_signal;
+
+// 调用方持有 s->lock
+static void schedule(Server* s, Conn* c) {
+    if (c->busy || c->dead || c->pending.len == 0) return;
+    c->busy = 1;
+    s->queue[(s->queue_head + s->queue_count) % SERVER_MAX_CONNS] = c;
+    s->queue_count++;
+    pthread_cond_signal(&s->work_ready);
+}
+
+// 同一连接上的应答按请求顺序写入
+static void append_error(Conn* c, const char* id, const char* message) {
+    Buf* b = &c->out;
+    buf_puts(b, "{\"id\":");
+    buf_puts(b, id);
+    buf_puts(b, ",\"ok\":false,\"code\":2,\"output\":\"\",\"error\":");
+    buf_json_string(b, message, strlen(message));
+    buf_puts(b, "}\n");
+}
+
+// === 请求执行（工作线程） ===
+static void write_stats(Server* s, FILE* out) {
+    StmtCacheStats stats;
+    pthread_mutex_lock(&s->lock);
+    long requests = s->requests;
+    int conns = 0;
+    for (int i = 0; i < SERVER_MAX_CONNS; i++) conns += (s->conns[i] != NULL);
+    pthread_mutex_unlock(&s->lock);
+    db_stmt_cache_stats(&stats);
+    fprintf(out, "请求数,连接数,已缓存语句,缓存命中,缓存未命中\n%ld,%d,%d,%ld,%ld\n",
+            requests, conns, stats.cached, stats.hits, stats.misses);
+}
+
+static void handle_line(Server* s, const char* line, size_t len, Buf* resp) {
+    Request req;
+    memset(&req, 0, sizeof(req));
+    const char* error = parse_request(line, len, &req);
+
+    const char* op = NULL;
+    const char* kind = NULL;
+    char* argv[SERVER_MAX_FIELDS * 2];
+    char names[SERVER_MAX_FIELDS][64];
+    int argc = 0;
+    if (!error) {
+        // report 的报表类型作为第一个位置参数
+        for (int i = 0; i < req.count; i++) {
+            const char* key = req.strings.data + req.key_off[i];
+            if (strcmp(key, "op") == 0) op = req.strings.data + req.value_off[i];
+        }
+        if (!op) error = "缺少 op";
+        else if (strcmp(op, "serve") == 0) error = "不能在守护进程中执行 serve";
+    }
+    for (int i = 0; !error && i < req.count; i++) {
+        const char* key = req.strings.data + req.key_off[i];
+        char* value = req.strings.data + req.value_off[i];
+        if (strcmp(key, "op") == 0) continue;
+        if (op && strcmp(op, "report") == 0 && strcmp(key, "kind") == 0) {
+            kind = value;
+            continue;
+        }
+        if (strlen(key) + 3 > sizeof(names[0])) {
+            error = "选项名过长";
+            break;
+        }
+        char* name = names[argc / 2];
+        snprintf(name, sizeof(names[0]), "--%s", key);
+        argv[argc++] = name;
+        argv[argc++] = value;
+    }
+
+    char* out_text = NULL;
+    char* err_text = NULL;
+    size_t out_len = 0, err_len = 0;
+    int code = 2;
+    if (!error) {
+        FILE* out = open_memstream(&out_text, &out_len);
+        FILE* err = open_memstream(&err_text, &err_len);
+        if (!out || !err) {
+            error = "内存不足";
+            if (out) fclose(out);
+            if (err) fclose(err);
+        } else {
+            // report 的类型放到最前面：argv 整体后移一位
+            char* full[SERVER_MAX_FIELDS * 2 + 1];
+            int full_argc = 0;
+            if (kind) full[full_argc++] = (char*)kind;
+            for (int i = 0; i < argc; i++) full[full_argc++] = argv[i];
+
+            pthread_mutex_lock(&s->db_lock);
+            if (strcmp(op, "ping") == 0) {
+                fputs("pong\n", out);
+                code = 0;
+            } else if (strcmp(op, "stats") == 0) {
+                write_stats(s, out);
+                code = 0;
+            } else {
+                code = cli_execute(op, full_argc, full, out, err);
+            }
+            pthread_mutex_unlock(&s->db_lock);
+            fclose(out);
+            fclose(err);
+        }
+    }
+
+    buf_puts(resp, "{\"id\":");
+    buf_puts(resp, req.id);
+    if (error) {
+        buf_puts(resp, ",\"ok\":false,\"code\":2,\"output\":\"\",\"error\":");
+        buf_json_string(resp, error, strlen(error));
+    } else {
+        char code_text[32];
+        snprintf(code_text, sizeof(code_text), ",\"ok\":%s,\"code\":%d,\"output\":",
+                 code == 0 ? "true" : "false", code);
+        buf_puts(resp, code_text);
+        buf_json_string(resp, out_text ? out_text : "", out_len);
+        buf_puts(resp, ",\"error\":");
+        buf_json_string(resp, err_text ? err_text : "", err_len);
+    }
+    buf_puts(resp, "}\n");
+
+    free(out_text);
+    free(err_text);
+    buf_free(&req.strings);
+}
+
+static void* worker_main(void* arg) {
+    Server* s = arg;
+    Buf line = {0};
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        while (!s->stopping && s->queue_count == 0) pthread_cond_wait(&s->work_ready, &s->lock);
+        if (s->stopping) {
+            pthread_mutex_unlock(&s->lock);
+            break;
+        }
+        Conn* c = s->queue[s->queue_head];
+        s->queue_head = (s->queue_head + 1) % SERVER_MAX_CONNS;
+        s->queue_count--;
+
+        // 取出第一条请求
+        char* nl = memchr(c->pending.data, '\n', c->pending.len);
+        size_t take = nl ? (size_t)(nl - c->pending.data) + 1 : c->pending.len;
+        line.len = 0;
+        buf_append(&line, c->pending.data, take);
+        buf_consume(&c->pending, take);
+        pthread_mutex_unlock(&s->lock);
+
+        Buf resp = {0};
+        handle_line(s, line.data, line.len, &resp);
+
+        pthread_mutex_lock(&s->lock);
+        buf_append(&c->out, resp.data, resp.len);
+        s->requests++;
+        c->busy = 0;
+        schedule(s, c);
+        pthread_mutex_unlock(&s->lock);
+        buf_free(&resp);
+
+        uint64_t one = 1;
+        if (write(s->wake_fd, &one, sizeof(one)) < 0) { /* 计数已非零，循环终会醒来 */ }
+    }
+    buf_free(&line);
+    return NULL;
+}
+
+// === 事件循环 ===
+static void conn_set_events(Server* s, Conn* c, uint32_t events) {
+    if (events == c->events) return;
+    struct epoll_event ev = { .events = events, .data.ptr = c };
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->events = events;
+}
+
+static void conn_close(Server* s, int slot) {
+    Conn* c = s->conns[slot];
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    buf_free(&c->in);
+    buf_free(&c->pending);
+    buf_free(&c->out);
+    free(c);
+    s->conns[slot] = NULL;
+}
+
+static void conn_accept(Server* s) {
+    for (;;) {
+        int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;     // EAGAIN 或暂时性错误
+        }
+        int slot = -1;
+        for (int i = 0; i < SERVER_MAX_CONNS && slot < 0; i++) {
+            if (!s->conns[i]) slot = i;
+        }
+        Conn* c = (slot >= 0) ? calloc(1, sizeof(Conn)) : NULL;
+        if (!c) {
+            static const char busy[] = "{\"id\":null,\"ok\":false,\"code\":2,\"output\":\"\",\"error\":\"连接数已满\"}\n";
+            if (send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL) < 0) { /* 对端已断开 */ }
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->events = EPOLLIN;
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        if (epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+        pthread_mutex_lock(&s->lock);
+        s->conns[slot] = c;
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+static void conn_read(Server* s, Conn* c) {
+    char chunk[SERVER_READ_CHUNK];
+    for (;;) {
+        ssize_t n = read(c->fd, chunk, sizeof(chunk));
+        if (n > 0) {
+            if (!buf_append(&c->in, chunk, (size_t)n)) {
+                c->dead = 1;
+                return;
+            }
+            if (c->in.len > SERVER_MAX_LINE + SERVER_READ_CHUNK) break;
+            continue;
+        }
+        if (n == 0) c->eof = 1;
+        else if (errno == EINTR) continue;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK) c->eof = 1;
+        break;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    // 切出完整的行（空行忽略）；对端关闭时最后一行可以没有换行
+    size_t start = 0;
+    for (;;) {
+        char* nl = memchr(c->in.data + start, '\n', c->in.len - start);
+        size_t stop = nl ? (size_t)(nl - c->in.data) + 1 : (c->eof ? c->in.len : start);
+        if (stop == start) break;
+        int blank = 1;
+        for (size_t i = start; i < stop && blank; i++) {
+            blank = (c->in.data[i] == ' ' || c->in.data[i] == '\t' || c->in.data[i] == '\r' || c->in.data[i] == '\n');
+        }
+        if (stop - start > SERVER_MAX_LINE) {
+            c->oversized = 1;
+            break;
+        }
+        if (!blank) {
+            buf_append(&c->pending, c->in.data + start, stop - start);
+            if (!nl) buf_append(&c->pending, "\n", 1);
+        }
+        start = stop;
+    }
+    buf_consume(&c->in, start);
+    if (c->in.len > SERVER_MAX_LINE || c->pending.len > SERVER_MAX_PENDING) c->oversized = 1;
+    if (c->oversized) {
+        // 之前收到的请求照常应答，随后回一条错误并关闭（见 sweep）
+        c->eof = 1;
+        c->in.len = 0;
+    }
+    schedule(s, c);
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void conn_flush(Server* s, Conn* c) {
+    while (c->out_sent < c->out.len && !c->dead) {
+        ssize_t n = send(c->fd, c->out.data + c->out_sent, c->out.len - c->out_sent, MSG_NOSIGNAL);
+        if (n > 0) c->out_sent += (size_t)n;
+        else if (n < 0 && errno == EINTR) continue;
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        else c->dead = 1;
+    }
+    if (c->out_sent == c->out.len) {
+        c->out.len = 0;
+        c->out_sent = 0;
+    }
+    uint32_t events = (c->eof ? 0 : EPOLLIN) | (c->out.len > 0 ? EPOLLOUT : 0);
+    if (!c->dead) conn_set_events(s, c, events);
+}
+
+// 发送已完成的响应，关闭结束的连接
+static void sweep(Server* s) {
+    pthread_mutex_lock(&s->lock);
+    for (int i = 0; i < SERVER_MAX_CONNS; i++) {
+        Conn* c = s->conns[i];
+        if (!c) continue;
+        if (c->oversized && !c->busy && c->pending.len == 0) {
+            append_error(c, "null", "请求过长");
+            c->oversized = 0;
+        }
+        conn_flush(s, c);
+        int finished = c->eof && c->pending.len == 0 && c->out.len == 0;
+        if (!c->busy && (c->dead || finished)) conn_close(s, i);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+static int open_listener(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "❌ 套接字路径过长: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // 同名文件：能连上说明已有守护进程在运行，否则是上次异常退出遗留的套接字
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "❌ %s 已存在且不是套接字\n", path);
+            return -1;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int running = (probe >= 0 && connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+        if (probe >= 0) close(probe);
+        if (running) {
+            fprintf(stderr, "❌ %s 上已有守护进程在运行\n", path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    mode_t old_mask = umask(077);       // 套接字文件 0600：只有本用户可连接
+    int bound = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(old_mask);
+    if (bound != 0 || listen(fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "❌ 无法监听 %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int add_watch(Server* s, int fd, void* tag) {
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = tag };
+    return epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+int server_run(const char* socket_path, int workers) {
+    Server s;
+    memset(&s, 0, sizeof(s));
+    s.epoll_fd = s.listen_fd = s.wake_fd = s.signal_fd = -1;
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_mutex_init(&s.db_lock, NULL);
+    pthread_cond_init(&s.work_ready, NULL);
+
+    // SIGINT/SIGTERM 经 signalfd 进入事件循环（先屏蔽，工作线程继承屏蔽字）
+    sigset_t stop_signals, old_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+
+    pthread_t threads[SERVER_MAX_WORKERS];
+    int started = 0;
+    int ok = (s.listen_fd = open_listener(socket_path)) >= 0
+          && (s.epoll_fd = epoll_create1(EPOLL_CLOEXEC)) >= 0
+          && (s.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) >= 0
+          && (s.signal_fd = signalfd(-1, &stop_signals, SFD_NONBLOCK | SFD_CLOEXEC)) >= 0
+          && add_watch(&s, s.listen_fd, &tag_listen)
+          && add_watch(&s, s.wake_fd, &tag_wake)
+          && add_watch(&s, s.signal_fd, &tag_signal);
+    while (ok && started < workers && started < SERVER_MAX_WORKERS) {
+        if (pthread_create(&threads[started], NULL, worker_main, &s) != 0) {
+            ok = 0;
+            break;
+        }
+        started++;
+    }
+
+    if (ok) {
+        fprintf(stderr, "✅ 守护进程已启动: %s（%d 个工作线程），Ctrl+C 停止\n", socket_path, started);
+    } else if (s.listen_fd >= 0) {
+        fprintf(stderr, "❌ 守护进程启动失败: %s\n", strerror(errno));
+    }
+
+    struct epoll_event events[SERVER_MAX_CONNS + 3];
+    while (ok && !s.stopping) {
+        int n = epoll_wait(s.epoll_fd, events, (int)(sizeof(events) / sizeof(events[0])), -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void* tag = events[i].data.ptr;
+            if (tag == &tag_listen) {
+                conn_accept(&s);
+            } else if (tag == &tag_wake) {
+                uint64_t count;
+                if (read(s.wake_fd, &count, sizeof(count)) < 0) { /* 已被清零 */ }
+            } else if (tag == &tag_signal) {
+                struct signalfd_siginfo info;
+                if (read(s.signal_fd, &info, sizeof(info)) > 0) s.stopping = 1;
+            } else {
+                Conn* c = tag;
+                if (events[i].events & EPOLLERR) c->dead = 1;
+                else if (events[i].events & (EPOLLIN | EPOLLHUP)) conn_read(&s, c);
+            }
+        }
+        sweep(&s);
+    }
+
+    // 停止：等工作线程做完手头的请求，再关闭全部连接
+    pthread_mutex_lock(&s.lock);
+    s.stopping = 1;
+    pthread_cond_broadcast(&s.work_ready);
+    pthread_mutex_unlock(&s.lock);
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    for (int i = 0; i < SERVER_MAX_CONNS; i++) {
+        if (s.conns[i]) conn_close(&s, i);
+    }
+    if (s.signal_fd >= 0) close(s.signal_fd);
+    if (s.wake_fd >= 0) close(s.wake_fd);
+    if (s.epoll_fd >= 0) close(s.epoll_fd);
+    if (s.listen_fd >= 0) {
+        close(s.listen_fd);
+        unlink(socket_path);
+    }
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    pthread_cond_destroy(&s.work_ready);
+    pthread_mutex_destroy(&s.db_lock);
+    pthread_mutex_destroy(&s.lock);
+
+    if (ok) fprintf(stderr, "守护进程已停止，共处理 %ld 个请求。\n", s.requests);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,22 @@
+// server.h
+#ifndef SERVER_H
+#define SERVER_H
+
+// 守护进程：持有唯一的数据库连接（及其语句缓存、维度缓存、列式快照），
+// 在 Unix 域套接字上按行接收 JSON 请求，逐行返回 JSON 响应。
+//
+// 请求：{"id": 1, "op": "query", "from": "2026-01-01", "type": "expense"}
+//   op 为命令行命令（add/list/export/import/report/query/count/search/balance/reconcile），
+//   其余键即命令行选项（去掉 --）；report 的报表类型用 "kind"。另有 ping、stats。
+// 响应：{"id": 1, "ok": true, "code": 0, "output": "CSV 文本", "error": ""}
+//   id 原样返回；同一连接上的请求按顺序处理与应答。
+//
+// 套接字文件权限为 0600，只有启动守护进程的用户可以连接（仅 Linux）
+#define SERVER_SOCKET_NAME     "finance.sock"
+#define SERVER_DEFAULT_WORKERS 4
+#define SERVER_MAX_WORKERS     32
+
+// 数据库须已打开并初始化；收到 SIGINT/SIGTERM 后退出，返回 1 表示正常结束
+int server_run(const char* socket_path, int workers);
+
+#endif
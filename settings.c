@@ -3,80 +3,66 @@
 #include <stdlib.h>
 #include <string.h>
 #include "sqlite3.h"
+#include "db.h"
 #include "auth.h"
 #include "sha256.h"
+#include "kdf.h"
 #include "utils.h"
 #include "finance.h"
 #include "settings.h"
-#define DATABASE_NAME "finance.db"
-
-// 显示所有分类（一级 + 二级）
-static void list_all_categories(sqlite3* db) {
-    printf("\n--- 所有分类 ---\n");
-    printf("一级分类:\n");
-
-    sqlite3_stmt* stmt;
-    // 先查一级分类 (parent_id IS NULL or 0)
-    const char* sql1 = 
-        "SELECT id, name FROM categories WHERE parent_id IS NULL OR parent_id = 0 ORDER BY id;";
-    if (sqlite3_prepare_v2(db, sql1, -1, &stmt, NULL) != SQLITE_OK) {
-        printf("❌ 查询一级分类失败\n");
+#include "money.h"
+#include "rollup.h"
+#include "category.h"
+#include "dim.h"
+#include "snapshot.h"
+#include "parallel.h"
+#include "search.h"
+#include "balance.h"
+
+// 显示所有分类（一级 + 二级），来自内存分类树
+static void list_all_categories(void) {
+    const CategoryTree* tree = category_tree_get();
+    if (!tree) {
+        printf("❌ 查询分类失败\n");
         return;
     }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const char* name = (const char*)sqlite3_column_text(stmt, 1);
-        printf("  [%d] %s\n", id, name);
-
-        // 查对应的二级分类
-        sqlite3_stmt* sub_stmt;
-        const char* sql2 = "SELECT id, name FROM categories WHERE parent_id = ? ORDER BY id;";
-        if (sqlite3_prepare_v2(db, sql2, -1, &sub_stmt, NULL) == SQLITE_OK) {
-            sqlite3_bind_int(sub_stmt, 1, id);
-            while (sqlite3_step(sub_stmt) == SQLITE_ROW) {
-                int sub_id = sqlite3_column_int(sub_stmt, 0);
-                const char* sub_name = (const char*)sqlite3_column_text(sub_stmt, 1);
-                printf("    └─ [%d] %s\n", sub_id, sub_name);
-            }
-            sqlite3_finalize(sub_stmt);
+    printf("\n--- 所有分类 ---\n");
+    printf("一级分类:\n");
+    for (int i = 0; i < tree->count; i++) {
+        const CategoryNode* node = &tree->nodes[i];
+        if (node->depth == 0) {
+            printf("  [%d] %s\n", node->id, node->name);
+        } else {
+            printf("    └─ [%d] %s\n", node->id, node->name);
         }
     }
-    sqlite3_finalize(stmt);
 }
 
 // 显示所有成员（供编辑/删除前参考）
 static void list_members(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
     printf("\n--- 当前成员列表 ---\n");
 
-    sqlite3_stmt* stmt;
-    const char* sql = "SELECT id, name FROM members ORDER BY id;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+    const DimList* members = dim_members();
+    if (!members) {
         printf("❌ 查询成员失败: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
         return;
     }
 
-    int count = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int id = sqlite3_column_int(stmt, 0);
-        const char* name = (const char*)sqlite3_column_text(stmt, 1);
-        printf("  [%d] %s\n", id, name ? name : "(无名)");
-        count++;
+    for (int i = 0; i < members->count; i++) {
+        const char* name = members->entries[i].name;
+        printf("  [%d] %s\n", members->entries[i].id, name[0] ? name : "(无名)");
     }
 
-    if (count == 0) {
+    if (members->count == 0) {
         printf("  （暂无成员）\n");
     }
-
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
 }
 
 // 显示所有账户（供编辑/删除前参考）
@@ -84,7 +70,7 @@ static void list_all_accounts(sqlite3* db) {
     printf("\n--- 当前账户列表 ---\n");
     sqlite3_stmt* stmt;
     const char* sql = "SELECT id, name, balance FROM accounts ORDER BY id;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+    if ((stmt = db_prepare(db, sql)) == NULL) {
         printf("❌ 查询账户失败\n");
         return;
     }
@@ -93,11 +79,12 @@ static void list_all_accounts(sqlite3* db) {
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         int id = sqlite3_column_int(stmt, 0);
         const char* name = (const char*)sqlite3_column_text(stmt, 1);
-        double balance = sqlite3_column_double(stmt, 2);
-        printf("  [%d] %s (余额: %.2f)\n", id, name, balance);
+        char balance[MONEY_BUF_SIZE];
+        format_money(sqlite3_column_int64(stmt, 2), balance, sizeof(balance));
+        printf("  [%d] %s (余额: %s)\n", id, name, balance);
         count++;
     }
-    sqlite3_finalize(stmt);
+    db_release(stmt);
 
     if (count == 0) {
         printf("  （暂无账户）\n");
@@ -108,10 +95,10 @@ static void list_all_accounts(sqlite3* db) {
 static int is_member_referenced(sqlite3* db, int member_id) {
     sqlite3_stmt* stmt;
     const char* sql = "SELECT 1 FROM records WHERE member_id = ? LIMIT 1;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) return 1;
+    if ((stmt = db_prepare(db, sql)) == NULL) return 1;
     sqlite3_bind_int(stmt, 1, member_id);
     int used = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    db_release(stmt);
     return used;
 }
 
@@ -124,11 +111,11 @@ static int is_account_referenced_or_nonzero(sqlite3* db, int account_id) {
         "UNION "
         "SELECT 1 FROM accounts WHERE id = ? AND balance != 0 "
         "LIMIT 1;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) return 1;
+    if ((stmt = db_prepare(db, sql)) == NULL) return 1;
     sqlite3_bind_int(stmt, 1, account_id);
     sqlite3_bind_int(stmt, 2, account_id);
     int used = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    db_release(stmt);
     return used;
 }
 
@@ -136,10 +123,10 @@ static int is_account_referenced_or_nonzero(sqlite3* db, int account_id) {
 static int is_category_referenced(sqlite3* db, int category_id) {
     sqlite3_stmt* stmt;
     const char* sql = "SELECT 1 FROM records WHERE category_id = ? LIMIT 1;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) return 1;
+    if ((stmt = db_prepare(db, sql)) == NULL) return 1;
     sqlite3_bind_int(stmt, 1, category_id);
     int used = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    db_release(stmt);
     return used;
 }
 
@@ -157,21 +144,21 @@ void add_member(void) {
         return; 
     }
 
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) return;
+    sqlite3* db = db_get();
+    if (!db) return;
     
     sqlite3_stmt* stmt;
     const char* sql = "INSERT INTO members (name) VALUES (?);";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+    if ((stmt = db_prepare(db, sql)) != NULL) {
         sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
         if (sqlite3_step(stmt) == SQLITE_DONE) {
+            dim_invalidate();
             printf("✅ 成员 \"%s\" 添加成功！\n", name);
         } else {
             printf("❌ 添加失败: %s\n", sqlite3_errmsg(db));
         }
-        sqlite3_finalize(stmt);
+        db_release(stmt);
     }
-    sqlite3_close(db);
 }
 
 void edit_member(void) {
@@ -190,48 +177,49 @@ void edit_member(void) {
         return; // 取消
     }
 
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) return;
+    sqlite3* db = db_get();
+    if (!db) return;
 
     // 检查是否存在
     sqlite3_stmt* check;
-    if (sqlite3_prepare_v2(db, "SELECT name FROM members WHERE id = ?;", -1, &check, NULL) != SQLITE_OK) {
-        sqlite3_close(db); return;
+    if ((check = db_prepare(db, "SELECT name FROM members WHERE id = ?;")) == NULL) {
+        return;
     }
     sqlite3_bind_int(check, 1, id);
     if (sqlite3_step(check) != SQLITE_ROW) {
         printf("❌ 成员 ID %d 不存在。\n", id);
-        sqlite3_finalize(check);
-        sqlite3_close(db);
+        db_release(check);
         return;
     }
-    const char* old_name = (const char*)sqlite3_column_text(check, 0);
-    sqlite3_finalize(check);
+    // 语句归还后列数据失效，先复制
+    char old_name[50] = {0};
+    const char* old_name_col = (const char*)sqlite3_column_text(check, 0);
+    if (old_name_col) strncpy(old_name, old_name_col, sizeof(old_name) - 1);
+    db_release(check);
 
     char new_name[50];
     printf("新姓名 [%s]: ", old_name);
-    if (fgets(new_name, sizeof(new_name), stdin) == NULL) { sqlite3_close(db); return; }
+    if (fgets(new_name, sizeof(new_name), stdin) == NULL) return;
     new_name[strcspn(new_name, "\n")] = 0;
 
     if (strlen(new_name) == 0) {
         printf("❌ 姓名不能为空。\n");
-        sqlite3_close(db);
         return;
     }
 
     sqlite3_stmt* stmt;
     const char* sql = "UPDATE members SET name = ? WHERE id = ?;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+    if ((stmt = db_prepare(db, sql)) != NULL) {
         sqlite3_bind_text(stmt, 1, new_name, -1, SQLITE_STATIC);
         sqlite3_bind_int(stmt, 2, id);
         if (sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0) {
+            dim_invalidate();
             printf("✅ 成员更新成功！\n");
         } else {
             printf("❌ 更新失败。\n");
         }
-        sqlite3_finalize(stmt);
+        db_release(stmt);
     }
-    sqlite3_close(db);
 }
 
 void delete_member(void) {
@@ -249,27 +237,26 @@ void delete_member(void) {
         return;
     }
 
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) return;
+    sqlite3* db = db_get();
+    if (!db) return;
 
     if (is_member_referenced(db, id)) {
         printf("❌ 无法删除：该成员已被财务记录引用。\n");
-        sqlite3_close(db);
         return;
     }
 
     sqlite3_stmt* stmt;
     const char* sql = "DELETE FROM members WHERE id = ?;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+    if ((stmt = db_prepare(db, sql)) != NULL) {
         sqlite3_bind_int(stmt, 1, id);
         if (sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db) > 0) {
+            dim_invalidate();
             printf("✅ 成员删除成功！\n");
         } else {
             printf("❌ 删除失败或成员不存在。\n");
         }
-        sqlite3_finalize(stmt);
+        db_release(stmt);
     }
-    sqlite3_close(db);
 }
 
 void manage_members(void) {
@@ -298,9 +285,9 @@ void manage_members(void) {
 
 // === 账户管理（类似，略作简化）===
 void add_account(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
@@ -310,46 +297,47 @@ void add_account(void) {
     char name[50];
     printf("\n输入新账户名称: ");
     if (fgets(name, sizeof(name), stdin) == NULL) {
-        sqlite3_close(db);
         return;
     }
     name[strcspn(name, "\n")] = 0;
     if (strlen(name) == 0) {
         printf("❌ 账户名称不能为空。\n");
-        sqlite3_close(db);
         return;
     }
 
-    double balance = 0.0;
+    int64_t balance = 0; // 分
     char buf[30];
     printf("输入初始余额（默认 0，可为负数）: ");
     if (fgets(buf, sizeof(buf), stdin) != NULL) {
         buf[strcspn(buf, "\n")] = 0;
-        if (strlen(buf) > 0) {
-            balance = atof(buf);
+        if (strlen(buf) > 0 && !parse_money(buf, &balance)) {
+            printf("❌ 余额格式无效（最多两位小数）。\n");
+            return;
         }
     }
+    char balance_text[MONEY_BUF_SIZE];
+    format_money(balance, balance_text, sizeof(balance_text));
 
     sqlite3_stmt* stmt;
-    const char* sql = "INSERT INTO accounts (name, balance) VALUES (?, ?);";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+    const char* sql = "INSERT INTO accounts (name, balance, opening_balance) VALUES (?1, ?2, ?2);";
+    if ((stmt = db_prepare(db, sql)) != NULL) {
         sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
-        sqlite3_bind_double(stmt, 2, balance);
+        sqlite3_bind_int64(stmt, 2, balance);
 
         if (sqlite3_step(stmt) == SQLITE_DONE) {
-            printf("✅ 账户 \"%s\" 添加成功！初始余额: %.2f\n", name, balance);
+            dim_invalidate();
+            printf("✅ 账户 \"%s\" 添加成功！初始余额: %s\n", name, balance_text);
         } else {
             printf("❌ 添加失败: %s\n", sqlite3_errmsg(db));
         }
-        sqlite3_finalize(stmt);
+        db_release(stmt);
     }
-    sqlite3_close(db);
 }
 
 void edit_account(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
@@ -360,11 +348,9 @@ void edit_account(void) {
     if (scanf("%d", &id) != 1) {
         int c; while ((c = getchar()) != '\n' && c != EOF);
         printf("❌ 请输入有效数字。\n");
-        sqlite3_close(db);
         return;
     }
     if (id == 0) {
-        sqlite3_close(db);
         return;
     }
     int c;
@@ -373,25 +359,24 @@ void edit_account(void) {
     // 检查是否存在
     sqlite3_stmt* check;
     const char* check_sql = "SELECT name, balance FROM accounts WHERE id = ?";
-    if (sqlite3_prepare_v2(db, check_sql, -1, &check, NULL) != SQLITE_OK) {
-        sqlite3_close(db);
+    if ((check = db_prepare(db, check_sql)) == NULL) {
         return;
     }
     sqlite3_bind_int(check, 1, id);
     if (sqlite3_step(check) != SQLITE_ROW) {
         printf("❌ 账户 ID %d 不存在。\n", id);
-        sqlite3_finalize(check);
-        sqlite3_close(db);
+        db_release(check);
         return;
     }
-    const char* old_name = (const char*)sqlite3_column_text(check, 0);
-    double old_balance = sqlite3_column_double(check, 1);
-    sqlite3_finalize(check);
+    char old_name[50] = {0};
+    const char* old_name_col = (const char*)sqlite3_column_text(check, 0);
+    if (old_name_col) strncpy(old_name, old_name_col, sizeof(old_name) - 1);
+    int64_t old_balance = sqlite3_column_int64(check, 1);
+    db_release(check);
 
     char new_name[50];
     printf("新名称 [%s]: ", old_name);
     if (fgets(new_name, sizeof(new_name), stdin) == NULL) {
-        sqlite3_close(db);
         return;
     }
     new_name[strcspn(new_name, "\n")] = 0;
@@ -400,54 +385,59 @@ void edit_account(void) {
     }
 
     char buf[30];
-    printf("新余额 [%.2f]: ", old_balance);
-    double new_balance = old_balance;
+    char old_balance_text[MONEY_BUF_SIZE];
+    format_money(old_balance, old_balance_text, sizeof(old_balance_text));
+    printf("新余额 [%s]: ", old_balance_text);
+    int64_t new_balance = old_balance;
     if (fgets(buf, sizeof(buf), stdin) != NULL) {
         buf[strcspn(buf, "\n")] = 0;
-        if (strlen(buf) > 0) {
-            new_balance = atof(buf);
+        if (strlen(buf) > 0 && !parse_money(buf, &new_balance)) {
+            printf("⚠️ 余额格式无效，保留原值 %s\n", old_balance_text);
+            new_balance = old_balance;
         }
     }
 
     // 检查重名（排除自己）
     sqlite3_stmt* unique;
     const char* unique_sql = "SELECT COUNT(*) FROM accounts WHERE name = ? AND id != ?";
-    if (sqlite3_prepare_v2(db, unique_sql, -1, &unique, NULL) == SQLITE_OK) {
+    if ((unique = db_prepare(db, unique_sql)) != NULL) {
         sqlite3_bind_text(unique, 1, new_name, -1, SQLITE_STATIC);
         sqlite3_bind_int(unique, 2, id);
         if (sqlite3_step(unique) == SQLITE_ROW) {
             if (sqlite3_column_int(unique, 0) > 0) {
                 printf("❌ 账户名称 \"%s\" 已存在。\n", new_name);
-                sqlite3_finalize(unique);
-                sqlite3_close(db);
+                db_release(unique);
                 return;
             }
         }
-        sqlite3_finalize(unique);
+        db_release(unique);
     }
 
     // 更新
     sqlite3_stmt* upd;
-    const char* update_sql = "UPDATE accounts SET name = ?, balance = ? WHERE id = ?";
-    if (sqlite3_prepare_v2(db, update_sql, -1, &upd, NULL) == SQLITE_OK) {
+    // 手工调整的差额计入期初，核对时不会被当成不一致改回去
+    const char* update_sql =
+        "UPDATE accounts SET name = ?, opening_balance = opening_balance + (?2 - balance), balance = ?2 "
+        "WHERE id = ?3";
+    if ((upd = db_prepare(db, update_sql)) != NULL) {
         sqlite3_bind_text(upd, 1, new_name, -1, SQLITE_STATIC);
-        sqlite3_bind_double(upd, 2, new_balance);
+        sqlite3_bind_int64(upd, 2, new_balance);
         sqlite3_bind_int(upd, 3, id);
 
         if (sqlite3_step(upd) == SQLITE_DONE) {
+            dim_invalidate();
             printf("✅ 账户更新成功！\n");
         } else {
             printf("❌ 更新失败: %s\n", sqlite3_errmsg(db));
         }
-        sqlite3_finalize(upd);
+        db_release(upd);
     }
-    sqlite3_close(db);
 }
 
 void delete_account(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
@@ -458,11 +448,9 @@ void delete_account(void) {
     if (scanf("%d", &id) != 1) {
         int c; while ((c = getchar()) != '\n' && c != EOF);
         printf("❌ 请输入有效数字。\n");
-        sqlite3_close(db);
         return;
     }
     if (id == 0) {
-        sqlite3_close(db);
         return;
     }
     int c;
@@ -471,52 +459,49 @@ void delete_account(void) {
     // 使用你已有的严格检查函数
     if (is_account_referenced_or_nonzero(db, id)) {
         printf("❌ 无法删除：该账户已被使用或余额非零。\n");
-        sqlite3_close(db);
         return;
     }
 
     // 获取名称用于确认
     sqlite3_stmt* name_stmt;
     const char* name_sql = "SELECT name FROM accounts WHERE id = ?";
-    if (sqlite3_prepare_v2(db, name_sql, -1, &name_stmt, NULL) != SQLITE_OK) {
-        sqlite3_close(db);
+    if ((name_stmt = db_prepare(db, name_sql)) == NULL) {
         return;
     }
     sqlite3_bind_int(name_stmt, 1, id);
     if (sqlite3_step(name_stmt) != SQLITE_ROW) {
         printf("❌ 账户不存在。\n");
-        sqlite3_finalize(name_stmt);
-        sqlite3_close(db);
+        db_release(name_stmt);
         return;
     }
-    const char* name = (const char*)sqlite3_column_text(name_stmt, 0);
-    sqlite3_finalize(name_stmt);
+    char name[50] = {0};
+    const char* name_col = (const char*)sqlite3_column_text(name_stmt, 0);
+    if (name_col) strncpy(name, name_col, sizeof(name) - 1);
+    db_release(name_stmt);
 
     printf("⚠️  确认删除账户 [%d] \"%s\"?(y/N): ", id, name);
     char confirm[10];
     if (fgets(confirm, sizeof(confirm), stdin) == NULL) {
-        sqlite3_close(db);
         return;
     }
 
     if (confirm[0] != 'y' && confirm[0] != 'Y') {
         printf("取消删除。\n");
-        sqlite3_close(db);
         return;
     }
 
     sqlite3_stmt* del;
     const char* del_sql = "DELETE FROM accounts WHERE id = ?";
-    if (sqlite3_prepare_v2(db, del_sql, -1, &del, NULL) == SQLITE_OK) {
+    if ((del = db_prepare(db, del_sql)) != NULL) {
         sqlite3_bind_int(del, 1, id);
         if (sqlite3_step(del) == SQLITE_DONE) {
+            dim_invalidate();
             printf("✅ 账户删除成功！\n");
         } else {
             printf("❌ 删除失败: %s\n", sqlite3_errmsg(db));
         }
-        sqlite3_finalize(del);
+        db_release(del);
     }
-    sqlite3_close(db);
 }
 
 void manage_accounts(void) {
@@ -564,13 +549,13 @@ void manage_accounts(void) {
 // === 分类管理（较复杂，支持父子）===
 void add_category(void) {
     
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
-    list_all_categories(db);//添加分类时先实现已有的分类
+    list_all_categories();//添加分类时先实现已有的分类
 
     char type_str[20] = {0};
 
@@ -616,25 +601,23 @@ void add_category(void) {
 
     int parent_id = 0;
     if (yn[0] == 'y' || yn[0] == 'Y') {
-        // 显示一级分类供选择
-        sqlite3_stmt* p_stmt;
-        const char* p_sql = "SELECT id, name FROM categories WHERE type = ? AND parent_id IS NULL;";
-        if (sqlite3_prepare_v2(db, p_sql, -1, &p_stmt, NULL) != SQLITE_OK) {
-            sqlite3_close(db); return;
-        }
-        sqlite3_bind_text(p_stmt, 1, type_str, -1, SQLITE_STATIC);
+        // 显示同类型的一级分类供选择
+        const CategoryTree* tree = category_tree_get();
+        if (!tree) return;
+        int* ids = malloc(sizeof(int) * (tree->count > 0 ? tree->count : 1));
+        if (!ids) return;
         printf("【父分类列表】\n");
         int count = 0;
-        int ids[100];
-        while (sqlite3_step(p_stmt) == SQLITE_ROW) {
-            ids[count] = sqlite3_column_int(p_stmt, 0);
-            printf("%d. %s\n", ++count, sqlite3_column_text(p_stmt, 1));
+        for (int i = 0; i < tree->count; i++) {
+            const CategoryNode* node = &tree->nodes[i];
+            if (node->depth != 0 || strcmp(node->type, type_str) != 0) continue;
+            ids[count] = node->id;
+            printf("%d. %s\n", ++count, node->name);
         }
-        sqlite3_finalize(p_stmt);
 
         if (count == 0) {
             printf("❌ 无可用父分类，请先添加一级分类。\n");
-            sqlite3_close(db);
+            free(ids);
             return;
         }
 
@@ -642,11 +625,12 @@ void add_category(void) {
         int choice;
         if (scanf("%d", &choice) != 1 || choice < 1 || choice > count) {
             while(getchar()!='\n');
-            sqlite3_close(db);
+            free(ids);
             return;
         }
         getchar();
         parent_id = ids[choice - 1];
+        free(ids);
     }
 
     sqlite3_stmt* stmt;
@@ -654,7 +638,7 @@ void add_category(void) {
         "INSERT INTO categories (name, parent_id, type) VALUES (?, ?, ?);" :
         "INSERT INTO categories (name, type) VALUES (?, ?);";
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+    if ((stmt = db_prepare(db, sql)) != NULL) {
         sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
         if (parent_id) {
             sqlite3_bind_int(stmt, 2, parent_id);
@@ -663,30 +647,29 @@ void add_category(void) {
             sqlite3_bind_text(stmt, 2, type_str, -1, SQLITE_STATIC);
         }
         if (sqlite3_step(stmt) == SQLITE_DONE) {
+            dim_invalidate();
             printf("✅ 分类 \"%s\" 添加成功！\n", name);
         } else {
             printf("❌ 添加失败: %s\n", sqlite3_errmsg(db));
         }
-        sqlite3_finalize(stmt);
+        db_release(stmt);
     }
-    sqlite3_close(db);
 }
 
 //编辑分类
 void edit_category(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
-    list_all_categories(db);
+    list_all_categories();
 
     printf("\n请输入要编辑的分类 ID: ");
     int id;
     if (scanf("%d", &id) != 1 || id <= 0) {
         printf("❌ 无效 ID\n");
-        sqlite3_close(db);
         return;
     }
     getchar(); // 清除换行
@@ -694,28 +677,27 @@ void edit_category(void) {
     // 检查分类是否存在
     sqlite3_stmt* check;
     const char* check_sql = "SELECT name, parent_id FROM categories WHERE id = ?";
-    if (sqlite3_prepare_v2(db, check_sql, -1, &check, NULL) != SQLITE_OK) {
+    if ((check = db_prepare(db, check_sql)) == NULL) {
         printf("❌ 查询分类失败\n");
-        sqlite3_close(db);
         return;
     }
     sqlite3_bind_int(check, 1, id);
     if (sqlite3_step(check) != SQLITE_ROW) {
         printf("❌ 分类不存在\n");
-        sqlite3_finalize(check);
-        sqlite3_close(db);
+        db_release(check);
         return;
     }
 
-    const char* old_name = (const char*)sqlite3_column_text(check, 0);
+    char old_name[50] = {0};
+    const char* old_name_col = (const char*)sqlite3_column_text(check, 0);
+    if (old_name_col) strncpy(old_name, old_name_col, sizeof(old_name) - 1);
     int parent_id = sqlite3_column_int(check, 1);
-    sqlite3_finalize(check);
+    db_release(check);
 
     printf("当前名称: %s\n", old_name);
     printf("请输入新名称（直接回车保持不变）: ");
     char new_name[50];
     if (fgets(new_name, sizeof(new_name), stdin) == NULL) {
-        sqlite3_close(db);
         return;
     }
     new_name[strcspn(new_name, "\n")] = 0;
@@ -726,7 +708,6 @@ void edit_category(void) {
 
     if (strlen(new_name) > 30) {
         printf("❌ 名称过长（最多30字符）\n");
-        sqlite3_close(db);
         return;
     }
 
@@ -734,9 +715,8 @@ void edit_category(void) {
     sqlite3_stmt* unique_check;
     const char* unique_sql = 
         "SELECT COUNT(*) FROM categories WHERE name = ? AND parent_id = ? AND id != ?";
-    if (sqlite3_prepare_v2(db, unique_sql, -1, &unique_check, NULL) != SQLITE_OK) {
+    if ((unique_check = db_prepare(db, unique_sql)) == NULL) {
         printf("❌ 检查重名失败\n");
-        sqlite3_close(db);
         return;
     }
     sqlite3_bind_text(unique_check, 1, new_name, -1, SQLITE_STATIC);
@@ -746,49 +726,46 @@ void edit_category(void) {
     if (sqlite3_step(unique_check) == SQLITE_ROW) {
         if (sqlite3_column_int(unique_check, 0) > 0) {
             printf("❌ 同级分类中已存在同名项\n");
-            sqlite3_finalize(unique_check);
-            sqlite3_close(db);
+            db_release(unique_check);
             return;
         }
     }
-    sqlite3_finalize(unique_check);
+    db_release(unique_check);
 
     // 执行更新
     sqlite3_stmt* upd;
     const char* update_sql = "UPDATE categories SET name = ? WHERE id = ?";
-    if (sqlite3_prepare_v2(db, update_sql, -1, &upd, NULL) != SQLITE_OK) {
+    if ((upd = db_prepare(db, update_sql)) == NULL) {
         printf("❌ 准备更新失败\n");
-        sqlite3_close(db);
         return;
     }
     sqlite3_bind_text(upd, 1, new_name, -1, SQLITE_STATIC);
     sqlite3_bind_int(upd, 2, id);
 
     if (sqlite3_step(upd) == SQLITE_DONE) {
+        dim_invalidate();
         printf("✅ 分类修改成功！\n");
     } else {
         printf("❌ 修改失败: %s\n", sqlite3_errmsg(db));
     }
 
-    sqlite3_finalize(upd);
-    sqlite3_close(db);
+    db_release(upd);
 }
 
 //删除分类
 void delete_category(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
-    list_all_categories(db);
+    list_all_categories();
 
     printf("\n请输入要删除的分类 ID: ");
     int id;
     if (scanf("%d", &id) != 1 || id <= 0) {
         printf("❌ 无效 ID\n");
-        sqlite3_close(db);
         return;
     }
     getchar();
@@ -796,42 +773,29 @@ void delete_category(void) {
     // 检查是否存在
     sqlite3_stmt* check;
     const char* check_sql = "SELECT name, parent_id FROM categories WHERE id = ?";
-    if (sqlite3_prepare_v2(db, check_sql, -1, &check, NULL) != SQLITE_OK) {
+    if ((check = db_prepare(db, check_sql)) == NULL) {
         printf("❌ 查询失败\n");
-        sqlite3_close(db);
         return;
     }
     sqlite3_bind_int(check, 1, id);
     if (sqlite3_step(check) != SQLITE_ROW) {
         printf("❌ 分类不存在\n");
-        sqlite3_finalize(check);
-        sqlite3_close(db);
+        db_release(check);
         return;
     }
 
-    const char* name = (const char*)sqlite3_column_text(check, 0);
+    char name[50] = {0};
+    const char* name_col = (const char*)sqlite3_column_text(check, 0);
+    if (name_col) strncpy(name, name_col, sizeof(name) - 1);
     int parent_id = sqlite3_column_int(check, 1);
     int is_top_level = (parent_id == 0 || parent_id == -1 || sqlite3_column_type(check, 1) == SQLITE_NULL);
-    sqlite3_finalize(check);
+    db_release(check);
 
-    // 检查是否被财务记录引用
-    sqlite3_stmt* ref_check;
-    const char* ref_sql = "SELECT COUNT(*) FROM records WHERE category_id = ?";
-    if (sqlite3_prepare_v2(db, ref_sql, -1, &ref_check, NULL) != SQLITE_OK) {
-        printf("❌ 检查引用失败\n");
-        sqlite3_close(db);
-        return;
-    }
-    sqlite3_bind_int(ref_check, 1, id);
-    int has_ref = 0;
-    if (sqlite3_step(ref_check) == SQLITE_ROW) {
-        has_ref = sqlite3_column_int(ref_check, 0) > 0;
-    }
-    sqlite3_finalize(ref_check);
+    // 检查是否被财务记录引用（走 idx_records_category，命中一条即停）
+    int has_ref = is_category_referenced(db, id);
 
     if (has_ref) {
         printf("❌ 无法删除：该分类已被财务记录使用！\n");
-        sqlite3_close(db);
         return;
     }
 
@@ -839,51 +803,47 @@ void delete_category(void) {
     if (is_top_level) {
         sqlite3_stmt* child_check;
         const char* child_sql = "SELECT COUNT(*) FROM categories WHERE parent_id = ?";
-        if (sqlite3_prepare_v2(db, child_sql, -1, &child_check, NULL) == SQLITE_OK) {
+        if ((child_check = db_prepare(db, child_sql)) != NULL) {
             sqlite3_bind_int(child_check, 1, id);
             if (sqlite3_step(child_check) == SQLITE_ROW) {
                 if (sqlite3_column_int(child_check, 0) > 0) {
                     printf("❌ 无法删除：该一级分类下还有子分类！请先删除子分类。\n");
-                    sqlite3_finalize(child_check);
-                    sqlite3_close(db);
+                    db_release(child_check);
                     return;
                 }
             }
-            sqlite3_finalize(child_check);
+            db_release(child_check);
         }
     }
 
     printf("确认删除分类 [%d] \"%s\"？(y/N): ", id, name);
     char confirm[10];
     if (fgets(confirm, sizeof(confirm), stdin) == NULL) {
-        sqlite3_close(db);
         return;
     }
 
     if (confirm[0] != 'y' && confirm[0] != 'Y') {
         printf("取消删除。\n");
-        sqlite3_close(db);
         return;
     }
 
     // 执行删除
     sqlite3_stmt* del;
     const char* del_sql = "DELETE FROM categories WHERE id = ?";
-    if (sqlite3_prepare_v2(db, del_sql, -1, &del, NULL) != SQLITE_OK) {
+    if ((del = db_prepare(db, del_sql)) == NULL) {
         printf("❌ 删除失败\n");
-        sqlite3_close(db);
         return;
     }
     sqlite3_bind_int(del, 1, id);
 
     if (sqlite3_step(del) == SQLITE_DONE) {
+        dim_invalidate();
         printf("✅ 分类删除成功！\n");
     } else {
         printf("❌ 删除失败: %s\n", sqlite3_errmsg(db));
     }
 
-    sqlite3_finalize(del);
-    sqlite3_close(db);
+    db_release(del);
 }
 
 void manage_categories(void) {
@@ -915,9 +875,9 @@ void manage_categories(void) {
 }
 
 void change_password(void) {
-    sqlite3* db;
-    if (sqlite3_open(DATABASE_NAME, &db) != SQLITE_OK) {
-        printf("❌ 无法打开数据库。\n");
+    sqlite3* db = db_get();
+    if (!db) {
+        printf("❌ 数据库未打开。\n");
         return;
     }
 
@@ -936,7 +896,6 @@ void change_password(void) {
     }
 
     if (!verified) {
-        sqlite3_close(db);
         printf("❌ 验证失败，退出密码修改。\n");
         return;
     }
@@ -944,46 +903,168 @@ void change_password(void) {
     // === 输入新密码 ===
     char* new_pwd1 = getpass("请输入新密码（至少6位）: ");
     if (!new_pwd1 || strlen(new_pwd1) < 6) {
-        sqlite3_close(db);
         printf("❌ 新密码至少需要6位。\n");
         return;
     }
 
     char* new_pwd2 = getpass("请再次输入新密码: ");
     if (!new_pwd2 || strcmp(new_pwd1, new_pwd2) != 0) {
-        sqlite3_close(db);
         printf("❌ 两次输入的新密码不一致！\n");
         return;
     }
 
-    // === 生成新盐和新哈希 ===
-    char new_salt[17];
-    generate_salt(new_salt);  // ← 你的函数
+    // === 新盐 + 当前迭代次数 ===
+    if (auth_set_password(db, new_pwd1)) {
+        printf("✅ 密码修改成功！下次登录请使用新密码。\n");
+    } else {
+        printf("❌ 更新密码失败。\n");
+    }
+}
+
+// === 数据库状态（语句缓存命中情况）===
+void show_database_status(void) {
+    StmtCacheStats stats;
+    db_stmt_cache_stats(&stats);
 
-    char new_hash[65];
-    hash_password(new_pwd1, new_salt, new_hash); // ← 你的函数
+    long total = stats.hits + stats.misses;
+    printf("\n--- 数据库状态 ---\n");
+    printf("数据库文件: %s\n", DATABASE_NAME);
+    printf("性能配置: %s\n", db_profile_spec(db_current_profile())->name);
 
-    // === 更新数据库 ===
+    sqlite3* db = db_get();
     sqlite3_stmt* stmt;
-    const char* sql = "UPDATE admin SET password_hash = ?, salt = ? WHERE id = 1;";
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        sqlite3_close(db);
-        printf("❌ 准备更新语句失败。\n");
+    if (db && (stmt = db_prepare(db, "PRAGMA journal_mode;")) != NULL) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            printf("日志模式: %s\n", sqlite3_column_text(stmt, 0));
+        }
+        db_release(stmt);
+    }
+    printf("报表引擎: %s", report_engine_name(report_engine_current()));
+    if (report_engine_current() == REPORT_ENGINE_PARALLEL) {
+        printf("（%d 个线程%s）", parallel_threads_effective(), parallel_threads_setting() == 0 ? "，自动" : "");
+    }
+    printf("\n");
+    printf("SHA-256 实现: %s\n", sha256_impl_name(sha256_impl_current()));
+    printf("已缓存语句: %d 条\n", stats.cached);
+    printf("缓存命中: %ld 次，未命中: %ld 次", stats.hits, stats.misses);
+    if (total > 0) {
+        printf("（命中率 %.1f%%）", stats.hits * 100.0 / total);
+    }
+    printf("\n");
+}
+
+// === 性能配置（PRAGMA 组合）===
+void select_performance_profile(void) {
+    int current = db_current_profile();
+
+    printf("\n--- 性能配置 ---\n");
+    for (int i = 0; i < DB_PROFILE_COUNT; i++) {
+        const DbProfileSpec* p = db_profile_spec(i);
+        printf("%d. %s%s\n", i + 1, p->name, i == current ? "  ← 当前" : "");
+        printf("   journal_mode=%s, synchronous=%s, cache=%d KiB, mmap=%lld MiB, temp_store=%s\n",
+               p->journal_mode, p->synchronous, p->cache_size_kb,
+               p->mmap_size / (1024 * 1024), p->temp_store);
+    }
+
+    int choice;
+    printf("请选择 (1-%d，0 取消): ", DB_PROFILE_COUNT);
+    if (scanf("%d", &choice) != 1) {
+        int c; while ((c = getchar()) != '\n' && c != EOF);
+        printf("❌ 请输入有效数字。\n");
         return;
     }
+    getchar();
 
-    sqlite3_bind_text(stmt, 1, new_hash, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, new_salt, -1, SQLITE_STATIC);
+    if (choice == 0) return;
+    if (choice < 1 || choice > DB_PROFILE_COUNT) {
+        printf("❌ 无效选项。\n");
+        return;
+    }
 
-    if (sqlite3_step(stmt) == SQLITE_DONE) {
-        printf("✅ 密码修改成功！下次登录请使用新密码。\n");
+    if (db_set_profile(choice - 1)) {
+        printf("✅ 已切换为: %s\n", db_profile_spec(choice - 1)->name);
     } else {
-        printf("❌ 更新密码失败: %s\n", sqlite3_errmsg(db));
+        printf("❌ 切换失败: %s\n", sqlite3_errmsg(db_get()));
+    }
+}
+
+// === 报表引擎 ===
+void select_report_engine(void) {
+    int current = report_engine_current();
+
+    printf("\n--- 报表引擎 ---\n");
+    for (int i = 0; i < REPORT_ENGINE_COUNT; i++) {
+        printf("%d. %s%s\n", i + 1, report_engine_name(i), i == current ? "  ← 当前" : "");
     }
+    printf("   列式快照首次使用时把全部记录载入内存（约 27 字节/条），之后按修改增量刷新\n");
+    printf("   并行扫描不占额外内存，每次报表由多个线程各用一个只读连接分段扫描全部记录\n");
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+    int choice;
+    printf("请选择 (1-%d，0 取消): ", REPORT_ENGINE_COUNT);
+    if (scanf("%d", &choice) != 1) {
+        int c; while ((c = getchar()) != '\n' && c != EOF);
+        printf("❌ 请输入有效数字。\n");
+        return;
+    }
+    getchar();
 
+    if (choice == 0) return;
+    if (choice < 1 || choice > REPORT_ENGINE_COUNT) {
+        printf("❌ 无效选项。\n");
+        return;
+    }
+
+    if (!report_engine_set(choice - 1)) {
+        printf("❌ 切换失败: %s\n", sqlite3_errmsg(db_get()));
+        return;
+    }
+    printf("✅ 已切换为: %s\n", report_engine_name(choice - 1));
+    if (choice - 1 != REPORT_ENGINE_PARALLEL) return;
+
+    int threads;
+    printf("工作线程数 (1-%d，0 按 CPU 核数自动，当前 %d): ", PARALLEL_MAX_THREADS, parallel_threads_setting());
+    if (scanf("%d", &threads) != 1) {
+        int c; while ((c = getchar()) != '\n' && c != EOF);
+        printf("❌ 请输入有效数字，线程数未修改。\n");
+        return;
+    }
+    getchar();
+    if (parallel_threads_set(threads)) {
+        printf("✅ 工作线程数: %d\n", parallel_threads_effective());
+    } else {
+        printf("❌ 线程数须在 0～%d 之间，未修改。\n", PARALLEL_MAX_THREADS);
+    }
+}
+
+// === 密码强度校准 ===
+// 实测本机 PBKDF2 速度，选出使一次登录验证约 KDF_TARGET_MS 的迭代次数；
+// 已保存的密码在下次登录成功时按新次数重新哈希
+void calibrate_password_cost(void) {
+    printf("⏳ 正在测量本机哈希速度...\n");
+    double rate = 0;
+    uint32_t suggested = kdf_calibrate(KDF_TARGET_MS, &rate);
+    uint32_t current = auth_kdf_iterations();
+
+    printf("SHA-256 实现: %s\n", sha256_impl_name(sha256_impl_current()));
+    printf("PBKDF2 速度: 约 %.0f 次迭代/秒\n", rate);
+    printf("当前迭代次数: %u（验证约 %.0f 毫秒）\n", current, rate > 0 ? current * 1000.0 / rate : 0.0);
+    printf("建议迭代次数: %u（目标 %.0f 毫秒，下限 %d）\n", suggested, KDF_TARGET_MS, KDF_MIN_ITERATIONS);
+    if (suggested == current) {
+        printf("✅ 当前设置已合适。\n");
+        return;
+    }
+
+    char input[10];
+    printf("是否采用建议值？(y/N): ");
+    if (fgets(input, sizeof(input), stdin) == NULL || (input[0] != 'y' && input[0] != 'Y')) {
+        printf("已取消。\n");
+        return;
+    }
+    if (db_set_setting_int("kdf_iterations", (int)suggested)) {
+        printf("✅ 已保存，下次登录成功后密码将按新次数重新哈希。\n");
+    } else {
+        printf("❌ 保存失败。\n");
+    }
 }
 
 // === 主设置菜单 ===
@@ -996,6 +1077,13 @@ void show_settings_menu(void) {
         printf("2. 账户管理\n");
         printf("3. 分类管理\n");
         printf("4. 修改密码\n");
+        printf("5. 数据库状态\n");
+        printf("6. 性能配置\n");
+        printf("7. 重建统计汇总\n");
+        printf("8. 报表引擎\n");
+        printf("9. 重建备注索引\n");
+        printf("10. 核对账户余额\n");
+        printf("11. 密码强度校准\n");
         printf("0. 返回主菜单\n");
         printf("请选择: ");
         if (scanf("%d", &choice) != 1) { while(getchar()!='\n'); continue; }
@@ -1006,6 +1094,13 @@ void show_settings_menu(void) {
             case 2: manage_accounts(); break;
             case 3: manage_categories(); break;
             case 4: change_password(); break;
+            case 5: show_database_status(); break;
+            case 6: select_performance_profile(); break;
+            case 7: rebuild_rollups_menu(); break;
+            case 8: select_report_engine(); break;
+            case 9: rebuild_search_index_menu(); break;
+            case 10: reconcile_balances_menu(); break;
+            case 11: calibrate_password_cost(); break;
             case 0: return;
             default: printf("无效选项。\n");
         }
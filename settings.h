@@ -25,4 +25,10 @@ void delete_category(void);
 // 密码
 void change_password(void);
 
+// 数据库状态与性能配置
+void show_database_status(void);
+void select_performance_profile(void);
+void select_report_engine(void);
+void calibrate_password_cost(void);
+
 #endif
\ No newline at end of file
@@ -2,6 +2,12 @@
 #include <stdint.h>
 #include "sha256.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_X86 1
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
 static const uint32_t k[64] = {
     0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
     0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
@@ -23,44 +29,151 @@ static const uint32_t k[64] = {
 #define SIG0(x) (ROTRIGHT(x,7) ^ ROTRIGHT(x,18) ^ ((x) >> 3))
 #define SIG1(x) (ROTRIGHT(x,17) ^ ROTRIGHT(x,19) ^ ((x) >> 10))
 
-void sha256_transform(SHA256_CTX *ctx, const uint8_t data[]) {
+// 压缩函数：连续处理 blocks 个 64 字节块（data 无对齐要求）
+typedef void (*Sha256BlocksFn)(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+// === 可移植版本（所有平台）===
+static void sha256_blocks_portable(uint32_t state[8], const uint8_t* data, size_t blocks) {
     uint32_t a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
 
-    for (i = 0, j = 0; i < 16; ++i, j += 4)
-        m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
-    for ( ; i < 64; ++i)
-        m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
-
-    a = ctx->state[0];
-    b = ctx->state[1];
-    c = ctx->state[2];
-    d = ctx->state[3];
-    e = ctx->state[4];
-    f = ctx->state[5];
-    g = ctx->state[6];
-    h = ctx->state[7];
-
-    for (i = 0; i < 64; ++i) {
-        t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
-        t2 = EP0(a) + MAJ(a,b,c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
+    for ( ; blocks > 0; blocks--, data += 64) {
+        for (i = 0, j = 0; i < 16; ++i, j += 4)
+            m[i] = ((uint32_t)data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+        for ( ; i < 64; ++i)
+            m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+        f = state[5];
+        g = state[6];
+        h = state[7];
+
+        for (i = 0; i < 64; ++i) {
+            t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
+            t2 = EP0(a) + MAJ(a,b,c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
     }
+}
 
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
+#ifdef SHA256_X86
+// === SHA-NI 版本 ===
+// 状态按指令要求重排为 ABEF / CDGH 两个向量；每 4 轮消息 W 由 msg1/msg2 从前 4 组推出
+__attribute__((target("sha,sse4.1")))
+static void sha256_blocks_shani(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128((const __m128i*)&state[0]);          // DCBA
+    __m128i state1 = _mm_loadu_si128((const __m128i*)&state[4]);       // HGFE
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);                                 // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);                           // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);                   // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);                        // CDGH
+
+    for ( ; blocks > 0; blocks--, data += 64) {
+        __m128i abef_save = state0, cdgh_save = state1;
+        __m128i w[4];
+
+        for (int i = 0; i < 16; i++) {
+            __m128i msg;
+            if (i < 4) {
+                msg = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i * 16)), byte_swap);
+            } else {
+                // W[i] = msg2(msg1(W[i-4], W[i-3]) + W[i-2..i-1] 错位拼接, W[i-1])
+                msg = _mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]);
+                msg = _mm_add_epi32(msg, _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+                msg = _mm_sha256msg2_epu32(msg, w[(i + 3) & 3]);
+            }
+            w[i & 3] = msg;
+
+            msg = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i*)&k[i * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);                              // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);                           // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);                        // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);                           // HGFE
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+static int cpu_has_shani(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1)) return 0;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+    return (ebx & (1u << 29)) != 0;     // CPUID.(EAX=7,ECX=0):EBX.SHA[bit 29]
+}
+#endif
+
+// === 运行时分派 ===
+static const char* const impl_names[SHA256_IMPL_COUNT] = { "可移植", "SHA-NI" };
+
+static const Sha256BlocksFn impl_blocks[SHA256_IMPL_COUNT] = {
+    sha256_blocks_portable,
+#ifdef SHA256_X86
+    sha256_blocks_shani,
+#else
+    sha256_blocks_portable,
+#endif
+};
+
+static int current_impl = -1;
+
+const char* sha256_impl_name(int impl) {
+    return (impl >= 0 && impl < SHA256_IMPL_COUNT) ? impl_names[impl] : "?";
+}
+
+int sha256_impl_supported(int impl) {
+    switch (impl) {
+    case SHA256_IMPL_PORTABLE: return 1;
+#ifdef SHA256_X86
+    case SHA256_IMPL_SHANI: return cpu_has_shani();
+#endif
+    default: return 0;
+    }
+}
+
+int sha256_impl_current(void) {
+    if (current_impl < 0) {
+        current_impl = sha256_impl_supported(SHA256_IMPL_SHANI) ? SHA256_IMPL_SHANI : SHA256_IMPL_PORTABLE;
+    }
+    return current_impl;
+}
+
+int sha256_impl_set(int impl) {
+    if (!sha256_impl_supported(impl)) return 0;
+    current_impl = impl;
+    return 1;
+}
+
+static void sha256_transform(SHA256_CTX *ctx, const uint8_t data[]) {
+    impl_blocks[sha256_impl_current()](ctx->state, data, 1);
 }
 
 void sha256_init(SHA256_CTX *ctx) {
@@ -76,18 +189,33 @@ void sha256_init(SHA256_CTX *ctx) {
     ctx->state[7] = 0x5be0cd19;
 }
 
+// 先补满缓冲区中的残块，整块直接从输入批量压缩，剩余不足一块的字节留到下次
 void sha256_update(SHA256_CTX *ctx, const uint8_t data[], size_t len) {
-    size_t i;
-
-    for (i = 0; i < len; ++i) {
-        ctx->data[ctx->datalen] = data[i];
-        ctx->datalen++;
-        if (ctx->datalen == 64) {
-            sha256_transform(ctx, ctx->data);
-            ctx->bitlen += 512;
-            ctx->datalen = 0;
-        }
+    Sha256BlocksFn blocks_fn = impl_blocks[sha256_impl_current()];
+
+    if (ctx->datalen > 0) {
+        size_t take = 64 - ctx->datalen;
+        if (take > len) take = len;
+        memcpy(ctx->data + ctx->datalen, data, take);
+        ctx->datalen += (uint32_t)take;
+        data += take;
+        len -= take;
+        if (ctx->datalen < 64) return;
+        blocks_fn(ctx->state, ctx->data, 1);
+        ctx->bitlen += 512;
+        ctx->datalen = 0;
+    }
+
+    size_t blocks = len / 64;
+    if (blocks > 0) {
+        blocks_fn(ctx->state, data, blocks);
+        ctx->bitlen += (uint64_t)blocks * 512;
+        data += blocks * 64;
+        len -= blocks * 64;
     }
+
+    memcpy(ctx->data, data, len);
+    ctx->datalen = (uint32_t)len;
 }
 
 void sha256_final(SHA256_CTX *ctx, uint8_t hash[]) {
@@ -135,4 +263,55 @@ void sha256(const uint8_t data[], size_t len, uint8_t hash[]) {
     sha256_init(&ctx);
     sha256_update(&ctx, data, len);
     sha256_final(&ctx, hash);
-}
\ No newline at end of file
+}
+
+// === 已知答案测试 ===
+typedef struct {
+    const char* message;
+    long repeat;            // message 重复次数
+    const char* digest;     // 十六进制
+} Sha256Vector;
+
+static const Sha256Vector sha256_vectors[] = {
+    { "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+      1, "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+    // 100 万个 'a'：分别按 40 字节与逐字节喂入，覆盖跨块缓冲
+    { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 25000,
+      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+    { "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+};
+
+static int check_vector(const Sha256Vector* v) {
+    SHA256_CTX ctx;
+    uint8_t hash[SHA256_BLOCK_SIZE];
+    char hex[SHA256_BLOCK_SIZE * 2 + 1];
+    size_t len = strlen(v->message);
+
+    sha256_init(&ctx);
+    for (long r = 0; r < v->repeat; r++) sha256_update(&ctx, (const uint8_t*)v->message, len);
+    sha256_final(&ctx, hash);
+
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        static const char digits[] = "0123456789abcdef";
+        hex[i * 2] = digits[hash[i] >> 4];
+        hex[i * 2 + 1] = digits[hash[i] & 0x0f];
+    }
+    hex[SHA256_BLOCK_SIZE * 2] = '\0';
+    return strcmp(hex, v->digest) == 0;
+}
+
+int sha256_self_test(void) {
+    int saved = sha256_impl_current();
+    int ok = 1;
+    size_t count = sizeof(sha256_vectors) / sizeof(sha256_vectors[0]);
+    for (int impl = 0; ok && impl < SHA256_IMPL_COUNT; impl++) {
+        if (!sha256_impl_set(impl)) continue;
+        for (size_t i = 0; ok && i < count; i++) ok = check_vector(&sha256_vectors[i]);
+    }
+    sha256_impl_set(saved);
+    return ok;
+}
@@ -19,4 +19,18 @@ void sha256_update(SHA256_CTX *ctx, const uint8_t data[], size_t len);
 void sha256_final(SHA256_CTX *ctx, uint8_t hash[]);
 void sha256(const uint8_t data[], size_t len, uint8_t hash[]);
 
-#endif
\ No newline at end of file
+// 压缩函数实现：运行时检测 CPU，支持 SHA 扩展（SHA-NI）时使用硬件指令，否则走可移植版本
+#define SHA256_IMPL_PORTABLE 0
+#define SHA256_IMPL_SHANI    1
+#define SHA256_IMPL_COUNT    2
+
+const char* sha256_impl_name(int impl);
+int sha256_impl_supported(int impl);
+int sha256_impl_current(void);
+// 指定实现（基准测试用）；不支持时返回 0 且不改变
+int sha256_impl_set(int impl);
+
+// 已知答案测试（FIPS 180-2 向量），逐个检查本机支持的实现，全部通过返回 1
+int sha256_self_test(void);
+
+#endif
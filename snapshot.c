@@ -0,0 +1,275 @@
+// snapshot.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sqlite3.h"
+#include "db.h"
+#include "rollup.h"
+#include "agg.h"
+#include "date.h"
+#include "snapshot.h"
+#include "parallel.h"
+
+static const char* const engine_names[REPORT_ENGINE_COUNT] = {
+    "汇总表（触发器维护）",
+    "内存列式快照",
+    "多线程并行扫描",
+};
+
+const char* report_engine_name(int engine) {
+    if (engine < 0 || engine >= REPORT_ENGINE_COUNT) engine = REPORT_ENGINE_ROLLUP;
+    return engine_names[engine];
+}
+
+int report_engine_current(void) {
+    int engine = db_get_setting_int("report_engine", REPORT_ENGINE_ROLLUP);
+    return (engine >= 0 && engine < REPORT_ENGINE_COUNT) ? engine : REPORT_ENGINE_ROLLUP;
+}
+
+int report_engine_set(int engine) {
+    if (engine < 0 || engine >= REPORT_ENGINE_COUNT) return 0;
+    if (engine != REPORT_ENGINE_SNAPSHOT) snapshot_reset();   // 释放内存
+    if (engine != REPORT_ENGINE_PARALLEL) parallel_reset();   // 关闭只读连接
+    return db_set_setting_int("report_engine", engine);
+}
+
+// === 快照 ===
+static RecordSnapshot snap;
+static int loaded;
+static int seen_changes;            // sqlite3_total_changes（本连接的写入）
+static int seen_data_version;       // PRAGMA data_version（其他连接的提交）
+static char watermark[20];          // 上次刷新开始时的 datetime('now', 'localtime')
+static int warned;
+static int failed;                  // 上次载入失败（数据不适合快照），数据未变前不再重试
+
+#define SNAPSHOT_SELECT \
+    "SELECT rowid, day, amount, type, category_id, account_id, COALESCE(member_id, 0) FROM records "
+
+void snapshot_reset(void) {
+    free(snap.rowid);
+    free(snap.day);
+    free(snap.cents);
+    free(snap.type);
+    free(snap.category);
+    free(snap.account);
+    free(snap.member);
+    memset(&snap, 0, sizeof(snap));
+    loaded = 0;
+    failed = 0;
+}
+
+static int snapshot_reserve(long need) {
+    if (need <= snap.cap) return 1;
+    long cap = snap.cap ? snap.cap : 4096;
+    while (cap < need) cap *= 2;
+#define GROW(field) do { \
+        void* p = realloc(snap.field, sizeof(*snap.field) * cap); \
+        if (!p) return 0; \
+        snap.field = p; \
+    } while (0)
+    GROW(rowid); GROW(day); GROW(cents); GROW(type);
+    GROW(category); GROW(account); GROW(member);
+#undef GROW
+    snap.cap = cap;
+    return 1;
+}
+
+// 把 SNAPSHOT_SELECT 的当前行写入下标 i
+static int snapshot_store(long i, sqlite3_stmt* stmt) {
+    sqlite3_int64 day = sqlite3_column_int64(stmt, 1);
+    sqlite3_int64 category = sqlite3_column_int64(stmt, 4);
+    sqlite3_int64 account = sqlite3_column_int64(stmt, 5);
+    sqlite3_int64 member = sqlite3_column_int64(stmt, 6);
+    if (sqlite3_column_type(stmt, 1) == SQLITE_NULL || day < INT32_MIN || day > INT32_MAX
+        || category < 0 || category > UINT16_MAX
+        || account < 0 || account > UINT16_MAX
+        || member < 0 || member > UINT16_MAX) {
+        if (!warned) {
+            fprintf(stderr, "⚠️ 记录 ID=%lld 无法放入快照（日期格式或 id 超出 65535），报表改用汇总表。\n",
+                    sqlite3_column_int64(stmt, 0));
+            warned = 1;
+        }
+        return 0;
+    }
+    const char* type = (const char*)sqlite3_column_text(stmt, 3);
+    snap.rowid[i] = sqlite3_column_int64(stmt, 0);
+    snap.day[i] = (int32_t)day;
+    snap.cents[i] = sqlite3_column_int64(stmt, 2);
+    snap.type[i] = (type && strcmp(type, "income") == 0) ? SNAPSHOT_TYPE_INCOME : SNAPSHOT_TYPE_EXPENSE;
+    snap.category[i] = (uint16_t)category;
+    snap.account[i] = (uint16_t)account;
+    snap.member[i] = (uint16_t)member;
+    return 1;
+}
+
+// 追加 rowid > after 的记录（按 rowid 升序，保持数组有序）
+static int snapshot_append(sqlite3* db, sqlite3_int64 after) {
+    sqlite3_stmt* stmt = db_prepare(db, SNAPSHOT_SELECT "WHERE rowid > ? ORDER BY rowid;");
+    if (!stmt) return 0;
+    sqlite3_bind_int64(stmt, 1, after);
+    int ok = 1;
+    while (ok && sqlite3_step(stmt) == SQLITE_ROW) {
+        ok = snapshot_reserve(snap.count + 1) && snapshot_store(snap.count, stmt);
+        if (ok) snap.count++;
+    }
+    db_release(stmt);
+    return ok;
+}
+
+static long snapshot_find(sqlite3_int64 rowid) {
+    long lo = 0, hi = snap.count - 1;
+    while (lo <= hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (snap.rowid[mid] == rowid) return mid;
+        if (snap.rowid[mid] < rowid) lo = mid + 1; else hi = mid - 1;
+    }
+    return -1;
+}
+
+// 覆盖 updated_at >= since 的记录（走 idx_records_updated_at；须在追加新行之后调用）
+static int snapshot_apply_updates(sqlite3* db, const char* since) {
+    sqlite3_stmt* stmt = db_prepare(db, SNAPSHOT_SELECT "WHERE updated_at >= ?;");
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, since, -1, SQLITE_STATIC);
+    int ok = 1;
+    while (ok && sqlite3_step(stmt) == SQLITE_ROW) {
+        long i = snapshot_find(sqlite3_column_int64(stmt, 0));
+        ok = (i >= 0) && snapshot_store(i, stmt);
+    }
+    db_release(stmt);
+    return ok;
+}
+
+static sqlite3_int64 record_count(sqlite3* db) {
+    int64_t n = rollup_record_count(db);   // 汇总表有效时免扫描
+    if (n >= 0) return n;
+    sqlite3_stmt* stmt = db_prepare(db, "SELECT COUNT(*) FROM records;");
+    if (!stmt) return -1;
+    n = (sqlite3_step(stmt) == SQLITE_ROW) ? sqlite3_column_int64(stmt, 0) : -1;
+    db_release(stmt);
+    return n;
+}
+
+static int data_version(sqlite3* db) {
+    sqlite3_stmt* stmt = db_prepare(db, "PRAGMA data_version;");
+    if (!stmt) return -1;
+    int v = (sqlite3_step(stmt) == SQLITE_ROW) ? sqlite3_column_int(stmt, 0) : -1;
+    db_release(stmt);
+    return v;
+}
+
+static int snapshot_refresh(sqlite3* db) {
+    int changes = sqlite3_total_changes(db);
+    int version = data_version(db);
+    if ((loaded || failed) && changes == seen_changes && version == seen_data_version) return loaded;
+
+    char now[20] = "";
+    sqlite3_stmt* stmt = db_prepare(db, "SELECT datetime('now', 'localtime');");
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+        snprintf(now, sizeof(now), "%s", (const char*)sqlite3_column_text(stmt, 0));
+    }
+    db_release(stmt);
+
+    // 整个刷新在一个读事务里，保证看到的是同一版本
+    int own_txn = sqlite3_get_autocommit(db);
+    if (own_txn) sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    int ok;
+    if (loaded) {
+        sqlite3_int64 max_rowid = snap.count ? snap.rowid[snap.count - 1] : 0;
+        ok = snapshot_append(db, max_rowid) && snapshot_apply_updates(db, watermark);
+        // 快照只增不减：条数对不上说明有删除，整体重载
+        if (ok && record_count(db) != snap.count) {
+            snapshot_reset();
+        }
+    }
+    if (!loaded) {
+        snap.count = 0;
+        long n = (long)record_count(db);
+        ok = snapshot_reserve(n > 0 ? n : 1) && snapshot_append(db, 0);
+    }
+    if (own_txn) sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+
+    seen_changes = changes;
+    seen_data_version = version;
+    if (!ok) {
+        snapshot_reset();
+        failed = 1;
+        return 0;
+    }
+    loaded = 1;
+    memcpy(watermark, now, sizeof(watermark));
+    return 1;
+}
+
+const RecordSnapshot* snapshot_get(void) {
+    sqlite3* db = db_get();
+    if (!db || !snapshot_refresh(db)) return NULL;
+    return &snap;
+}
+
+// === 报表 ===
+// 金额恒大于 0（表约束），因此合计非 0 即该组有记录
+
+int snapshot_period_totals(int yearly, PeriodRowFn fn, void* ctx) {
+    const RecordSnapshot* s = snapshot_get();
+    if (!s) return 0;
+    if (s->count == 0) return 1;
+
+    int32_t min_day, max_day;
+    agg_day_range(s->day, s->count, &min_day, &max_day);
+
+    // 天数 -> 桶号（月份或年份，从 0 起）查表，主循环里不做日期运算
+    Date lo, hi;
+    date_from_days(min_day, &lo);
+    date_from_days(max_day, &hi);
+    int min_y = lo.year, min_m = lo.month, max_y = hi.year, max_m = hi.month;
+    int buckets = yearly ? max_y - min_y + 1 : (max_y - min_y) * 12 + max_m - min_m + 1;
+    long span = (long)max_day - min_day + 1;
+    int32_t* bucket_of = malloc(sizeof(int32_t) * span);
+    int64_t* sums = calloc((size_t)buckets * 2, sizeof(int64_t));   // [桶][类型]
+    if (!bucket_of || !sums) {
+        free(bucket_of);
+        free(sums);
+        return 0;
+    }
+    for (long d = 0; d < span; d++) {
+        Date cur;
+        date_from_days(min_day + (int32_t)d, &cur);
+        bucket_of[d] = yearly ? cur.year - min_y : (cur.year - min_y) * 12 + cur.month - min_m;
+    }
+
+    agg_sum_by_day_bucket(s->day, s->cents, s->type, s->count, min_day, bucket_of, sums);
+
+    char label[16];
+    for (int b = buckets - 1; b >= 0; b--) {
+        int64_t income = sums[b * 2 + SNAPSHOT_TYPE_INCOME];
+        int64_t expense = sums[b * 2 + SNAPSHOT_TYPE_EXPENSE];
+        if (income == 0 && expense == 0) continue;
+        if (yearly) {
+            snprintf(label, sizeof(label), "%04d", min_y + b);
+        } else {
+            int k = min_m - 1 + b;
+            snprintf(label, sizeof(label), "%04d-%02d", min_y + k / 12, k % 12 + 1);
+        }
+        fn(ctx, label, income, expense);
+    }
+    free(bucket_of);
+    free(sums);
+    return 1;
+}
+
+int snapshot_category_totals(const char* type, CategorySumFn fn, void* ctx) {
+    const RecordSnapshot* s = snapshot_get();
+    if (!s) return 0;
+
+    uint8_t want = strcmp(type, "income") == 0 ? SNAPSHOT_TYPE_INCOME : SNAPSHOT_TYPE_EXPENSE;
+    int64_t* sums = calloc((size_t)(UINT16_MAX + 1) * 2, sizeof(int64_t));   // [分类][类型]
+    if (!sums) return 0;
+
+    agg_sum_by_key16(s->category, s->cents, s->type, s->count, sums);
+    for (int c = 0; c <= UINT16_MAX; c++) {
+        if (sums[c * 2 + want] != 0) fn(ctx, c, sums[c * 2 + want]);
+    }
+    free(sums);
+    return 1;
+}
@@ -0,0 +1,43 @@
+// snapshot.h
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "finance.h"
+
+// 报表引擎（app_settings 'report_engine'）
+#define REPORT_ENGINE_ROLLUP   0   // 触发器维护的汇总表（默认）
+#define REPORT_ENGINE_SNAPSHOT 1   // 内存列式快照
+#define REPORT_ENGINE_PARALLEL 2   // 多线程分段扫描 records（parallel.h）
+#define REPORT_ENGINE_COUNT    3
+
+const char* report_engine_name(int engine);
+int report_engine_current(void);
+int report_engine_set(int engine);
+
+#define SNAPSHOT_TYPE_EXPENSE 0
+#define SNAPSHOT_TYPE_INCOME  1
+
+// records 的内存列式快照（struct-of-arrays，按 rowid 升序），报表在 C 中直接扫描数组。
+// 通过 rowid（新增）与 updated_at（修改）增量刷新，记录数变少（有删除）时整体重载。
+typedef struct {
+    int64_t* rowid;
+    int32_t* day;           // 1970-01-01 起的天数
+    int64_t* cents;
+    uint8_t* type;          // SNAPSHOT_TYPE_*
+    uint16_t* category;
+    uint16_t* account;
+    uint16_t* member;       // 0 表示无成员
+    long count;
+    long cap;
+} RecordSnapshot;
+
+// 刷新并返回快照；id 超出 uint16 或日期无法解析时返回 NULL（调用方改用汇总表）
+const RecordSnapshot* snapshot_get(void);
+void snapshot_reset(void);
+
+typedef void (*CategorySumFn)(void* ctx, int category_id, int64_t total);
+int snapshot_period_totals(int yearly, PeriodRowFn fn, void* ctx);
+int snapshot_category_totals(const char* type, CategorySumFn fn, void* ctx);
+
+#endif
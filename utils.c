@@ -6,9 +6,11 @@
 
 #ifdef _WIN32
     #include <conio.h>
+    #include <windows.h>
 #else
     #include <termios.h>
     #include <unistd.h>
+    #include <time.h>
 #endif
 
 // 清屏函数
@@ -20,6 +22,20 @@ void clear_screen(void) {
 #endif
 }
 
+// 单调时钟（毫秒），用于计时/基准测试
+double now_ms(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#endif
+}
+
 // 模拟 _getch（仅非 Windows）
 #ifndef _WIN32
 static int _getch(void) {
@@ -46,42 +62,6 @@ void press_any_key_to_continue(void) {
     printf("\n");
 }
 
-// CSV 转义函数：处理逗号、双引号、换行
-void csv_escape(const char* input, char* output, size_t out_size) {
-    if (!input || input[0] == '\0') {
-        output[0] = '\0';
-        return;
-    }
-
-    size_t len = strlen(input);
-    size_t j = 0;
-    int needs_quotes = 0;
-
-    for (size_t i = 0; i < len && j + 2 < out_size - 1; i++) {
-        if (input[i] == '"' || input[i] == ',' || input[i] == '\n' || input[i] == '\r') {
-            needs_quotes = 1;
-            break;
-        }
-    }
-
-    if (needs_quotes) {
-        output[j++] = '"';
-        for (size_t i = 0; i < len && j < out_size - 2; i++) {
-            if (input[i] == '"') {
-                if (j + 2 >= out_size) break;
-                output[j++] = '"';
-                output[j++] = '"';
-            } else {
-                output[j++] = input[i];
-            }
-        }
-        if (j < out_size - 1) output[j++] = '"';
-    } else {
-        strncpy(output, input, out_size - 1);
-        output[out_size - 1] = '\0';
-    }
-}
-
 //任意步骤取消函数
 bool input_with_cancel(
     const char* prompt,
@@ -4,6 +4,6 @@
 
 void clear_screen(void);
 void press_any_key_to_continue(void);
-void csv_escape(const char* input, char* output, size_t out_size);
+double now_ms(void);
 
 #endif
\ No newline at end of file